@@ -53,13 +53,12 @@ uint64 FileStream::attributes(void)
 
 uint8 *FileStream::map(void)
 {
- //return fw.map();
- return(NULL);
+ return fw.map();
 }
 
 void FileStream::unmap(void)
 {
- //fw.unmap();
+ fw.unmap();
 }
 
 
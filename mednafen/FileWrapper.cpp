@@ -26,6 +26,10 @@
 #include <unistd.h>
 #include <string.h>
 
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+
 // Some really bad preprocessor abuse follows to handle platforms that don't have fseeko and ftello...and of course
 // for largefile support on Windows:
 
@@ -96,7 +100,7 @@ FileWrapper::FileWrapper(FileWrapper &original) : OpenedMode(original.OpenedMode
 }
 #endif
 
-FileWrapper::FileWrapper(const char *path, const int mode, const char *purpose) : OpenedMode(mode)
+FileWrapper::FileWrapper(const char *path, const int mode, const char *purpose) : OpenedMode(mode), mapping(NULL), mapping_size(0)
 {
  path_save = std::string(path);
 
@@ -156,6 +160,8 @@ FileWrapper::~FileWrapper()
 
 void FileWrapper::close(void)
 {
+ unmap();
+
  if(fp)
  {
   FILE *tmp = fp;
@@ -307,6 +313,41 @@ void FileWrapper::seek(int64 offset, int whence)
  }
 }
 
+uint8 *FileWrapper::map(void)
+{
+ #ifdef HAVE_MMAP
+ if(!mapping && fp && OpenedMode == MODE_READ)
+ {
+  struct stat buf;
+
+  if(fstat(fileno(fp), &buf) == -1 || buf.st_size <= 0 || (uint64)buf.st_size != (size_t)buf.st_size)
+   return(NULL);
+
+  void *tmp = mmap(NULL, buf.st_size, PROT_READ, MAP_SHARED, fileno(fp), 0);
+
+  if(tmp == MAP_FAILED)
+   return(NULL);
+
+  mapping = (uint8 *)tmp;
+  mapping_size = buf.st_size;
+ }
+ #endif
+
+ return(mapping);
+}
+
+void FileWrapper::unmap(void)
+{
+ #ifdef HAVE_MMAP
+ if(mapping)
+ {
+  munmap(mapping, mapping_size);
+  mapping = NULL;
+  mapping_size = 0;
+ }
+ #endif
+}
+
 int64 FileWrapper::size(void)
 {
  struct stat buf;
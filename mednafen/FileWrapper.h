@@ -61,6 +61,9 @@ class FileWrapper
  void flush(void);
  //void flushsync(void);	// TODO: see fflush and fsync
 
+ uint8 *map(void);	// Returns NULL if the file can't be mapped(or mmap() isn't available); see Stream::map().
+ void unmap(void);
+
  void close(void);	// Flushes and closes the underlying OS/C lib file.  Calling any other method of this class after a call to
 			// this method is illegal(except for the implicit call to the destructor).
 			//
@@ -78,6 +81,9 @@ class FileWrapper
  FILE *fp;
  std::string path_save;
  const int OpenedMode;
+
+ uint8 *mapping;
+ uint64 mapping_size;
 };
 
 #endif
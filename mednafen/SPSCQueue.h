@@ -0,0 +1,215 @@
+#ifndef __MDFN_SPSCQUEUE_H
+#define __MDFN_SPSCQUEUE_H
+
+//
+// Bounded single-producer/single-consumer ring for passing work between exactly two threads.
+//
+// The fast paths(CanRead(), CanWrite(), WritePtr()/WriteCommit(), ReadPtr()/ReadCommit()) are lock-free; the mutex and condition
+// variables are only touched when one side has actually parked itself waiting on the other.
+//
+// The consumer should only call ReadCommit() after it has completely finished with the unit, so that WaitEmpty() on the producer
+// side can be used as a fence("everything I've submitted so far has been processed").
+//
+
+#include <vector>
+#include <assert.h>
+
+#include "mednafen.h"
+
+#if !defined(__GNUC__)
+ #error "SPSCQueue requires GCC-compatible __atomic builtins."
+#endif
+
+template<typename T>
+class SPSCQueue
+{
+ public:
+
+ SPSCQueue(uint32 the_size) // Size should be a power of 2!
+ {
+  data.resize(round_up_pow2(the_size));
+  size_mask = data.size() - 1;
+  read_pos = 0;
+  write_pos = 0;
+
+  consumer_parked = 0;
+  producer_parked = 0;
+
+  mutex = MDFND_CreateMutex();
+  data_cond = NULL;
+  space_cond = NULL;
+
+  if(mutex)
+  {
+   data_cond = MDFND_CreateCond();
+   space_cond = MDFND_CreateCond();
+  }
+ }
+
+ ~SPSCQueue()
+ {
+  if(space_cond)
+   MDFND_DestroyCond(space_cond);
+
+  if(data_cond)
+   MDFND_DestroyCond(data_cond);
+
+  if(mutex)
+   MDFND_DestroyMutex(mutex);
+ }
+
+ //
+ // Producer side.
+ //
+ INLINE uint32 CanWrite(void)
+ {
+  return(data.size() - (write_pos - __atomic_load_n(&read_pos, __ATOMIC_ACQUIRE)));
+ }
+
+ // Only valid when CanWrite() != 0.
+ INLINE T* WritePtr(void)
+ {
+  return(&data[write_pos & size_mask]);
+ }
+
+ INLINE void WriteCommit(void)
+ {
+  __atomic_store_n(&write_pos, write_pos + 1, __ATOMIC_RELEASE);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  if(__atomic_load_n(&consumer_parked, __ATOMIC_RELAXED))
+   Wake(data_cond);
+ }
+
+ INLINE void Write(const T& wr_data)
+ {
+  if(MDFN_UNLIKELY(!CanWrite()))
+   WaitCanWrite();
+
+  *WritePtr() = wr_data;
+  WriteCommit();
+ }
+
+ void WaitCanWrite(void)
+ {
+  Park(&producer_parked, space_cond, &SPSCQueue::CanWrite);
+ }
+
+ // Waits until the consumer has ReadCommit()'d everything written so far.
+ void WaitEmpty(void)
+ {
+  Park(&producer_parked, space_cond, &SPSCQueue::IsEmpty);
+ }
+
+ INLINE bool IsEmpty(void)
+ {
+  return(__atomic_load_n(&read_pos, __ATOMIC_ACQUIRE) == __atomic_load_n(&write_pos, __ATOMIC_ACQUIRE));
+ }
+
+ //
+ // Consumer side.
+ //
+ INLINE uint32 CanRead(void)
+ {
+  return(__atomic_load_n(&write_pos, __ATOMIC_ACQUIRE) - read_pos);
+ }
+
+ // Only valid when CanRead() != 0.
+ INLINE T* ReadPtr(void)
+ {
+  return(&data[read_pos & size_mask]);
+ }
+
+ INLINE void ReadCommit(void)
+ {
+  __atomic_store_n(&read_pos, read_pos + 1, __ATOMIC_RELEASE);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  if(__atomic_load_n(&producer_parked, __ATOMIC_RELAXED))
+   Wake(space_cond);
+ }
+
+ // Returns false if nothing was read; always returns true if "blocking" is set.
+ INLINE bool Read(T* message, bool blocking = true)
+ {
+  if(!CanRead())
+  {
+   if(!blocking)
+    return(false);
+
+   WaitCanRead();
+  }
+
+  *message = *ReadPtr();
+  ReadCommit();
+
+  return(true);
+ }
+
+ void WaitCanRead(void)
+ {
+  Park(&consumer_parked, data_cond, &SPSCQueue::CanReadBool);
+ }
+
+ private:
+
+ INLINE bool CanReadBool(void)
+ {
+  return(CanRead() != 0);
+ }
+
+ template<typename PT>
+ void Park(volatile uint32 *parked, MDFN_Cond *cond, PT pred)
+ {
+  // Spin briefly first; the other side is usually only a few microseconds away from satisfying us.
+  for(unsigned i = 0; i < 256; i++)
+  {
+   if((this->*pred)())
+    return;
+  }
+
+  if(!cond)
+  {
+   while(!(this->*pred)())
+    MDFND_Sleep(1);
+
+   return;
+  }
+
+  MDFND_LockMutex(mutex);
+  __atomic_store_n(parked, 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  while(!(this->*pred)())
+   MDFND_WaitCond(cond, mutex);
+
+  __atomic_store_n(parked, 0, __ATOMIC_RELAXED);
+  MDFND_UnlockMutex(mutex);
+ }
+
+ void Wake(MDFN_Cond *cond)
+ {
+  if(!cond)
+   return;
+
+  MDFND_LockMutex(mutex);
+  MDFND_SignalCond(cond);
+  MDFND_UnlockMutex(mutex);
+ }
+
+ std::vector<T> data;
+ uint32 size_mask;
+
+ // Free-running counters; only the low bits(size_mask) index into data[].
+ uint32 read_pos;	// Written by the consumer only.
+ uint32 write_pos;	// Written by the producer only.
+
+ volatile uint32 consumer_parked;
+ volatile uint32 producer_parked;
+
+ MDFN_Mutex *mutex;
+ MDFN_Cond *data_cond;
+ MDFN_Cond *space_cond;
+};
+
+#endif
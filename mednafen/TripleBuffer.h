@@ -0,0 +1,107 @@
+#ifndef __MDFN_TRIPLEBUFFER_H
+#define __MDFN_TRIPLEBUFFER_H
+
+//
+// Lock-free triple-buffer index exchange between exactly two threads: a producer that fills frames and a consumer that displays them.
+//
+// The caller owns three buffers, indexed 0 through 2.  At any time the producer owns BackIndex(), the consumer owns FrontIndex(), and the
+// third is parked in between.  Publish() swaps the producer's back buffer with the parked one, and never waits; if the consumer never got
+// to the frame that was parked, it's simply replaced.  Acquire() swaps the consumer's front buffer with the parked one only if the parked
+// one holds a frame the consumer hasn't seen yet, so the consumer always ends up with the newest complete frame.
+//
+// Publish() can attach flags(low bits, see FlagsMask) to a frame; flags on a frame that's replaced before the consumer sees it carry over
+// to the frame that replaced it, so a one-shot request(e.g. "take a screenshot of this") isn't lost along with the frame.
+//
+
+#include "mednafen.h"
+
+#if !defined(__GNUC__)
+ #error "TripleBuffer requires GCC-compatible __atomic builtins."
+#endif
+
+class TripleBuffer
+{
+ public:
+
+ enum { FlagsMask = 0xFFF0 };
+
+ TripleBuffer()
+ {
+  Reset();
+ }
+
+ // Not thread-safe; only call while neither side is active.
+ void Reset(void)
+ {
+  back = 0;
+  middle = 1;
+  front = 2;
+ }
+
+ //
+ // Producer side.
+ //
+ INLINE unsigned BackIndex(void) const
+ {
+  return(back);
+ }
+
+ // Returns true if the previously-published frame was replaced without the consumer having acquired it.
+ INLINE bool Publish(uint32 flags = 0)
+ {
+  uint32 old_middle = __atomic_load_n(&middle, __ATOMIC_RELAXED);
+  uint32 new_middle;
+
+  do
+  {
+   new_middle = back | Fresh | (flags & FlagsMask);
+
+   if(old_middle & Fresh)
+    new_middle |= old_middle & FlagsMask;
+  } while(!__atomic_compare_exchange_n(&middle, &old_middle, new_middle, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+  back = old_middle & IndexMask;
+
+  return((bool)(old_middle & Fresh));
+ }
+
+ //
+ // Consumer side.
+ //
+ INLINE unsigned FrontIndex(void) const
+ {
+  return(front);
+ }
+
+ INLINE bool HasFresh(void) const
+ {
+  return((bool)(__atomic_load_n(&middle, __ATOMIC_ACQUIRE) & Fresh));
+ }
+
+ // Returns true, and the new frame's flags in "*flags" if "flags" is non-NULL, if a new frame was acquired.
+ INLINE bool Acquire(uint32 *flags = NULL)
+ {
+  uint32 old_middle;
+
+  if(!HasFresh())
+   return(false);
+
+  old_middle = __atomic_exchange_n(&middle, front, __ATOMIC_ACQ_REL);
+  front = old_middle & IndexMask;
+
+  if(flags)
+   *flags = old_middle & FlagsMask;
+
+  return(true);
+ }
+
+ private:
+
+ enum { IndexMask = 0x3, Fresh = 0x4 };
+
+ uint32 back;		// Producer only.
+ uint32 middle;		// Shared; buffer index | Fresh | flags.
+ uint32 front;		// Consumer only.
+};
+
+#endif
@@ -19,6 +19,7 @@
 #include "CDAccess.h"
 #include "CDAccess_Image.h"
 #include "CDAccess_CCD.h"
+#include "CDAccess_HCD.h"
 
 #ifdef HAVE_LIBCDIO
 #include "CDAccess_Physical.h"
@@ -36,12 +37,26 @@ CDAccess::~CDAccess()
 
 }
 
+void CDAccess::HintReadSector(int32 lba, int32 count)
+{
+
+}
+
+bool CDAccess::Read_Raw_Sector_NoECC(uint8 *buf, int32 lba)
+{
+ Read_Raw_Sector(buf, lba);
+
+ return(false);
+}
+
 CDAccess *cdaccess_open_image(const char *path, bool image_memcache)
 {
  CDAccess *ret = NULL;
 
  if(strlen(path) >= 4 && !strcasecmp(path + strlen(path) - 4, ".ccd"))
   ret = new CDAccess_CCD(path, image_memcache);
+ else if(strlen(path) >= 4 && !strcasecmp(path + strlen(path) - 4, ".hcd"))
+  ret = new CDAccess_HCD(path, image_memcache);
  else
   ret = new CDAccess_Image(path, image_memcache);
 
@@ -14,6 +14,14 @@ class CDAccess
 
  virtual void Read_Raw_Sector(uint8 *buf, int32 lba) = 0;
 
+ // Same as Read_Raw_Sector(), except that an implementation may skip synthesizing the P/Q parity of a Mode 1 sector(leaving it zeroed), in which
+ // case it returns true and CDUtility::encode_mode1_ecc() must be called on the sector before those bytes are used.
+ // The default implementation calls Read_Raw_Sector() and returns false.
+ virtual bool Read_Raw_Sector_NoECC(uint8 *buf, int32 lba);
+
+ // Hint that sectors [lba, lba + count) will probably be read soon.  Must not block; the default implementation is a nop.
+ virtual void HintReadSector(int32 lba, int32 count);
+
  virtual void Read_TOC(CDUtility::TOC *toc) = 0;
 
  virtual bool Is_Physical(void) throw() = 0;
@@ -0,0 +1,447 @@
+/* Mednafen - Multi-system Emulator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "../mednafen.h"
+#include "../FileStream.h"
+#include "../MemoryStream.h"
+#include "CDAccess_HCD.h"
+
+#include <unistd.h>
+#include <zlib.h>
+
+using namespace CDUtility;
+
+static const uint8 HCD_Magic[8] = { 'M', 'D', 'F', 'N', 'H', 'C', 'D', 0x1A };
+
+enum { HCD_VERSION = 1 };
+enum { HCD_HEADER_SIZE = 8 + 4 + 4 + 4 + 8 + 4 + 101 * 6 };
+enum { HCD_INDEX_ENTRY_SIZE = 8 + 4 + 4 + 1 };
+
+enum { HCD_SECTOR_SIZE = 2352 + 96 };
+
+// Sectors per hunk written by HCD_Convert().  The reader accepts any value up to HCD_MAX_HUNK_SECTORS.
+enum { HCD_DEFAULT_HUNK_SECTORS = 8 };
+enum { HCD_MAX_HUNK_SECTORS = 256 };
+
+enum
+{
+ HCD_CODEC_NONE = 0,
+ HCD_CODEC_ZLIB = 1,
+};
+
+CDAccess_HCD::CDAccess_HCD(const char *path, bool image_memcache) : img_stream(NULL), hunk_sectors(0), num_sectors(0), hunk_cache_counter(0)
+{
+ for(unsigned i = 0; i < HunkCacheSize; i++)
+ {
+  hunk_cache[i].hunk = ~0U;
+  hunk_cache[i].last_use = 0;
+ }
+
+ try
+ {
+  if(image_memcache)
+   img_stream = new MemoryStream(new FileStream(path, FileStream::MODE_READ));
+  else
+   img_stream = new FileStream(path, FileStream::MODE_READ);
+
+  Load();
+ }
+ catch(...)
+ {
+  Cleanup();
+  throw;
+ }
+}
+
+CDAccess_HCD::CDAccess_HCD(Stream *stream) : img_stream(stream), hunk_sectors(0), num_sectors(0), hunk_cache_counter(0)
+{
+ for(unsigned i = 0; i < HunkCacheSize; i++)
+ {
+  hunk_cache[i].hunk = ~0U;
+  hunk_cache[i].last_use = 0;
+ }
+
+ try
+ {
+  img_stream->seek(0, SEEK_SET);
+  Load();
+ }
+ catch(...)
+ {
+  Cleanup();
+  throw;
+ }
+}
+
+void CDAccess_HCD::Load(void)
+{
+ uint8 magic[8];
+ uint32 version;
+ uint64 index_offset;
+ int64 file_size;
+
+ file_size = img_stream->size();
+
+ img_stream->read(magic, sizeof(magic));
+
+ if(memcmp(magic, HCD_Magic, sizeof(HCD_Magic)))
+  throw MDFN_Error(0, _("Not an HCD image."));
+
+ version = img_stream->get_LE<uint32>();
+
+ if(version != HCD_VERSION)
+  throw MDFN_Error(0, _("Unsupported HCD image version %u."), version);
+
+ hunk_sectors = img_stream->get_LE<uint32>();
+ num_sectors = img_stream->get_LE<uint32>();
+ index_offset = img_stream->get_LE<uint64>();
+
+ if(hunk_sectors < 1 || hunk_sectors > HCD_MAX_HUNK_SECTORS)
+  throw MDFN_Error(0, _("HCD sectors per hunk value of %u is invalid."), hunk_sectors);
+
+ //
+ // TOC
+ //
+ tocd.Clear();
+ tocd.first_track = img_stream->get_u8();
+ tocd.last_track = img_stream->get_u8();
+ tocd.disc_type = img_stream->get_u8();
+ img_stream->get_u8();
+
+ for(unsigned i = 0; i < 101; i++)
+ {
+  tocd.tracks[i].adr = img_stream->get_u8();
+  tocd.tracks[i].control = img_stream->get_u8();
+  tocd.tracks[i].lba = img_stream->get_LE<uint32>();
+ }
+
+ if(tocd.first_track < 1 || tocd.last_track > 99 || tocd.first_track > tocd.last_track)
+  throw MDFN_Error(0, _("HCD TOC first(%d)/last(%d) track numbers bad."), tocd.first_track, tocd.last_track);
+
+ if(tocd.tracks[100].lba != num_sectors)
+  throw MDFN_Error(0, _("HCD TOC leadout LBA(%u) doesn't match the number of sectors(%u)."), tocd.tracks[100].lba, num_sectors);
+
+ //
+ // Hunk index
+ //
+ const uint32 num_hunks = (num_sectors + hunk_sectors - 1) / hunk_sectors;
+ const uLong max_comp_size = compressBound(hunk_sectors * HCD_SECTOR_SIZE);
+
+ if(index_offset < HCD_HEADER_SIZE || (int64)index_offset > file_size || (uint64)(file_size - index_offset) < (uint64)num_hunks * HCD_INDEX_ENTRY_SIZE)
+  throw MDFN_Error(0, _("HCD hunk index is truncated or its offset is invalid."));
+
+ hunk_index.resize(num_hunks);
+ img_stream->seek(index_offset, SEEK_SET);
+
+ for(uint32 i = 0; i < num_hunks; i++)
+ {
+  HunkIndexEntry *e = &hunk_index[i];
+
+  e->offset = img_stream->get_LE<uint64>();
+  e->comp_size = img_stream->get_LE<uint32>();
+  e->crc = img_stream->get_LE<uint32>();
+  e->codec = img_stream->get_u8();
+
+  if(e->codec != HCD_CODEC_NONE && e->codec != HCD_CODEC_ZLIB)
+   throw MDFN_Error(0, _("HCD hunk %u uses unknown codec %u."), i, e->codec);
+
+  if(e->comp_size > max_comp_size || e->offset < HCD_HEADER_SIZE || e->offset > index_offset || (index_offset - e->offset) < e->comp_size)
+   throw MDFN_Error(0, _("HCD hunk %u index entry is invalid."), i);
+ }
+
+ comp_buf.resize(max_comp_size);
+
+ for(unsigned i = 0; i < HunkCacheSize; i++)
+  hunk_cache[i].data.resize(hunk_sectors * HCD_SECTOR_SIZE);
+}
+
+void CDAccess_HCD::Cleanup(void)
+{
+ if(img_stream)
+ {
+  delete img_stream;
+  img_stream = NULL;
+ }
+}
+
+CDAccess_HCD::~CDAccess_HCD()
+{
+ Cleanup();
+}
+
+const uint8 *CDAccess_HCD::GetHunk(uint32 hunk)
+{
+ HunkCacheEntry *victim = &hunk_cache[0];
+
+ hunk_cache_counter++;
+
+ for(unsigned i = 0; i < HunkCacheSize; i++)
+ {
+  HunkCacheEntry *ce = &hunk_cache[i];
+
+  if(ce->hunk == hunk)
+  {
+   ce->last_use = hunk_cache_counter;
+   return &ce->data[0];
+  }
+
+  if((hunk_cache_counter - ce->last_use) > (hunk_cache_counter - victim->last_use))
+   victim = ce;
+ }
+
+ //
+ // Not cached, decompress it into the least-recently-used entry.
+ //
+ const HunkIndexEntry *e = &hunk_index[hunk];
+ const uint32 first_sector = hunk * hunk_sectors;
+ const uLong hunk_size = std::min<uint32>(hunk_sectors, num_sectors - first_sector) * HCD_SECTOR_SIZE;
+ uLong out_size = hunk_size;
+
+ victim->hunk = ~0U;
+
+ img_stream->seek(e->offset, SEEK_SET);
+
+ if(e->codec == HCD_CODEC_NONE)
+ {
+  if(e->comp_size != hunk_size)
+   throw MDFN_Error(0, _("HCD hunk %u has the wrong size."), hunk);
+
+  img_stream->read(&victim->data[0], hunk_size);
+ }
+ else
+ {
+  img_stream->read(&comp_buf[0], e->comp_size);
+
+  if(uncompress(&victim->data[0], &out_size, &comp_buf[0], e->comp_size) != Z_OK || out_size != hunk_size)
+   throw MDFN_Error(0, _("Error decompressing HCD hunk %u."), hunk);
+ }
+
+ if(crc32(0, &victim->data[0], hunk_size) != e->crc)
+  throw MDFN_Error(0, _("HCD hunk %u failed CRC check."), hunk);
+
+ victim->hunk = hunk;
+ victim->last_use = hunk_cache_counter;
+
+ return &victim->data[0];
+}
+
+void CDAccess_HCD::Read_Raw_Sector(uint8 *buf, int32 lba)
+{
+ if(lba < 0 || (uint32)lba >= num_sectors)
+  throw(MDFN_Error(0, _("LBA out of range.")));
+
+ const uint32 hunk = (uint32)lba / hunk_sectors;
+ const uint32 hunk_pos = (uint32)lba % hunk_sectors;
+ const uint32 hunk_count = std::min<uint32>(hunk_sectors, num_sectors - hunk * hunk_sectors);
+ const uint8 *hd = GetHunk(hunk);
+
+ memcpy(buf, hd + hunk_pos * 2352, 2352);
+ subpw_interleave(hd + hunk_count * 2352 + hunk_pos * 96, buf + 2352);
+}
+
+void CDAccess_HCD::Read_TOC(CDUtility::TOC *toc)
+{
+ *toc = tocd;
+}
+
+bool CDAccess_HCD::Is_Physical(void) throw()
+{
+ return false;
+}
+
+void CDAccess_HCD::Eject(bool eject_status)
+{
+
+}
+
+//
+// Conversion
+//
+uint64 HCD_Write(CDAccess *src, Stream *out)
+{
+ const uint32 hunk_sectors = HCD_DEFAULT_HUNK_SECTORS;
+ TOC toc;
+ uint32 num_sectors;
+ uint32 num_hunks;
+ std::vector<uint8> hunk_buf;
+ std::vector<uint8> comp_buf;
+ std::vector<uint64> hunk_offsets;
+ std::vector<uint32> hunk_comp_sizes;
+ std::vector<uint32> hunk_crcs;
+ std::vector<uint8> hunk_codecs;
+ uint64 index_offset;
+
+ src->Read_TOC(&toc);
+
+ num_sectors = toc.tracks[100].lba;
+ num_hunks = (num_sectors + hunk_sectors - 1) / hunk_sectors;
+
+ hunk_buf.resize(hunk_sectors * HCD_SECTOR_SIZE);
+ comp_buf.resize(compressBound(hunk_sectors * HCD_SECTOR_SIZE));
+
+ //
+ // Header; the index offset is filled in at the end.
+ //
+ out->write(HCD_Magic, sizeof(HCD_Magic));
+ out->put_LE<uint32>(HCD_VERSION);
+ out->put_LE<uint32>(hunk_sectors);
+ out->put_LE<uint32>(num_sectors);
+ out->put_LE<uint64>(0);
+
+ out->put_u8(toc.first_track);
+ out->put_u8(toc.last_track);
+ out->put_u8(toc.disc_type);
+ out->put_u8(0);
+
+ for(unsigned i = 0; i < 101; i++)
+ {
+  out->put_u8(toc.tracks[i].adr);
+  out->put_u8(toc.tracks[i].control);
+  out->put_LE<uint32>(toc.tracks[i].lba);
+ }
+
+ //
+ // Hunks
+ //
+ for(uint32 hunk = 0; hunk < num_hunks; hunk++)
+ {
+  const uint32 first_sector = hunk * hunk_sectors;
+  const uint32 hunk_count = std::min<uint32>(hunk_sectors, num_sectors - first_sector);
+  const uLong hunk_size = hunk_count * HCD_SECTOR_SIZE;
+  uLong comp_size = comp_buf.size();
+
+  for(uint32 i = 0; i < hunk_count; i++)
+  {
+   uint8 sector_buf[2352 + 96];
+
+   src->Read_Raw_Sector(sector_buf, first_sector + i);
+
+   memcpy(&hunk_buf[i * 2352], sector_buf, 2352);
+   subpw_deinterleave(sector_buf + 2352, &hunk_buf[hunk_count * 2352 + i * 96]);
+  }
+
+  hunk_offsets.push_back(out->tell());
+  hunk_crcs.push_back(crc32(0, &hunk_buf[0], hunk_size));
+
+  if(compress2(&comp_buf[0], &comp_size, &hunk_buf[0], hunk_size, Z_BEST_COMPRESSION) == Z_OK && comp_size < hunk_size)
+  {
+   out->write(&comp_buf[0], comp_size);
+   hunk_comp_sizes.push_back(comp_size);
+   hunk_codecs.push_back(HCD_CODEC_ZLIB);
+  }
+  else
+  {
+   out->write(&hunk_buf[0], hunk_size);
+   hunk_comp_sizes.push_back(hunk_size);
+   hunk_codecs.push_back(HCD_CODEC_NONE);
+  }
+ }
+
+ //
+ // Index
+ //
+ index_offset = out->tell();
+
+ for(uint32 hunk = 0; hunk < num_hunks; hunk++)
+ {
+  out->put_LE<uint64>(hunk_offsets[hunk]);
+  out->put_LE<uint32>(hunk_comp_sizes[hunk]);
+  out->put_LE<uint32>(hunk_crcs[hunk]);
+  out->put_u8(hunk_codecs[hunk]);
+ }
+
+ const uint64 ret = out->tell();
+
+ out->seek(8 + 4 + 4 + 4, SEEK_SET);
+ out->put_LE<uint64>(index_offset);
+
+ return ret;
+}
+
+static void VerifyHCD(CDAccess *src, const char *path)
+{
+ CDAccess_HCD hcd(path, false);
+ TOC src_toc, hcd_toc;
+
+ src->Read_TOC(&src_toc);
+ hcd.Read_TOC(&hcd_toc);
+
+ if(src_toc.first_track != hcd_toc.first_track || src_toc.last_track != hcd_toc.last_track || src_toc.disc_type != hcd_toc.disc_type)
+  throw MDFN_Error(0, _("HCD verification failed: TOC mismatch."));
+
+ for(unsigned i = 0; i < 101; i++)
+ {
+  if(src_toc.tracks[i].adr != hcd_toc.tracks[i].adr || src_toc.tracks[i].control != hcd_toc.tracks[i].control || src_toc.tracks[i].lba != hcd_toc.tracks[i].lba)
+   throw MDFN_Error(0, _("HCD verification failed: TOC track %u mismatch."), i);
+ }
+
+ for(uint32 lba = 0; lba < src_toc.tracks[100].lba; lba++)
+ {
+  uint8 src_buf[2352 + 96];
+  uint8 hcd_buf[2352 + 96];
+
+  src->Read_Raw_Sector(src_buf, lba);
+  hcd.Read_Raw_Sector(hcd_buf, lba);
+
+  if(memcmp(src_buf, hcd_buf, 2352))
+   throw MDFN_Error(0, _("HCD verification failed: sector %u data mismatch."), lba);
+
+  if(memcmp(src_buf + 2352, hcd_buf + 2352, 96))
+   throw MDFN_Error(0, _("HCD verification failed: sector %u subchannel data mismatch."), lba);
+ }
+}
+
+void HCD_Convert(const char *src_path, const char *dest_path)
+{
+ CDAccess *src = cdaccess_open_image(src_path, false);
+
+ try
+ {
+  FileStream out(dest_path, FileStream::MODE_WRITE_SAFE);
+  uint64 out_size;
+
+  // From here on, a failure should remove the partially-written(or unverifiable) output file.
+  try
+  {
+   out_size = HCD_Write(src, &out);
+   out.close();
+
+   VerifyHCD(src, dest_path);
+  }
+  catch(...)
+  {
+   try { out.close(); } catch(...) { }
+   unlink(dest_path);
+   throw;
+  }
+
+  {
+   TOC toc;
+
+   src->Read_TOC(&toc);
+
+   MDFN_printf(_("Converted %u sectors: %llu bytes -> %llu bytes\n"), toc.tracks[100].lba, (unsigned long long)toc.tracks[100].lba * (2352 + 96), (unsigned long long)out_size);
+  }
+ }
+ catch(...)
+ {
+  delete src;
+  throw;
+ }
+
+ delete src;
+}
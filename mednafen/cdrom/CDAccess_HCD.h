@@ -0,0 +1,111 @@
+/* Mednafen - Multi-system Emulator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __MDFN_CDACCESS_HCD_H
+#define __MDFN_CDACCESS_HCD_H
+
+#include "../Stream.h"
+#include "CDAccess.h"
+
+#include <vector>
+
+//
+// "Hunked compressed disc" image: raw sectors(2352 bytes + 96 bytes of subchannel data) from LBA 0 up to the leadout, grouped into
+// fixed-size hunks that are each compressed independently, plus a per-hunk index so any sector can be reached with a single seek.
+//
+// Layout(all integers little-endian):
+//  Header:
+//   8 bytes	"MDFNHCD\x1A"
+//   uint32	Format version(HCD_VERSION)
+//   uint32	Sectors per hunk
+//   uint32	Total number of sectors(== leadout LBA)
+//   uint64	File offset of the hunk index
+//   uint8	TOC first track, TOC last track, disc type, reserved
+//   101 * { uint8 adr, uint8 control, uint32 lba }	TOC tracks 0 through 100(leadout)
+//
+//  Hunk data.
+//
+//  Hunk index, one entry per hunk:
+//   uint64	File offset of the hunk data
+//   uint32	Compressed size
+//   uint32	CRC32 of the uncompressed hunk
+//   uint8	Codec(HCD_CODEC_*)
+//
+// Within an uncompressed hunk, the 2352-byte main channel data of every sector comes first, followed by the deinterleaved(P through W, 12
+// bytes each) subchannel data of every sector; the subchannel data compresses far better this way than interleaved between sectors.
+//
+class CDAccess_HCD : public CDAccess
+{
+ public:
+
+ CDAccess_HCD(const char *path, bool image_memcache);
+ CDAccess_HCD(Stream *stream);	// Takes ownership of "stream", even if the constructor throws.
+ virtual ~CDAccess_HCD();
+
+ virtual void Read_Raw_Sector(uint8 *buf, int32 lba);
+
+ virtual void Read_TOC(CDUtility::TOC *toc);
+
+ virtual bool Is_Physical(void) throw();
+
+ virtual void Eject(bool eject_status);
+
+ private:
+
+ void Load(void);
+ void Cleanup(void);
+
+ const uint8 *GetHunk(uint32 hunk);
+
+ struct HunkIndexEntry
+ {
+  uint64 offset;
+  uint32 comp_size;
+  uint32 crc;
+  uint8 codec;
+ };
+
+ // Decompressed hunks, least-recently-used replacement.
+ enum { HunkCacheSize = 8 };
+
+ struct HunkCacheEntry
+ {
+  uint32 hunk;	// ~0U if the entry is invalid.
+  uint32 last_use;
+  std::vector<uint8> data;
+ };
+
+ Stream* img_stream;
+ uint32 hunk_sectors;
+ uint32 num_sectors;
+ CDUtility::TOC tocd;
+
+ std::vector<HunkIndexEntry> hunk_index;
+ std::vector<uint8> comp_buf;
+
+ HunkCacheEntry hunk_cache[HunkCacheSize];
+ uint32 hunk_cache_counter;
+};
+
+// Writes the disc "src" out as an HCD image to "out", which must be empty and seekable; returns the size of the image.
+uint64 HCD_Write(CDAccess *src, Stream *out);
+
+// Converts the CD image at "src_path"(CUE, TOC or CCD) into an HCD image at "dest_path", which must not already exist, and then reads it back and
+// compares every sector against the source.  Throws MDFN_Error on failure.
+void HCD_Convert(const char *src_path, const char *dest_path);
+
+#endif
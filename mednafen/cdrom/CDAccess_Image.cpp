@@ -34,6 +34,11 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef HAVE_MADVISE
+#include <sys/mman.h>
+#endif
 
 #include <string.h>
 #include <errno.h>
@@ -847,6 +852,18 @@ void CDAccess_Image::ImageOpen(const char *path, bool image_memcache)
  } // end to track loop
 
  total_sectors = RunningLBA;
+
+ //
+ // Serve binary track data straight out of a mapping of the image file where possible, rather than seek()+read()'ing each sector.
+ //
+ for(int x = FirstTrack; x < (FirstTrack + NumTracks); x++)
+ {
+  Tracks[x].MappedData = NULL;
+  Tracks[x].MappedSize = 0;
+
+  if(!Tracks[x].AReader && Tracks[x].fp && (Tracks[x].MappedData = Tracks[x].fp->map()))
+   Tracks[x].MappedSize = Tracks[x].fp->size();
+ }
 }
 
 void CDAccess_Image::Cleanup(void)
@@ -892,9 +909,58 @@ CDAccess_Image::~CDAccess_Image()
  Cleanup();
 }
 
+INLINE void CDAccess_Image::ReadTrackData(CDRFILE_TRACK_INFO *ct, int64 offset, uint8 *buf, uint32 len)
+{
+ if(ct->MappedData && (uint64)(offset + len) <= ct->MappedSize)
+  memcpy(buf, ct->MappedData + offset, len);
+ else
+ {
+  ct->fp->seek(offset, SEEK_SET);
+  ct->fp->read(buf, len);
+ }
+}
+
+void CDAccess_Image::HintReadSector(int32 lba, int32 count)
+{
+ #ifdef HAVE_MADVISE
+ static const uint64 page_mask = (uint64)sysconf(_SC_PAGESIZE) - 1;
+
+ for(int32 track = FirstTrack; track < (FirstTrack + NumTracks); track++)
+ {
+  CDRFILE_TRACK_INFO *ct = &Tracks[track];
+  const int32 sector_size = DI_Size_Table[ct->DIFormat] + (ct->SubchannelMode ? 96 : 0);
+  int32 start_lba = std::max<int32>(lba, ct->LBA - ct->pregap_dv);
+  int32 end_lba = std::min<int32>(lba + count, ct->LBA + ct->sectors);
+
+  if(!ct->MappedData || start_lba >= end_lba)
+   continue;
+
+  uint64 start = ct->FileOffset + (int64)(start_lba - ct->LBA) * sector_size;
+  uint64 end = std::min<uint64>(ct->MappedSize, ct->FileOffset + (int64)(end_lba - ct->LBA) * sector_size);
+
+  if(start >= end)
+   continue;
+
+  start &= ~page_mask;
+  madvise((void *)(ct->MappedData + start), end - start, MADV_WILLNEED);
+ }
+ #endif
+}
+
 void CDAccess_Image::Read_Raw_Sector(uint8 *buf, int32 lba)
+{
+ ReadSectorCommon(buf, lba, false);
+}
+
+bool CDAccess_Image::Read_Raw_Sector_NoECC(uint8 *buf, int32 lba)
+{
+ return ReadSectorCommon(buf, lba, true);
+}
+
+bool CDAccess_Image::ReadSectorCommon(uint8 *buf, int32 lba, bool defer_ecc)
 {
   bool TrackFound = FALSE;
+  bool ecc_deferred = false;
   uint8 SimuQ[0xC];
 
   memset(buf + 2352, 0, 96);
@@ -948,29 +1014,33 @@ void CDAccess_Image::Read_Raw_Sector(uint8 *buf, int32 lba)
       if(ct->SubchannelMode)
        SeekPos += 96 * (lba - ct->LBA);
 
-      ct->fp->seek(SeekPos, SEEK_SET);
-
       switch(ct->DIFormat)
       {
 	case DI_FORMAT_AUDIO:
-		ct->fp->read(buf, 2352);
+		ReadTrackData(ct, SeekPos, buf, 2352);
 
 		if(ct->RawAudioMSBFirst)
 		 Endian_A16_Swap(buf, 588 * 2);
 		break;
 
 	case DI_FORMAT_MODE1:
-		ct->fp->read(buf + 12 + 3 + 1, 2048);
-		encode_mode1_sector(lba + 150, buf);
+		ReadTrackData(ct, SeekPos, buf + 12 + 3 + 1, 2048);
+		if(defer_ecc)
+		{
+		 encode_mode1_sector_noecc(lba + 150, buf);
+		 ecc_deferred = true;
+		}
+		else
+		 encode_mode1_sector(lba + 150, buf);
 		break;
 
 	case DI_FORMAT_MODE1_RAW:
 	case DI_FORMAT_MODE2_RAW:
-		ct->fp->read(buf, 2352);
+		ReadTrackData(ct, SeekPos, buf, 2352);
 		break;
 
 	case DI_FORMAT_MODE2:
-		ct->fp->read(buf + 16, 2336);
+		ReadTrackData(ct, SeekPos, buf + 16, 2336);
 		encode_mode2_sector(lba + 150, buf);
 		break;
 
@@ -978,19 +1048,19 @@ void CDAccess_Image::Read_Raw_Sector(uint8 *buf, int32 lba)
 	// FIXME: M2F1, M2F2, does sub-header come before or after user data(standards say before, but I wonder
 	// about cdrdao...).
 	case DI_FORMAT_MODE2_FORM1:
-		ct->fp->read(buf + 24, 2048);
+		ReadTrackData(ct, SeekPos, buf + 24, 2048);
 		//encode_mode2_form1_sector(lba + 150, buf);
 		break;
 
 	case DI_FORMAT_MODE2_FORM2:
-		ct->fp->read(buf + 24, 2324);
+		ReadTrackData(ct, SeekPos, buf + 24, 2324);
 		//encode_mode2_form2_sector(lba + 150, buf);
 		break;
 
       }
 
       if(ct->SubchannelMode)
-       ct->fp->read(buf + 2352, 96);
+       ReadTrackData(ct, SeekPos + DI_Size_Table[ct->DIFormat], buf + 2352, 96);
      }
     } // end if audible part of audio track read.
     break;
@@ -1030,6 +1100,8 @@ void CDAccess_Image::Read_Raw_Sector(uint8 *buf, int32 lba)
  //subq_deinterleave(buf + 2352, qbuf);
  //printf("%02x\n", qbuf[0]);
  //printf("%02x\n", buf[12 + 3]);
+
+ return(ecc_deferred);
 }
 
 //
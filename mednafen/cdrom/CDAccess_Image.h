@@ -30,6 +30,9 @@ struct CDRFILE_TRACK_INFO
 	uint32 LastSamplePos;
 
 	AudioReader *AReader;
+
+	const uint8 *MappedData;	// fp->map(), or NULL if the file couldn't be mapped(or is read through AReader).
+	uint64 MappedSize;
 };
 #if 0
 struct Medium_Chunk
@@ -68,6 +71,10 @@ class CDAccess_Image : public CDAccess
 
  virtual void Read_Raw_Sector(uint8 *buf, int32 lba);
 
+ virtual bool Read_Raw_Sector_NoECC(uint8 *buf, int32 lba);
+
+ virtual void HintReadSector(int32 lba, int32 count);
+
  virtual void Read_TOC(CDUtility::TOC *toc);
 
  virtual bool Is_Physical(void) throw();
@@ -87,6 +94,11 @@ class CDAccess_Image : public CDAccess
  void ImageOpen(const char *path, bool image_memcache);
  void Cleanup(void);
 
+ void ReadTrackData(CDRFILE_TRACK_INFO *ct, int64 offset, uint8 *buf, uint32 len);
+
+ // Returns true if Mode 1 P/Q parity synthesis was skipped(only possible when "defer_ecc" is true).
+ bool ReadSectorCommon(uint8 *buf, int32 lba, bool defer_ecc);
+
  // MakeSubPQ will OR the simulated P and Q subchannel data into SubPWBuf.
  void MakeSubPQ(int32 lba, uint8 *SubPWBuf);
 
@@ -117,6 +117,20 @@ void encode_mode1_sector(uint32 aba, uint8 *sector_data)
  lec_encode_mode1_sector(aba, sector_data);
 }
 
+void encode_mode1_sector_noecc(uint32 aba, uint8 *sector_data)
+{
+ CDUtility_Init();
+
+ lec_encode_mode1_sector_noecc(aba, sector_data);
+}
+
+void encode_mode1_ecc(uint8 *sector_data)
+{
+ CDUtility_Init();
+
+ lec_encode_mode1_ecc(sector_data);
+}
+
 void encode_mode2_sector(uint32 aba, uint8 *sector_data)
 {
  CDUtility_Init();
@@ -171,6 +171,11 @@ namespace CDUtility
  void encode_mode2_form1_sector(uint32 aba, uint8 *sector_data);	// 2048+8 bytes of user data at offset 16
  void encode_mode2_form2_sector(uint32 aba, uint8 *sector_data);	// 2324+8 bytes of user data at offset 16
 
+ // Same as encode_mode1_sector(), but the P and Q parity bytes are left zeroed; encode_mode1_ecc() fills them in later,
+ // if and when something actually needs them.
+ void encode_mode1_sector_noecc(uint32 aba, uint8 *sector_data);
+ void encode_mode1_ecc(uint8 *sector_data);
+
 
  // out_buf must be able to contain 2352+96 bytes.
  // "mode" is only used if(toc.tracks[100].control & 0x4)
@@ -22,6 +22,7 @@
 #include "cdromif.h"
 #include "CDAccess.h"
 #include "../general.h"
+#include "../SPSCQueue.h"
 
 #include <algorithm>
 
@@ -61,6 +62,7 @@ class CDIF_Message
  std::string str_message;
 };
 
+// Each CDIF_Queue has exactly one writer thread and one reader thread.
 class CDIF_Queue
 {
  public:
@@ -73,16 +75,18 @@ class CDIF_Queue
  void Write(const CDIF_Message &message);
 
  private:
- std::queue<CDIF_Message> ze_queue;
- MDFN_Mutex *ze_mutex;
+ SPSCQueue<CDIF_Message> ze_queue;
 };
 
 
+// Only ever written by the read thread.  The emu thread reads entries without taking a lock, using "seq" to detect when it raced
+// with an update(seqlock-style: "seq" is odd while the entry is being modified).
 typedef struct
 {
- bool valid;
+ uint32 seq;
+ uint32 lba;	// ~0U if the entry is invalid.
  bool error;
- uint32 lba;
+ bool ecc_pending;	// Mode 1 P/Q parity in "data" hasn't been synthesized yet.
  uint8 data[2352 + 96];
 } CDIF_Sector_Buffer;
 
@@ -95,12 +99,14 @@ class CDIF_MT : public CDIF
  virtual ~CDIF_MT();
 
  virtual void HintReadSector(uint32 lba);
- virtual bool ReadRawSector(uint8 *buf, uint32 lba);
+ virtual bool ReadRawSector(uint8 *buf, uint32 lba, bool need_ecc = true);
 
  // Return true if operation succeeded or it was a NOP(either due to not being implemented, or the current status matches eject_status).
  // Returns false on failure(usually drive error of some kind; not completely fatal, can try again).
  virtual bool Eject(bool eject_status);
 
+ virtual bool GetCacheStats(CDIF_CacheStats *stats);
+
  // FIXME: Semi-private:
  int ReadThreadStart(void);
 
@@ -117,22 +123,36 @@ class CDIF_MT : public CDIF
  CDIF_Queue EmuThreadQueue;
 
 
+ // Direct-mapped by LBA.
  enum { SBSize = 256 };
  CDIF_Sector_Buffer SectorBuffers[SBSize];
 
- uint32 SBWritePos;
- 
+ bool SB_Lookup(uint32 lba, uint8 *buf, bool *error, bool *ecc_pending);
+
+ // SBMutex and SBCond are only used for the emu thread to sleep on while waiting for a sector that isn't in SectorBuffers yet.
  MDFN_Mutex *SBMutex;
+ MDFN_Cond *SBCond;
+ uint32 SBWaiting;
 
+ // Emu-thread-only(read by GetCacheStats()):
+ CDIF_CacheStats Stats;
 
  //
  // Read-thread-only:
  //
  void RT_EjectDisc(bool eject_status, bool skip_actual_eject = false);
+ void RT_InvalidateSectorBuffers(void);
+ void RT_WriteSectorBuffer(CDIF_Sector_Buffer *sb, uint32 lba, const uint8 *data, bool error, bool ecc_pending);
 
  uint32 ra_lba;
  int ra_count;
  uint32 last_read_lba;
+ uint32 ra_hint_end;
+
+ // Adaptive read-ahead state; see ReadThreadStart().
+ int ra_max;
+ int ra_speedmult;
+ uint32 ra_run_length;
 };
 
 
@@ -145,7 +165,7 @@ class CDIF_ST : public CDIF
  virtual ~CDIF_ST();
 
  virtual void HintReadSector(uint32 lba);
- virtual bool ReadRawSector(uint8 *buf, uint32 lba);
+ virtual bool ReadRawSector(uint8 *buf, uint32 lba, bool need_ecc = true);
  virtual bool Eject(bool eject_status);
 
  private:
@@ -190,55 +210,33 @@ CDIF_Message::~CDIF_Message()
 
 }
 
-CDIF_Queue::CDIF_Queue()
+CDIF_Queue::CDIF_Queue() : ze_queue(256)
 {
- ze_mutex = MDFND_CreateMutex();
+
 }
 
 CDIF_Queue::~CDIF_Queue()
 {
- MDFND_DestroyMutex(ze_mutex);
+
 }
 
 // Returns FALSE if message not read, TRUE if it was read.  Will always return TRUE if "blocking" is set.
 // Will throw MDFN_Error if the read message code is CDIF_MSG_FATAL_ERROR
 bool CDIF_Queue::Read(CDIF_Message *message, bool blocking)
 {
-  TryAgain:
-
-  MDFND_LockMutex(ze_mutex);
-  
-  if(ze_queue.size() > 0)
-  {
-   *message = ze_queue.front();
-   ze_queue.pop();
-   MDFND_UnlockMutex(ze_mutex);
+ if(!ze_queue.Read(message, blocking))
+  return(FALSE);
 
-   if(message->message == CDIF_MSG_FATAL_ERROR)
-    throw MDFN_Error(0, "%s", message->str_message.c_str());
+ if(message->message == CDIF_MSG_FATAL_ERROR)
+  throw MDFN_Error(0, "%s", message->str_message.c_str());
 
-   return(TRUE);
-  }
-  else if(blocking)
-  {
-   MDFND_UnlockMutex(ze_mutex);
-   MDFND_Sleep(1);
-   goto TryAgain;
-  }
-  else
-  {
-   MDFND_UnlockMutex(ze_mutex);
-   return(FALSE);
-  }
+ return(TRUE);
 }
 
+// Blocks(rather than growing the queue) if the reader has fallen 256 messages behind.
 void CDIF_Queue::Write(const CDIF_Message &message)
 {
- MDFND_LockMutex(ze_mutex);
-
- ze_queue.push(message);
-
- MDFND_UnlockMutex(ze_mutex);
+ ze_queue.Write(message);
 }
 
 
@@ -263,14 +261,46 @@ void CDIF_MT::RT_EjectDisc(bool eject_status, bool skip_actual_eject)
   }
   DiscEjected = eject_status;
 
-  SBWritePos = 0;
   ra_lba = 0;
   ra_count = 0;
   last_read_lba = ~0U;
-  memset(SectorBuffers, 0, SBSize * sizeof(CDIF_Sector_Buffer));
+  ra_hint_end = 0;
+  RT_InvalidateSectorBuffers();
+ }
+}
+
+void CDIF_MT::RT_WriteSectorBuffer(CDIF_Sector_Buffer *sb, uint32 lba, const uint8 *data, bool error, bool ecc_pending)
+{
+ const uint32 seq = sb->seq;
+
+ __atomic_store_n(&sb->seq, seq + 1, __ATOMIC_RELAXED);
+ __atomic_thread_fence(__ATOMIC_RELEASE);
+
+ __atomic_store_n(&sb->lba, lba, __ATOMIC_RELAXED);
+ sb->error = error;
+ sb->ecc_pending = ecc_pending;
+ if(data)
+  memcpy(sb->data, data, 2352 + 96);
+
+ __atomic_store_n(&sb->seq, seq + 2, __ATOMIC_RELEASE);
+
+ // Pairs with the fence in ReadRawSector(), so that either we see SBWaiting set, or the emu thread sees the new sector.
+ __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+ if(__atomic_load_n(&SBWaiting, __ATOMIC_RELAXED) && SBCond)
+ {
+  MDFND_LockMutex(SBMutex);
+  MDFND_SignalCond(SBCond);
+  MDFND_UnlockMutex(SBMutex);
  }
 }
 
+void CDIF_MT::RT_InvalidateSectorBuffers(void)
+{
+ for(unsigned i = 0; i < SBSize; i++)
+  RT_WriteSectorBuffer(&SectorBuffers[i], ~0U, NULL, false, false);
+}
+
 struct RTS_Args
 {
  CDIF_MT *cdif_ptr;
@@ -288,10 +318,14 @@ int CDIF_MT::ReadThreadStart()
  bool Running = TRUE;
 
  DiscEjected = true;
- SBWritePos = 0;
  ra_lba = 0;
  ra_count = 0;
  last_read_lba = ~0U;
+ ra_hint_end = 0;
+ ra_max = 16;
+ ra_speedmult = 2;
+ ra_run_length = 0;
+ RT_InvalidateSectorBuffers();
 
  try
  {
@@ -335,29 +369,61 @@ int CDIF_MT::ReadThreadStart()
 
     case CDIF_MSG_READ_SECTOR:
 			 {
-                          static const int max_ra = 16;
+			  //
+			  // Read-ahead adapts to the access pattern:  ra_max(how far ahead of the emulated drive we try to stay) grows while
+			  // the emu thread keeps catching up with us during sequential reads(streaming FMV/XA), and shrinks when runs of sequential
+			  // reads end before we've used up the read-ahead(seeky file loading, where the extra reads just delay the next seek).
+			  //
+                          static const int min_ra = 4;
+                          static const int max_ra = SBSize / 2 - 8;	// Keep well clear of wrapping around the direct-mapped buffer.
 			  static const int initial_ra = 1;
-			  static const int speedmult_ra = 2;
+			  static const int max_speedmult_ra = 8;
+			  static const int hint_ra = 64;
 			  uint32 new_lba = msg.args[0];
 
-			  assert((unsigned int)max_ra < (SBSize / 4));
-
 			  if(last_read_lba != ~0U && new_lba == (last_read_lba + 1))
 			  {
 			   int how_far_ahead = ra_lba - new_lba;
 
-			   if(how_far_ahead <= max_ra)
-			    ra_count = std::min(speedmult_ra, 1 + max_ra - how_far_ahead);
+			   ra_run_length++;
+
+			   if(ra_run_length > (uint32)initial_ra && SectorBuffers[new_lba & (SBSize - 1)].lba != new_lba)
+			   {
+			    // Emu thread is (or soon will be) stalled waiting on us.
+			    ra_max = std::min<int>(max_ra, ra_max * 2);
+			    ra_speedmult = std::min<int>(max_speedmult_ra, ra_speedmult + 1);
+			   }
+
+			   if(how_far_ahead <= ra_max)
+			    ra_count = std::min(ra_speedmult, 1 + ra_max - how_far_ahead);
 			   else
 			    ra_count++;
 			  }
 			  else if(new_lba != last_read_lba)
 			  {
+			   if(last_read_lba != ~0U && ra_run_length < (uint32)(ra_max / 2))
+			   {
+			    ra_max = std::max<int>(min_ra, ra_max / 2);
+			    ra_speedmult = std::max<int>(2, ra_speedmult - 1);
+			   }
+			   ra_run_length = 0;
+
                            ra_lba = new_lba;
 			   ra_count = initial_ra;
+			   ra_hint_end = new_lba;
 			  }
 
 			  last_read_lba = new_lba;
+
+			  // Keep the backing store(e.g. mmap()'d image file) hinted well ahead of where our own read-ahead is.
+			  if((ra_lba + ra_max) >= ra_hint_end)
+			  {
+			   if(ra_hint_end < ra_lba)
+			    ra_hint_end = ra_lba;
+
+			   disc_cdaccess->HintReadSector(ra_hint_end, hint_ra);
+			   ra_hint_end += hint_ra;
+			  }
 			 }
 			 break;
    }
@@ -372,29 +438,29 @@ int CDIF_MT::ReadThreadStart()
 
   if(ra_count)
   {
-   uint8 tmpbuf[2352 + 96];
-   bool error_condition = false;
+   CDIF_Sector_Buffer *sb = &SectorBuffers[ra_lba & (SBSize - 1)];
 
-   try
-   {
-    disc_cdaccess->Read_Raw_Sector(tmpbuf, ra_lba);
-   }
-   catch(std::exception &e)
+   // Already have it from an earlier pass(re-reading a recently-read area), so don't bother the CDAccess object.
+   if(sb->lba != ra_lba || sb->error)
    {
-    MDFN_PrintError(_("Sector %u read error: %s"), ra_lba, e.what());
-    memset(tmpbuf, 0, sizeof(tmpbuf));
-    error_condition = true;
-   }
-   
-   MDFND_LockMutex(SBMutex);
+    uint8 tmpbuf[2352 + 96];
+    bool error_condition = false;
+    bool ecc_pending = false;
 
-   SectorBuffers[SBWritePos].lba = ra_lba;
-   memcpy(SectorBuffers[SBWritePos].data, tmpbuf, 2352 + 96);
-   SectorBuffers[SBWritePos].valid = TRUE;
-   SectorBuffers[SBWritePos].error = error_condition;
-   SBWritePos = (SBWritePos + 1) % SBSize;
+    try
+    {
+     ecc_pending = disc_cdaccess->Read_Raw_Sector_NoECC(tmpbuf, ra_lba);
+    }
+    catch(std::exception &e)
+    {
+     MDFN_PrintError(_("Sector %u read error: %s"), ra_lba, e.what());
+     memset(tmpbuf, 0, sizeof(tmpbuf));
+     error_condition = true;
+     ecc_pending = false;
+    }
 
-   MDFND_UnlockMutex(SBMutex);
+    RT_WriteSectorBuffer(sb, ra_lba, tmpbuf, error_condition, ecc_pending);
+   }
 
    ra_lba++;
    ra_count--;
@@ -404,8 +470,11 @@ int CDIF_MT::ReadThreadStart()
  return(1);
 }
 
-CDIF_MT::CDIF_MT(CDAccess *cda) : disc_cdaccess(cda), CDReadThread(NULL), SBMutex(NULL)
+CDIF_MT::CDIF_MT(CDAccess *cda) : disc_cdaccess(cda), CDReadThread(NULL), SBMutex(NULL), SBCond(NULL), SBWaiting(0)
 {
+ memset(SectorBuffers, 0, sizeof(SectorBuffers));
+ memset(&Stats, 0, sizeof(Stats));
+
  try
  {
   CDIF_Message msg;
@@ -414,6 +483,8 @@ CDIF_MT::CDIF_MT(CDAccess *cda) : disc_cdaccess(cda), CDReadThread(NULL), SBMute
   if(!(SBMutex = MDFND_CreateMutex()))
    throw MDFN_Error(0, _("Error creating CD read thread mutex."));
 
+  SBCond = MDFND_CreateCond();	// NULL is ok, we'll just poll.
+
   UnrecoverableError = false;
 
   s.cdif_ptr = this;
@@ -431,6 +502,12 @@ CDIF_MT::CDIF_MT(CDAccess *cda) : disc_cdaccess(cda), CDReadThread(NULL), SBMute
    CDReadThread = NULL;
   }
 
+  if(SBCond)
+  {
+   MDFND_DestroyCond(SBCond);
+   SBCond = NULL;
+  }
+
   if(SBMutex)
   {
    MDFND_DestroyMutex(SBMutex);
@@ -465,6 +542,12 @@ CDIF_MT::~CDIF_MT()
  if(!thread_deaded_failed)
   MDFND_WaitThread(CDReadThread, NULL);
 
+ if(SBCond)
+ {
+  MDFND_DestroyCond(SBCond);
+  SBCond = NULL;
+ }
+
  if(SBMutex)
  {
   MDFND_DestroyMutex(SBMutex);
@@ -491,10 +574,10 @@ bool CDIF::ValidateRawSector(uint8 *buf)
  return(true);
 }
 
-bool CDIF_MT::ReadRawSector(uint8 *buf, uint32 lba)
+bool CDIF_MT::ReadRawSector(uint8 *buf, uint32 lba, bool need_ecc)
 {
- bool found = FALSE;
  bool error_condition = false;
+ bool ecc_pending = false;
 
  if(UnrecoverableError)
  {
@@ -512,29 +595,76 @@ bool CDIF_MT::ReadRawSector(uint8 *buf, uint32 lba)
 
  ReadThreadQueue.Write(CDIF_Message(CDIF_MSG_READ_SECTOR, lba));
 
- do
+ if(SB_Lookup(lba, buf, &error_condition, &ecc_pending))
+  Stats.hits++;
+ else
  {
-  MDFND_LockMutex(SBMutex);
+  const uint32 stall_start = MDFND_GetTime();
+
+  Stats.misses++;
 
-  for(int i = 0; i < SBSize; i++)
+  if(SBCond)
   {
-   if(SectorBuffers[i].valid && SectorBuffers[i].lba == lba)
-   {
-    error_condition = SectorBuffers[i].error;
-    memcpy(buf, SectorBuffers[i].data, 2352 + 96);
-    found = TRUE;
-   }
+   MDFND_LockMutex(SBMutex);
+   __atomic_store_n(&SBWaiting, 1, __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+   while(!SB_Lookup(lba, buf, &error_condition, &ecc_pending))
+    MDFND_WaitCond(SBCond, SBMutex);
+
+   __atomic_store_n(&SBWaiting, 0, __ATOMIC_RELAXED);
+   MDFND_UnlockMutex(SBMutex);
+  }
+  else
+  {
+   while(!SB_Lookup(lba, buf, &error_condition, &ecc_pending))
+    MDFND_Sleep(1);
   }
 
-  MDFND_UnlockMutex(SBMutex);
+  Stats.stall_ms += MDFND_GetTime() - stall_start;
+ }
 
-  if(!found)
-   MDFND_Sleep(1);
- } while(!found);
+ if(need_ecc && ecc_pending)
+  encode_mode1_ecc(buf);
 
  return(!error_condition);
 }
 
+// Lock-free; returns false if the sector isn't there(or the read thread was in the middle of replacing it).
+bool CDIF_MT::SB_Lookup(uint32 lba, uint8 *buf, bool *error, bool *ecc_pending)
+{
+ CDIF_Sector_Buffer *sb = &SectorBuffers[lba & (SBSize - 1)];
+
+ for(;;)
+ {
+  const uint32 seq = __atomic_load_n(&sb->seq, __ATOMIC_ACQUIRE);
+
+  if((seq & 1) || __atomic_load_n(&sb->lba, __ATOMIC_RELAXED) != lba)
+   return(false);
+
+  memcpy(buf, sb->data, 2352 + 96);
+  *error = sb->error;
+  *ecc_pending = sb->ecc_pending;
+
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+  if(__atomic_load_n(&sb->seq, __ATOMIC_RELAXED) == seq)
+   return(true);
+ }
+}
+
+bool CDIF_MT::GetCacheStats(CDIF_CacheStats *stats)
+{
+ *stats = Stats;
+ return(true);
+}
+
+bool CDIF::GetCacheStats(CDIF_CacheStats *stats)
+{
+ memset(stats, 0, sizeof(CDIF_CacheStats));
+ return(false);
+}
+
 void CDIF_MT::HintReadSector(uint32 lba)
 {
  if(UnrecoverableError)
@@ -554,7 +684,7 @@ int CDIF::ReadSector(uint8* pBuf, uint32 lba, uint32 nSectors)
  {
   uint8 tmpbuf[2352 + 96];
 
-  if(!ReadRawSector(tmpbuf, lba))
+  if(!ReadRawSector(tmpbuf, lba, false))
   {
    puts("CDIF Raw Read error");
    return(FALSE);
@@ -647,10 +777,13 @@ CDIF_ST::~CDIF_ST()
 
 void CDIF_ST::HintReadSector(uint32 lba)
 {
- // TODO: disc_cdaccess seek hint? (probably not, would require asynchronousitycamel)
+ if(UnrecoverableError)
+  return;
+
+ disc_cdaccess->HintReadSector(lba, 16);
 }
 
-bool CDIF_ST::ReadRawSector(uint8 *buf, uint32 lba)
+bool CDIF_ST::ReadRawSector(uint8 *buf, uint32 lba, bool need_ecc)
 {
  if(UnrecoverableError)
  {
@@ -660,7 +793,10 @@ bool CDIF_ST::ReadRawSector(uint8 *buf, uint32 lba)
 
  try
  {
-  disc_cdaccess->Read_Raw_Sector(buf, lba);
+  if(need_ecc)
+   disc_cdaccess->Read_Raw_Sector(buf, lba);
+  else
+   disc_cdaccess->Read_Raw_Sector_NoECC(buf, lba);
  }
  catch(std::exception &e)
  {
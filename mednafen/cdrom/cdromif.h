@@ -25,6 +25,13 @@
 
 typedef CDUtility::TOC CD_TOC;
 
+struct CDIF_CacheStats
+{
+ uint64 hits;		// Sector reads satisfied immediately from read-ahead.
+ uint64 misses;		// Sector reads that had to wait on the read thread.
+ uint64 stall_ms;	// Total time spent waiting on the read thread.
+};
+
 class CDIF
 {
  public:
@@ -38,7 +45,9 @@ class CDIF
  }
 
  virtual void HintReadSector(uint32 lba) = 0;
- virtual bool ReadRawSector(uint8 *buf, uint32 lba) = 0;
+ // If "need_ecc" is false, the caller promises not to look at the Mode 1 P/Q parity bytes(2076 through 2351), which lets
+ // image-backed discs skip synthesizing them.
+ virtual bool ReadRawSector(uint8 *buf, uint32 lba, bool need_ecc = true) = 0;
 
  // Call for mode 1 or mode 2 form 1 only.
  bool ValidateRawSector(uint8 *buf);
@@ -54,6 +63,9 @@ class CDIF
 
  inline bool IsPhysical(void) { return(is_phys_cache); }
 
+ // Returns false(and zeroes *stats) if the implementation doesn't keep statistics.
+ virtual bool GetCacheStats(CDIF_CacheStats *stats);
+
  // For Mode 1, or Mode 2 Form 1.
  // No reference counting or whatever is done, so if you destroy the CDIF object before you destroy the returned Stream, things will go BOOM.
  Stream *MakeStream(uint32 lba, uint32 sector_count);
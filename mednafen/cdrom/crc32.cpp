@@ -115,6 +115,27 @@ unsigned long  edctable[256] =
  0x71C0FC00L, 0xE151FD01L, 0xE0E1FE01L, 0x7070FF00L
 };
 
+/*
+ * Slice-by-8 tables derived from edctable:
+ * edctable8[k][i] is the CRC of byte i followed by k zero bytes.
+ */
+
+static const class EDCTable8 {
+private:
+  uint32 table[8][256];
+public:
+  EDCTable8()
+  {
+   for(int i = 0; i < 256; i++)
+    table[0][i] = edctable[i];
+
+   for(int k = 1; k < 8; k++)
+    for(int i = 0; i < 256; i++)
+     table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+  }
+  const uint32 *operator[](int k) const { return table[k]; }
+} edctable8;
+
 /*
  * CDROM EDC calculation
  */
@@ -123,6 +144,17 @@ uint32 EDCCrc32(const unsigned char *data, int len)
 {  
  uint32 crc = 0;
 
+ while(len >= 8)
+ {
+  const uint32 a = crc ^ (data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32)data[3] << 24));
+
+  crc = edctable8[7][a & 0xFF] ^ edctable8[6][(a >> 8) & 0xFF] ^ edctable8[5][(a >> 16) & 0xFF] ^ edctable8[4][a >> 24] ^
+	edctable8[3][data[4]] ^ edctable8[2][data[5]] ^ edctable8[1][data[6]] ^ edctable8[0][data[7]];
+
+  data += 8;
+  len -= 8;
+ }
+
  while(len--)
   crc = edctable[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
 
@@ -21,15 +21,16 @@
 #include <config.h>
 #endif
 
+#include "dvdisaster.h"
+
 #include <assert.h>
+#include <string.h>
 #include <sys/types.h>
 
 #include "lec.h"
 
 #define GF8_PRIM_POLY 0x11d /* x^8 + x^4 + x^3 + x^2 + 1 */
 
-#define EDC_POLY 0x8001801b /* (x^16 + x^15 + x^2 + 1) (x^16 + x^2 + x + 1) */
-
 #define LEC_HEADER_OFFSET 12
 #define LEC_DATA_OFFSET 16
 #define LEC_MODE1_DATA_LEN 2048
@@ -48,25 +49,15 @@ typedef u_int8_t gf8_t;
 static u_int8_t GF8_LOG[256];
 static gf8_t GF8_ILOG[256];
 
-static const class Gf8_Q_Coeffs_Results_01 {
-private:
-  u_int16_t table[43][256];
-public:
-  Gf8_Q_Coeffs_Results_01();
-  ~Gf8_Q_Coeffs_Results_01() {}
-  const u_int16_t *operator[] (int i) const { return &table[i][0]; }
-  operator const u_int16_t *() const	    { return &table[0][0]; }
-} CF8_Q_COEFFS_RESULTS_01;
-
-static const class CrcTable {
+static const class Gf8_PQ_Tables {
 private:
-  u_int32_t table[256];
+  u_int8_t div_a1_plus_1[256];
 public:
-  CrcTable();
-  ~CrcTable() {}
-  u_int32_t operator[](int i) const	{ return table[i]; }
-  operator const u_int32_t *() const	{ return table;    }
-} CRCTABLE;
+  Gf8_PQ_Tables();
+  ~Gf8_PQ_Tables() {}
+  /* x / (a^1 + 1) */
+  u_int8_t div_a1_plus_1_of(u_int8_t x) const { return div_a1_plus_1[x]; }
+} GF8_PQ_TABLES;
 
 static const class ScrambleTable {
 private:
@@ -108,6 +99,17 @@ static void gf8_create_log_tables()
  */
 #define gf8_add(a,  b) (a) ^ (b)
 
+/* Multiplication by a^1 in the GF(8) domain, of 8 values packed into
+ * one 64-bit word: shift each byte left by one, and reduce the bytes
+ * that overflowed by the primitive polynomial.
+ */
+static inline u_int64_t gf8_mult_a1_x8(u_int64_t x)
+{
+  const u_int64_t carry = (x >> 7) & 0x0101010101010101ULL;
+
+  return ((x & 0x7f7f7f7f7f7f7f7fULL) << 1) ^ (carry * (GF8_PRIM_POLY & 0xff));
+}
+
 
 /* Multiplication in the GF(8) domain: add the logarithms (modulo 255)
  * and return the inverse logarithm. Not used!
@@ -149,141 +151,34 @@ static gf8_t gf8_div(gf8_t a, gf8_t b)
   return GF8_ILOG[sum];
 }
 
-Gf8_Q_Coeffs_Results_01::Gf8_Q_Coeffs_Results_01()
-{
-  int i, j;
-  u_int16_t c;
-  gf8_t GF8_COEFFS_HELP[2][45]; 
-  u_int8_t GF8_Q_COEFFS[2][45];
-
-
-  gf8_create_log_tables();
-
-  /* build matrix H:
-   *  1    1   ...  1   1
-   * a^44 a^43 ... a^1 a^0
-   *
-   * 
-   */
-
-  for (j = 0; j < 45; j++) {
-    GF8_COEFFS_HELP[0][j] = 1;               /* e0 */
-    GF8_COEFFS_HELP[1][j] = GF8_ILOG[44-j];  /* e1 */
-  }
-
-  
-  /* resolve equation system for parity byte 0 and 1 */
- 
-  /* e1' = e1 + e0 */
-  for (j = 0; j < 45; j++) {
-    GF8_Q_COEFFS[1][j] = gf8_add(GF8_COEFFS_HELP[1][j],
-				 GF8_COEFFS_HELP[0][j]);
-  }
-
-  /* e1'' = e1' / (a^1 + 1) */
-  for (j = 0; j < 45; j++) {
-    GF8_Q_COEFFS[1][j] = gf8_div(GF8_Q_COEFFS[1][j], GF8_Q_COEFFS[1][43]);
-  }
-
-  /* e0' = e0 + e1 / a^1 */
-  for (j = 0; j < 45; j++) {
-    GF8_Q_COEFFS[0][j] = gf8_add(GF8_COEFFS_HELP[0][j],
-				 gf8_div(GF8_COEFFS_HELP[1][j],
-					 GF8_ILOG[1]));
-  }    
-
-  /* e0'' = e0' / (1 + 1 / a^1) */
-  for (j = 0; j < 45; j++) {
-    GF8_Q_COEFFS[0][j] = gf8_div(GF8_Q_COEFFS[0][j], GF8_Q_COEFFS[0][44]);
-  }
-
-  /* 
-   * Compute the products of 0..255 with all of the Q coefficients in
-   * advance. When building the scalar product between the data vectors
-   * and the P/Q vectors the individual products can be looked up in
-   * this table
-   *
-   * The P parity coefficients are just a subset of the Q coefficients so
-   * that we do not need to create a separate table for them. 
-   */
-  
-  for (j = 0; j < 43; j++) {
-
-    table[j][0] = 0;
-
-    for (i = 1; i < 256; i++) {
-      c = GF8_LOG[i] + GF8_LOG[GF8_Q_COEFFS[0][j]];
-      if (c >= 255) c -= 255;
-      table[j][i] = GF8_ILOG[c];
-
-      c = GF8_LOG[i] + GF8_LOG[GF8_Q_COEFFS[1][j]];
-      if (c >= 255) c -= 255;
-      table[j][i] |= GF8_ILOG[c]<<8;
-    }
-  }
-}
-
-/* Reverses the bits in 'd'. 'bits' defines the bit width of 'd'.
+/* The P and Q vectors both end with their two parity bytes, at code
+ * positions 43 and 44 of the Q code.  With the parity check matrix H:
+ *  1    1   ...  1   1
+ * a^44 a^43 ... a^1 a^0
+ *
+ * and s0 = sum(d_j), s1 = sum(d_j * a^(44-j)) over the data bytes, the
+ * parity bytes are:
+ *  p43 = (s0 + s1) / (a^1 + 1)
+ *  p44 = s0 + p43
+ *
+ * So the only general multiplication needed is by 1 / (a^1 + 1), which
+ * is done once per vector through this table.
  */
-static u_int32_t mirror_bits(u_int32_t d, int bits)
+Gf8_PQ_Tables::Gf8_PQ_Tables()
 {
   int i;
-  u_int32_t r = 0;
-
-  for (i = 0; i < bits; i++) {
-    r <<= 1;
-
-    if ((d & 0x1) != 0)
-      r |= 0x1;
-
-    d >>= 1;
-  }
-
-  return r;
-}
 
-/* Build the CRC lookup table for EDC_POLY poly. The CRC is 32 bit wide
- * and reversed (i.e. the bit stream is divided by the EDC_POLY with the
- * LSB first order).
- */
-CrcTable::CrcTable ()
-{
-  u_int32_t i, j;
-  u_int32_t r;
-  
-  for (i = 0; i < 256; i++) {
-    r = mirror_bits(i, 8);
-
-    r <<= 24;
-
-    for (j = 0; j < 8; j++) {
-      if ((r & 0x80000000) != 0) {
-	r <<= 1;
-	r ^= EDC_POLY;
-      }
-      else {
-	r <<= 1;
-      }
-    }
-
-    r = mirror_bits(r, 32);
+  gf8_create_log_tables();
 
-    table[i] = r;
-  }
+  for (i = 0; i < 256; i++)
+    div_a1_plus_1[i] = gf8_div(i, gf8_add(GF8_ILOG[1], 1));
 }
 
-/* Calculates the CRC of given data with given lengths based on the
- * table lookup algorithm.
+/* Calculates the CRC of given data with given lengths.
  */
 static u_int32_t calc_edc(u_int8_t *data, int len)
 {
-  u_int32_t crc = 0;
-
-  while (len--) {
-    crc = CRCTABLE[(int)(crc ^ *data++) & 0xff] ^ (crc >> 8);
-  }
-
-  return crc;
+  return EDCCrc32(data, len);
 }
 
 /* Build the scramble table as defined in the yellow book. The bytes
@@ -383,99 +278,126 @@ static void set_sector_header(u_int8_t mode, u_int32_t adr, u_int8_t *sector)
   sector[LEC_HEADER_OFFSET + 3] = mode;
 }
 
-/* Calculate the P parities for the sector.
- * The 43 P vectors of length 24 are combined with the GF8_P_COEFFS.
+/* Stores the parity bytes for 'count' vectors, given their s0 and s1
+ * sums (see Gf8_PQ_Tables).
  */
-static void calc_P_parity(u_int8_t *sector)
+static void store_parity(const u_int8_t *s0, const u_int8_t *s1, int count,
+			 u_int8_t *p43, u_int8_t *p44)
 {
-  int i, j;
-  u_int16_t p01_msb, p01_lsb;
-  u_int8_t *p_lsb_start;
-  u_int8_t *p_lsb;
-  u_int8_t *p0, *p1;
-  u_int8_t d0,d1;
+  int i;
 
-  p_lsb_start = sector + LEC_HEADER_OFFSET;
+  for (i = 0; i < count; i++) {
+    u_int8_t p = GF8_PQ_TABLES.div_a1_plus_1_of(gf8_add(s0[i], s1[i]));
 
-  p1 = sector + LEC_MODE1_P_PARITY_OFFSET;
-  p0 = sector + LEC_MODE1_P_PARITY_OFFSET + 2 * 43;
+    p43[i] = p;
+    p44[i] = gf8_add(s0[i], p);
+  }
+}
 
-  for (i = 0; i <= 42; i++) {
-    p_lsb = p_lsb_start;
+/* Calculate the P parities for the sector.
+ * The 43 P vectors of length 24 (times two, for the LSB and MSB of each
+ * word) are the columns of a 24 row by 86 byte matrix starting at the
+ * sector header, so all of them are evaluated at once, 8 at a time,
+ * with Horner's scheme.
+ */
+static void calc_P_parity(u_int8_t *sector)
+{
+  enum { ROW_LEN = 2 * 43, NUM_WORDS = (ROW_LEN + 7) / 8 };
+  u_int64_t acc0[NUM_WORDS], acc1[NUM_WORDS];
+  u_int8_t s0[NUM_WORDS * 8], s1[NUM_WORDS * 8];
+  const u_int8_t *row = sector + LEC_HEADER_OFFSET;
+  int i, j;
 
-    p01_lsb = p01_msb = 0;
+  for (i = 0; i < NUM_WORDS; i++)
+    acc0[i] = acc1[i] = 0;
 
-    for (j = 19; j <= 42; j++) {
-      d0 = *p_lsb;
-      d1 = *(p_lsb+1);
+  /* The last word of each row runs 2 bytes into the next row(or the P
+     parity area); those lanes are never stored. */
+  for (j = 19; j <= 42; j++) {
+    for (i = 0; i < NUM_WORDS; i++) {
+      u_int64_t d;
 
-      p01_lsb ^= CF8_Q_COEFFS_RESULTS_01[j][d0];
-      p01_msb ^= CF8_Q_COEFFS_RESULTS_01[j][d1];
+      memcpy(&d, row + i * 8, 8);
 
-      p_lsb += 2 * 43;
+      acc0[i] ^= d;
+      acc1[i] = gf8_mult_a1_x8(acc1[i]) ^ d;
     }
 
-    *p0 = p01_lsb;
-    *(p0 + 1) = p01_msb;
-    
-    *p1 = p01_lsb>>8;
-    *(p1 + 1) = p01_msb>>8;
+    row += ROW_LEN;
+  }
 
-    p0 += 2;
-    p1 += 2;
+  /* acc1 holds sum(d_j * a^(42-j)) */
+  for (i = 0; i < NUM_WORDS; i++)
+    acc1[i] = gf8_mult_a1_x8(gf8_mult_a1_x8(acc1[i]));
 
-    p_lsb_start += 2;
-  }
+  memcpy(s0, acc0, sizeof(s0));
+  memcpy(s1, acc1, sizeof(s1));
+
+  store_parity(s0, s1, ROW_LEN, sector + LEC_MODE1_P_PARITY_OFFSET,
+	       sector + LEC_MODE1_P_PARITY_OFFSET + ROW_LEN);
 }
 
 /* Calculate the Q parities for the sector.
- * The 26 Q vectors of length 43 are combined with the GF8_Q_COEFFS.
+ * The 26 Q vectors of length 43 (times two, for the LSB and MSB of each
+ * word) are the diagonals of the 26 row by 43 word matrix formed by the
+ * header, data and P parity: element j of vector i is word j of row
+ * (i + j) % 26.  After gathering each column of the matrix rotated into
+ * vector order, all of the vectors are evaluated at once with Horner's
+ * scheme like the P vectors.
  */
 static void calc_Q_parity(u_int8_t *sector)
 {
-  int i, j;
-  u_int16_t q01_lsb, q01_msb;
-  u_int8_t *q_lsb_start;
-  u_int8_t *q_lsb;
-  u_int8_t *q0, *q1, *q_start;
-  u_int8_t d0,d1;
+  enum { NUM_VEC_BYTES = 2 * 26, NUM_WORDS = (NUM_VEC_BYTES + 7) / 8 };
+  u_int8_t columns[43][NUM_WORDS * 8];
+  u_int64_t acc0[NUM_WORDS], acc1[NUM_WORDS];
+  u_int8_t s0[NUM_WORDS * 8], s1[NUM_WORDS * 8];
+  const u_int8_t *data = sector + LEC_HEADER_OFFSET;
+  int i, j, r;
+
+  /* columns[j][2 * i + b] = byte b of word j of row (i + j) % 26 */
+  for (j = 0; j < 43; j++) {
+    u_int8_t *col = columns[j];
+
+    i = (26 - (j % 26)) % 26;
 
-  q_lsb_start = sector + LEC_HEADER_OFFSET;
+    for (r = 0; r < 26; r++) {
+      const u_int8_t *w = data + 2 * (43 * r + j);
 
-  q_start = sector + LEC_MODE1_Q_PARITY_OFFSET;
-  q1 = sector + LEC_MODE1_Q_PARITY_OFFSET;
-  q0 = sector + LEC_MODE1_Q_PARITY_OFFSET + 2 * 26;
+      col[2 * i] = w[0];
+      col[2 * i + 1] = w[1];
 
-  for (i = 0; i <= 25; i++) {
-    q_lsb = q_lsb_start;
+      if (++i == 26)
+	i = 0;
+    }
 
-    q01_lsb = q01_msb = 0;
+    for (i = NUM_VEC_BYTES; i < NUM_WORDS * 8; i++)
+      col[i] = 0;
+  }
 
-    for (j = 0; j <= 42; j++) {
-      d0 = *q_lsb;
-      d1 = *(q_lsb+1);
+  for (i = 0; i < NUM_WORDS; i++)
+    acc0[i] = acc1[i] = 0;
 
-      q01_lsb ^= CF8_Q_COEFFS_RESULTS_01[j][d0];
-      q01_msb ^= CF8_Q_COEFFS_RESULTS_01[j][d1];
+  for (j = 0; j <= 42; j++) {
+    const u_int8_t *col = columns[j];
 
-      q_lsb += 2 * 44;
+    for (i = 0; i < NUM_WORDS; i++) {
+      u_int64_t d;
 
-      if (q_lsb >= q_start) {
-	q_lsb -= 2 * 1118;
-      }
+      memcpy(&d, col + i * 8, 8);
+
+      acc0[i] ^= d;
+      acc1[i] = gf8_mult_a1_x8(acc1[i]) ^ d;
     }
+  }
 
-    *q0 = q01_lsb;
-    *(q0 + 1) = q01_msb;
-    
-    *q1 = q01_lsb>>8;
-    *(q1 + 1) = q01_msb>>8;
+  for (i = 0; i < NUM_WORDS; i++)
+    acc1[i] = gf8_mult_a1_x8(gf8_mult_a1_x8(acc1[i]));
 
-    q0 += 2;
-    q1 += 2;
+  memcpy(s0, acc0, sizeof(s0));
+  memcpy(s1, acc1, sizeof(s1));
 
-    q_lsb_start += 2 * 43;
-  }
+  store_parity(s0, s1, NUM_VEC_BYTES, sector + LEC_MODE1_Q_PARITY_OFFSET,
+	       sector + LEC_MODE1_Q_PARITY_OFFSET + NUM_VEC_BYTES);
 }
 
 /* Encodes a MODE 0 sector.
@@ -501,22 +423,34 @@ void lec_encode_mode0_sector(u_int32_t adr, u_int8_t *sector)
  * offset 16
  */
 void lec_encode_mode1_sector(u_int32_t adr, u_int8_t *sector)
+{
+  lec_encode_mode1_sector_noecc(adr, sector);
+  lec_encode_mode1_ecc(sector);
+}
+
+/* Encodes a MODE 1 sector except for the P and Q parity, which is
+ * zero-filled.
+ * 'adr' is the current physical sector address
+ * 'sector' must be 2352 byte wide containing 2048 bytes user data at
+ * offset 16
+ */
+void lec_encode_mode1_sector_noecc(u_int32_t adr, u_int8_t *sector)
 {
   set_sync_pattern(sector);
   set_sector_header(1, adr, sector);
 
   calc_mode1_edc(sector);
 
-  /* clear the intermediate field */
-  sector[LEC_MODE1_INTERMEDIATE_OFFSET] =
-    sector[LEC_MODE1_INTERMEDIATE_OFFSET + 1] =
-    sector[LEC_MODE1_INTERMEDIATE_OFFSET + 2] =
-    sector[LEC_MODE1_INTERMEDIATE_OFFSET + 3] =
-    sector[LEC_MODE1_INTERMEDIATE_OFFSET + 4] =
-    sector[LEC_MODE1_INTERMEDIATE_OFFSET + 5] =
-    sector[LEC_MODE1_INTERMEDIATE_OFFSET + 6] =
-    sector[LEC_MODE1_INTERMEDIATE_OFFSET + 7] = 0;
+  /* clear the intermediate field and the parity */
+  memset(sector + LEC_MODE1_INTERMEDIATE_OFFSET, 0, 2352 - LEC_MODE1_INTERMEDIATE_OFFSET);
+}
 
+/* Calculates the P and Q parity of a MODE 1 sector that was encoded
+ * with lec_encode_mode1_sector_noecc().
+ * 'sector' must be 2352 byte wide
+ */
+void lec_encode_mode1_ecc(u_int8_t *sector)
+{
   calc_P_parity(sector);
   calc_Q_parity(sector);
 }
@@ -27,6 +27,7 @@
 #include <sys/types.h>
 #include <inttypes.h>
 
+typedef uint64_t u_int64_t;
 typedef uint32_t u_int32_t;
 typedef uint16_t u_int16_t;
 typedef uint8_t u_int8_t;
@@ -48,6 +49,19 @@ void lec_encode_mode0_sector(u_int32_t adr, u_int8_t *sector);
  */
 void lec_encode_mode1_sector(u_int32_t adr, u_int8_t *sector);
 
+/* Encodes a MODE 1 sector, leaving the P and Q parity zero-filled.
+ * 'adr' is the current physical sector address
+ * 'sector' must be 2352 byte wide containing 2048 bytes user data at
+ * offset 16
+ */
+void lec_encode_mode1_sector_noecc(u_int32_t adr, u_int8_t *sector);
+
+/* Fills in the P and Q parity of a sector encoded with
+ * lec_encode_mode1_sector_noecc().
+ * 'sector' must be 2352 byte wide
+ */
+void lec_encode_mode1_ecc(u_int8_t *sector);
+
 /* Encodes a MODE 2 sector.
  * 'adr' is the current physical sector address
  * 'sector' must be 2352 byte wide containing 2336 bytes user data at
@@ -1450,7 +1450,7 @@ static void DoREADHEADER10(const uint8 *cdb)
   return;
  }
 
- Cur_CDIF->ReadRawSector(raw_buf, HeaderLBA);	//, HeaderLBA + 1);
+ Cur_CDIF->ReadRawSector(raw_buf, HeaderLBA, false);	//, HeaderLBA + 1);
  if(!ValidateRawDataSector(raw_buf, HeaderLBA))
   return;
 
@@ -2505,7 +2505,7 @@ static INLINE void RunCDDA(uint32 system_timestamp, int32 run_time)
     {
      uint8 tmpbuf[2352 + 96];
 
-     Cur_CDIF->ReadRawSector(tmpbuf, read_sec);	//, read_sec_end, read_sec_start);
+     Cur_CDIF->ReadRawSector(tmpbuf, read_sec, false);	//, read_sec_end, read_sec_start);
 
      for(int i = 0; i < 588 * 2; i++)
       cdda.CDDASectorBuffer[i] = MDFN_de16lsb(&tmpbuf[i * 2]);
@@ -2679,7 +2679,7 @@ static INLINE void RunCDRead(uint32 system_timestamp, int32 run_time)
     {
      CommandCCError(SENSEKEY_ILLEGAL_REQUEST, NSE_END_OF_VOLUME);
     }
-    else if(!Cur_CDIF->ReadRawSector(tmp_read_buf, SectorAddr))	//, SectorAddr + SectorCount))
+    else if(!Cur_CDIF->ReadRawSector(tmp_read_buf, SectorAddr, false))	//, SectorAddr + SectorCount))
     {
      cd.data_transfer_done = FALSE;
 
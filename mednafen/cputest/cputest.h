@@ -42,6 +42,7 @@ extern "C" {
 #define CPUTEST_FLAG_SSE4         0x0100 ///< Penryn SSE4.1 functions
 #define CPUTEST_FLAG_SSE42        0x0200 ///< Nehalem SSE4.2 functions
 #define CPUTEST_FLAG_AVX          0x4000 ///< AVX functions: requires OS support even if YMM registers aren't used
+#define CPUTEST_FLAG_AVX2         0x0400 ///< AVX2 functions: requires OS support even if YMM registers aren't used
 
 #define CPUTEST_FLAG_CMOV	  0x8000 // CMOVcc support (Mednafen addition)
 
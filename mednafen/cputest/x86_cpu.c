@@ -33,7 +33,7 @@
          "xchg %%"REG_b", %%"REG_S\
          : "=a" (eax), "=S" (ebx),\
            "=c" (ecx), "=d" (edx)\
-         : "0" (index));
+         : "0" (index), "2" (0));
 
 #define xgetbv(index,eax,edx)                                   \
     __asm__ (".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c" (index))
@@ -114,6 +114,13 @@ int ff_get_cpu_flags_x86(void)
                   ;
     }
 
+    // Mednafen addition(avx2):
+    if(max_std_level >= 7 && (rval & CPUTEST_FLAG_AVX)){
+        cpuid(7, eax, ebx, ecx, edx);
+        if (ebx & 0x00000020)
+            rval |= CPUTEST_FLAG_AVX2;
+    }
+
     cpuid(0x80000000, max_ext_level, ebx, ecx, edx);
 
     if(max_ext_level >= 0x80000001){
@@ -25,6 +25,7 @@
 #include "logdebugger.h"
 #include "prompt.h"
 #include "video.h"
+#include "../TripleBuffer.h"
 
 static FILE *TraceLog = NULL;
 static std::string TraceLogSpec;
@@ -52,12 +53,10 @@ static std::string ReadBreakpoints, IOReadBreakpoints, AuxReadBreakpoints;
 static std::string WriteBreakpoints, IOWriteBreakpoints, AuxWriteBreakpoints;
 static std::string OpBreakpoints;
 
-static MDFN_Surface* DebuggerSurface[2] = { NULL, NULL };
-static MDFN_Rect DebuggerRect[2];
-
-static int volatile DMTV_BackBuffer = 0;
-static MDFN_Surface* volatile DMTV_Surface = NULL;
-static MDFN_Rect* volatile DMTV_Rect = NULL;
+// Drawn by the game thread, handed to the main thread along with each video frame.
+static MDFN_Surface* DebuggerSurface[3] = { NULL, NULL, NULL };
+static MDFN_Rect DebuggerRect[3];
+static TripleBuffer DebuggerFrames;
 
 //
 // Used for translating mouse coordinates and whatnot.  Doesn't really matter if it's not atomically updated, there
@@ -679,19 +678,19 @@ static DebuggerPrompt *myprompt = NULL;
 //
 void Debugger_GTR_PassBlit(void)
 {
- DMTV_Rect = &DebuggerRect[DMTV_BackBuffer];
- DMTV_Surface = DebuggerSurface[DMTV_BackBuffer];
-
- DMTV_BackBuffer ^= 1;
+ DebuggerFrames.Publish();
 }
 
 void Debugger_MT_DrawToScreen(const MDFN_PixelFormat& pf, signed screen_w, signed screen_h)
 {
- if(!DMTV_Rect || !DMTV_Surface || !DMTV_Rect->w || !DMTV_Rect->h)
+ DebuggerFrames.Acquire();
+
+ MDFN_Surface* debsurf = DebuggerSurface[DebuggerFrames.FrontIndex()];
+ MDFN_Rect* debrect = &DebuggerRect[DebuggerFrames.FrontIndex()];
+
+ if(!debsurf || !debrect->w || !debrect->h)
   return;
 
- MDFN_Surface* debsurf = DMTV_Surface;
- MDFN_Rect* debrect = DMTV_Rect;
  MDFN_Rect zederect;
  int xm = screen_w / debrect->w;
  int ym = screen_h / debrect->h;
@@ -717,8 +716,8 @@ void Debugger_MT_DrawToScreen(const MDFN_PixelFormat& pf, signed screen_w, signe
 
 void Debugger_GT_Draw(void)
 {
- MDFN_Surface* surface = DebuggerSurface[DMTV_BackBuffer];
- MDFN_Rect* rect = &DebuggerRect[DMTV_BackBuffer];
+ MDFN_Surface* surface = DebuggerSurface[DebuggerFrames.BackIndex()];
+ MDFN_Rect* rect = &DebuggerRect[DebuggerFrames.BackIndex()];
  MDFN_Rect screen_rect = *(MDFN_Rect*)&dlc_screen_dest_rect;
 
  if(!IsActive)
@@ -1327,8 +1326,8 @@ bool Debugger_GT_Toggle(void)
   {
    if(!DebuggerSurface[0])
    {
-    DebuggerSurface[0] = new MDFN_Surface(NULL, 640, 480, 640, MDFN_PixelFormat(MDFN_COLORSPACE_RGB, 0, 8, 16, 24));
-    DebuggerSurface[1] = new MDFN_Surface(NULL, 640, 480, 640, MDFN_PixelFormat(MDFN_COLORSPACE_RGB, 0, 8, 16, 24));
+    for(unsigned i = 0; i < 3; i++)
+     DebuggerSurface[i] = new MDFN_Surface(NULL, 640, 480, 640, MDFN_PixelFormat(MDFN_COLORSPACE_RGB, 0, 8, 16, 24));
    }
 
    if(NeedInit)
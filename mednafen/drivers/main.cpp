@@ -56,6 +56,7 @@
 #include "remote.h"
 #include "ers.h"
 #include "../qtrecord.h"
+#include "../TripleBuffer.h"
 #include <math.h>
 
 JoystickManager *joy_manager = NULL;
@@ -384,18 +385,27 @@ void MakeVideoSettings(std::vector <MDFNSetting> &settings)
 }
 
 static SDL_Thread *GameThread;
-static MDFN_Surface *VTBuffer[2] = { NULL, NULL };
-static MDFN_Rect *VTLineWidths[2] = { NULL, NULL };
+static MDFN_Surface *VTBuffer[3] = { NULL, NULL, NULL };
+static MDFN_Rect *VTLineWidths[3] = { NULL, NULL, NULL };
+static MDFN_Rect VTDisplayRects[3];
+
+//
+// Game thread to main thread frame handoff.  The game thread emulates into VTBuffer[VTFrames.BackIndex()] and publishes it without ever
+// waiting on the main thread; the main thread blits VTBuffer[VTFrames.FrontIndex()] after acquiring the newest published frame(see
+// TripleBuffer.h).  VTFrameSem wakes the main thread when there's something new to blit, rather than it polling.
+//
+enum
+{
+ VTF_SSNAPSHOT = 0x10	// Take a screen snapshot when blitting this frame.
+};
+static TripleBuffer VTFrames;
+static SDL_sem *VTFrameSem = NULL;
+static int VTRedraw = 0;	// Set by the game thread to have the main thread blit its current frame again(cheat interface, debugger stepping).
+static uint32 VTBlitCount = 0;	// Incremented by the main thread after every blit.
 
-static int volatile VTSSnapshot = 0;
-static int volatile VTBackBuffer = 0;
 static SDL_mutex *VTMutex = NULL, *EVMutex = NULL;
 static SDL_mutex *StdoutMutex = NULL;
 
-static MDFN_Surface * volatile VTReady;
-static MDFN_Rect * volatile VTLWReady;
-static MDFN_Rect * volatile VTDRReady;
-static MDFN_Rect VTDisplayRects[2];
 static bool sc_blit_timesync;
 
 static char *soundrecfn=0;	/* File name of sound recording. */
@@ -661,6 +671,7 @@ static int DoArgs(int argc, char *argv[], char **filename)
 
 	char *dsfn = NULL;
 	char *dmfn = NULL;
+	char *hcdfn = NULL;
 	char *dummy_remote = NULL;
 
         ARGPSTRUCT MDFNArgs[] = 
@@ -681,6 +692,8 @@ static int DoArgs(int argc, char *argv[], char **filename)
 	 { "dump_settings_def", _("Dump settings definition data to specified file."), 0, &dsfn, SUBSTYPE_STRING_ALLOC },
 	 { "dump_modules_def", _("Dump modules definition data to specified file."), 0, &dmfn, SUBSTYPE_STRING_ALLOC },
 
+	 { "convert_cd", _("Convert the CD image [FILE](CUE, TOC, or CCD) to a compressed HCD image with the specified filename."), 0, &hcdfn, SUBSTYPE_STRING_ALLOC },
+
          { 0, NULL, (int *)MDFN_Internal_Args, 0, 0},
 
 	 { "connect", _("Connect to the remote server and start network play."), &netconnect, 0, 0 },
@@ -725,7 +738,15 @@ static int DoArgs(int argc, char *argv[], char **filename)
 	 if(dmfn)
 	  MDFNI_DumpModulesDef(dmfn);
 
-	 if(dsfn || dmfn)
+	 if(hcdfn)
+	 {
+	  if(*filename == NULL)
+	   MDFN_PrintError(_("No CD image filename specified to convert!"));
+	  else
+	   MDFNI_ConvertCDImage(*filename, hcdfn);
+	 }
+
+	 if(dsfn || dmfn || hcdfn)
 	  return(0);
 
 	 if(*filename == NULL && loadcd == NULL && physcd == 0)
@@ -930,34 +951,12 @@ void DoFrameAdvance(void)
 
 static int GameLoopPaused = 0;
 
+static void PassRedraw(void);
+
 void DebuggerFudge(void)
 {
-#if 0
-	  bool VBValid = true;
-
-	  if(VTDisplayRects[VTBackBuffer].h == 0 || ((int64)VTDisplayRects[VTBackBuffer].y + VTDisplayRects[VTBackBuffer].h) > VTBuffer[VTBackBuffer]->h)
-	   VBValid = false;
-	  else if(VTLineWidths[VTBackBuffer][0].w != ~0)
-	  {
-	   for(int32 y = VTDisplayRects[VTBackBuffer].y; y < (VTDisplayRects[VTBackBuffer].y + VTDisplayRects[VTBackBuffer].h); y++)
-	   {
-	    if(VTLineWidths[VTBackBuffer][y].w == 0 || ((int64)VTLineWidths[VTBackBuffer][y].x + VTLineWidths[VTBackBuffer][y].w) > VTBuffer[VTBackBuffer]->w)
-	    {
-	     VBValid = false;
-	     break;
-	    }
-	   }
-	  }
-	  else if(VTDisplayRects[VTBackBuffer].w == 0 || ((int64)VTDisplayRects[VTBackBuffer].x + VTDisplayRects[VTBackBuffer].w) > VTBuffer[VTBackBuffer]->w)
-	   VBValid = false;
-
-	  if(VBValid)
-           MDFND_Update((MDFN_Surface *)VTBuffer[VTBackBuffer], (MDFN_Rect*)&VTDisplayRects[VTBackBuffer], (MDFN_Rect*)VTLineWidths[VTBackBuffer], NULL, 0);
-	  else
-#endif
-	  {
-	   MDFND_Update((MDFN_Surface *)VTBuffer[VTBackBuffer ^ 1], (MDFN_Rect*)&VTDisplayRects[VTBackBuffer ^ 1], (MDFN_Rect*)VTLineWidths[VTBackBuffer ^ 1], NULL, 0);
-	  }
+	  PassRedraw();
+	  MDFND_Update(NULL, NULL, NULL, NULL, 0);
 
 	  if(sound_active)
 	   WriteSoundSilence(10);
@@ -1044,16 +1043,17 @@ int GameLoop(void *arg)
          if(NoWaiting)
 	  fskip = 1;
 
-	 VTLineWidths[VTBackBuffer][0].w = ~0;
+	 const unsigned ThisBackBuffer = VTFrames.BackIndex();
+	 bool Published = false;
 
-	 int ThisBackBuffer = VTBackBuffer;
+	 VTLineWidths[ThisBackBuffer][0].w = ~0;
 
 	 {
 	  EmulateSpecStruct espec;
  	  memset(&espec, 0, sizeof(EmulateSpecStruct));
 
-          espec.surface = (MDFN_Surface *)VTBuffer[VTBackBuffer];
-          espec.LineWidths = (MDFN_Rect *)VTLineWidths[VTBackBuffer];
+          espec.surface = VTBuffer[ThisBackBuffer];
+          espec.LineWidths = VTLineWidths[ThisBackBuffer];
 	  espec.skip = fskip;
 	  espec.soundmultiplier = CurGameSpeed;
 	  espec.NeedRewind = DNeedRewind;
@@ -1077,7 +1077,7 @@ int GameLoop(void *arg)
 
 	  //printf("%lld %f\n", (long long)(after_time - before_time), average_time);
 
-	  VTDisplayRects[VTBackBuffer] = espec.DisplayRect;
+	  VTDisplayRects[ThisBackBuffer] = espec.DisplayRect;
 
 	  sound = espec.SoundBuf + (espec.SoundBufSizeALMS * CurGame->soundchan);
 	  ssize = espec.SoundBufSize - espec.SoundBufSizeALMS;
@@ -1089,26 +1089,19 @@ int GameLoop(void *arg)
 
 	 do
 	 {
-	  VTBackBuffer = ThisBackBuffer;
-
- 	  if(fskip && GameLoopPaused)
+ 	  if(Published || (fskip && GameLoopPaused))
 	  {
-	   // If this frame was skipped, and the game loop is paused(IE cheat interface is active), just blit the previous "successful" frame so the cheat
-	   // interface actually gets drawn.
+	   // The game loop is paused(IE cheat interface is active), or we're waiting in frame advance mode, and this frame was either skipped or
+	   // already handed off; have the main thread blit the newest frame it has again, so the cheat interface actually gets drawn.
 	   //
-	   // Needless to say, do not do "VTBackBuffer ^= 1;" here.
+	   // This relies on there always being a previous frame to blit, which there is since we initialize all the video buffers and rect
+	   // structures during startup.
 	   //
-	   // Possible problems with this kludgery:
-	   //	Will fail spectacularly if there is no previous successful frame.  BOOOOOOM.  (But there always should be, especially since we initialize some
-  	   //   of the video buffer and rect structures during startup)
-	   //
-           MDFND_Update((MDFN_Surface *)VTBuffer[VTBackBuffer ^ 1], (MDFN_Rect*)&VTDisplayRects[VTBackBuffer ^ 1], (MDFN_Rect*)VTLineWidths[VTBackBuffer ^ 1], sound, ssize);
+	   PassRedraw();
+           MDFND_Update(NULL, NULL, NULL, sound, ssize);
 	  }
 	  else
-	  {
-           if(MDFND_Update(fskip ? NULL : (MDFN_Surface *)VTBuffer[VTBackBuffer], (MDFN_Rect*)&VTDisplayRects[VTBackBuffer], (MDFN_Rect*)VTLineWidths[VTBackBuffer], sound, ssize))
-	    VTBackBuffer ^= 1;
-	  }
+	   Published = MDFND_Update(fskip ? NULL : VTBuffer[ThisBackBuffer], &VTDisplayRects[ThisBackBuffer], VTLineWidths[ThisBackBuffer], sound, ssize);
 
 	  FPS_UpdateCalc();
 
@@ -1689,10 +1682,10 @@ int main(int argc, char *argv[])
 
 	VTMutex = SDL_CreateMutex();
         EVMutex = SDL_CreateMutex();
+	VTFrameSem = SDL_CreateSemaphore(0);
 
-	VTReady = NULL;
-	VTDRReady = NULL;
-	VTLWReady = NULL;
+	VTFrames.Reset();
+	VTRedraw = 0;
 
 	NeedVideoChange = -1;
 
@@ -1718,17 +1711,15 @@ int main(int argc, char *argv[])
 	 //uint32 pitch32 = round_up_pow2(CurGame->fb_width);
 	 MDFN_PixelFormat nf(MDFN_COLORSPACE_RGB, 0, 8, 16, 24);
 
-	 VTBuffer[0] = new MDFN_Surface(NULL, CurGame->fb_width, CurGame->fb_height, pitch32, nf);
-         VTBuffer[1] = new MDFN_Surface(NULL, CurGame->fb_width, CurGame->fb_height, pitch32, nf);
-         VTLineWidths[0] = (MDFN_Rect *)calloc(CurGame->fb_height, sizeof(MDFN_Rect));
-         VTLineWidths[1] = (MDFN_Rect *)calloc(CurGame->fb_height, sizeof(MDFN_Rect));
-
-         for(int i = 0; i < 2; i++)
+         for(int i = 0; i < 3; i++)
 	 {
-          ((MDFN_Surface *)VTBuffer[i])->Fill(0, 0, 0, 0);
+	  VTBuffer[i] = new MDFN_Surface(NULL, CurGame->fb_width, CurGame->fb_height, pitch32, nf);
+          VTLineWidths[i] = (MDFN_Rect *)calloc(CurGame->fb_height, sizeof(MDFN_Rect));
+
+          VTBuffer[i]->Fill(0, 0, 0, 0);
 
 	  //
-	  // Debugger step mode, and cheat interface, rely on the previous backbuffer being valid in certain situations.  Initialize some stuff here so that
+	  // Debugger step mode, and cheat interface, rely on the main thread's current frame being valid in certain situations.  Initialize some stuff here so that
 	  // reliance will still work even immediately after startup.
 	  VTDisplayRects[i].w = std::min<int32>(16, VTBuffer[i]->w);
 	  VTDisplayRects[i].h = std::min<int32>(16, VTBuffer[i]->h);
@@ -1778,18 +1769,24 @@ int main(int argc, char *argv[])
           NeedVideoChange = 0;
          }
 
-         if(VTReady)
          {
-	  //static int last_time;
-	  //int curtime;
+	  const bool redraw = __atomic_exchange_n(&VTRedraw, 0, __ATOMIC_ACQ_REL);
+	  uint32 flags = 0;
 
-          BlitScreen(VTReady, VTDRReady, VTLWReady, VTSSnapshot);
+          if(VTFrames.Acquire(&flags) || redraw)
+          {
+	   const unsigned fb = VTFrames.FrontIndex();
+	   //static int last_time;
+	   //int curtime;
 
-          //curtime = SDL_GetTicks();
-          //printf("%d\n", curtime - last_time);
-          //last_time = curtime;
+           BlitScreen(VTBuffer[fb], &VTDisplayRects[fb], VTLineWidths[fb], (bool)(flags & VTF_SSNAPSHOT));
 
-          VTReady = NULL;	// Set to NULL after we're done blitting everything(including on-screen display stuff), and NOT just the emulated system's video surface.
+           //curtime = SDL_GetTicks();
+           //printf("%d\n", curtime - last_time);
+           //last_time = curtime;
+
+	   __atomic_add_fetch(&VTBlitCount, 1, __ATOMIC_RELEASE);
+          }
          }
 
 	 PumpWrap();
@@ -1797,15 +1794,19 @@ int main(int argc, char *argv[])
 	  SendCEvent_to_GT(CEVT_SET_INPUT_FOCUS, (char*)0 + (bool)(SDL_GetAppState() & SDL_APPINPUTFOCUS), NULL);
 
          SDL_mutexV(VTMutex);   /* Unlock mutex */
-         SDL_Delay(1);
+
+	 // Wake up as soon as the game thread has a new frame for us, but keep pumping events regardless.
+         SDL_SemWaitTimeout(VTFrameSem, 1);
 	}
 
 	CloseGame();
 
 	SDL_DestroyMutex(VTMutex);
         SDL_DestroyMutex(EVMutex);
+	SDL_DestroySemaphore(VTFrameSem);
+	VTFrameSem = NULL;
 
-	for(int x = 0; x < 2; x++)
+	for(int x = 0; x < 3; x++)
 	{
 	 if(VTBuffer[x])
 	 {
@@ -1842,6 +1843,7 @@ int main(int argc, char *argv[])
 
 
 static uint32 last_btime = 0;
+static uint32 last_blit_count = 0;
 static void UpdateSoundSync(int16 *Buffer, int Count)
 {
  if(Count)
@@ -1901,40 +1903,52 @@ void MDFND_MidSync(const EmulateSpecStruct *espec)
  MDFND_UpdateInput(true, false);
 }
 
+// "surface", "rect", and "lw" are always those of VTFrames.BackIndex().
 static bool PassBlit(MDFN_Surface *surface, MDFN_Rect *rect, MDFN_Rect *lw)
 {
- bool ret = false;
+ if(!surface)
+  return(false);
 
-  /* If it's been >= 100ms since the last blit, assume that the blit
-     thread is being time-slice starved, and let it run.  This is especially necessary
-     for fast-forwarding to respond well(since keyboard updates are
-     handled in the main thread) on slower systems or when using a higher fast-forwarding speed ratio.
-  */
- if(surface)
- {
-  if((last_btime + 100) < SDL_GetTicks() || pending_ssnapshot)
-  {
-   //puts("Eep");
-   while(VTReady && GameThreadRun) SDL_Delay(1);
-  }
+ Debugger_GTR_PassBlit();
 
-  if(!VTReady)
-  {
-   Debugger_GTR_PassBlit();	// Call before the VTReady = surface
+ // If the previous frame was never picked up, the main thread hasn't gotten around to it yet and will see this one instead; no need to wake it
+ // up again.
+ if(!VTFrames.Publish(pending_ssnapshot ? VTF_SSNAPSHOT : 0))
+  SDL_SemPost(VTFrameSem);
+
+ pending_ssnapshot = 0;
 
-   VTSSnapshot = pending_ssnapshot;
-   VTLWReady = lw;
-   VTDRReady = rect;
-   VTReady = surface;
-   ret = true;
+ {
+  const uint32 blit_count = __atomic_load_n(&VTBlitCount, __ATOMIC_ACQUIRE);
 
-   pending_ssnapshot = 0;
+  if(blit_count != last_blit_count)
+  {
+   last_blit_count = blit_count;
    last_btime = SDL_GetTicks();
    FPS_IncBlitted();
   }
+  else if((last_btime + 100) < SDL_GetTicks())
+  {
+   /* If it's been >= 100ms since the last blit, assume that the blit
+      thread is being time-slice starved, and give it a chance to run.  This is especially necessary
+      for fast-forwarding to respond well(since keyboard updates are
+      handled in the main thread) on slower systems or when using a higher fast-forwarding speed ratio.
+   */
+   SDL_Delay(1);
+  }
  }
 
- return(ret);
+ return(true);
+}
+
+// Have the main thread blit its current frame again, along with a fresh debugger overlay.
+static void PassRedraw(void)
+{
+ Debugger_GT_Draw();
+ Debugger_GTR_PassBlit();
+
+ if(!__atomic_exchange_n(&VTRedraw, 1, __ATOMIC_ACQ_REL))
+  SDL_SemPost(VTFrameSem);
 }
 
 
@@ -2020,6 +2034,11 @@ struct MDFN_Mutex
  SDL_mutex *sdl_mutex;
 };
 
+struct MDFN_Cond
+{
+ SDL_cond *sdl_cond;
+};
+
 MDFN_Thread *MDFND_CreateThread(int (*fn)(void *), void *data)
 {
  MDFN_Thread *thread;
@@ -2075,3 +2094,35 @@ int MDFND_UnlockMutex(MDFN_Mutex *mutex)
  return SDL_mutexV(mutex->sdl_mutex);
 }
 
+MDFN_Cond *MDFND_CreateCond(void)
+{
+ MDFN_Cond *cond;
+
+ if(!(cond = (MDFN_Cond *)calloc(1, sizeof(MDFN_Cond))))
+  return(NULL);
+
+ if(!(cond->sdl_cond = SDL_CreateCond()))
+ {
+  free(cond);
+  return(NULL);
+ }
+
+ return(cond);
+}
+
+void MDFND_DestroyCond(MDFN_Cond *cond)
+{
+ SDL_DestroyCond(cond->sdl_cond);
+ free(cond);
+}
+
+int MDFND_SignalCond(MDFN_Cond *cond)
+{
+ return SDL_CondSignal(cond->sdl_cond);
+}
+
+int MDFND_WaitCond(MDFN_Cond *cond, MDFN_Mutex *mutex)
+{
+ return SDL_CondWait(cond->sdl_cond, mutex->sdl_mutex);
+}
+
@@ -0,0 +1,488 @@
+/* Mednafen - Multi-system Emulator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+// Headless benchmark driver("mednafen-bench").  Loads a game through the normal MDFNI_* interface, runs it for a fixed number of
+// frames as fast as possible with no video, audio, or throttling, and reports frame-time statistics plus MD5 hashes of the final frame and
+// of all generated audio, so that performance changes can be measured and checked for output regressions on any emulation module.
+//
+// Usage: mednafen-bench [options] <game path>
+//  -frames N		Number of frames to emulate(default 3600).
+//  -skip 0|1		Set EmulateSpecStruct::skip on every frame except the last one(default 0).
+//  -nosound		Don't request audio from the emulation module.
+//  -module NAME		Force the emulation module, as for the SDL driver's -force_module.
+//  -basedir PATH	Base directory(firmware, settings file); defaults to $MEDNAFEN_HOME or ~/.mednafen.
+//  -input none|cycle|random	Scripted input: nothing pressed, one button at a time, or pseudo-random buttons.
+//  -input_period N	Frames between scripted input changes(default 8).
+//  -expect_video_hash MD5	Exit with status 1 if the final frame's hash doesn't match.
+//  -expect_audio_hash MD5	Exit with status 1 if the audio hash doesn't match.
+//  -qtrecord PATH	Record a QuickTime movie while running, to measure recording overhead("qtrecord.*" settings apply).
+//
+// The MDFND_* driver functions, threads included, come from the same stubs.cpp and thread.cpp the OpenEmu core uses, so this needs
+// nothing but the emulation core to build.
+//
+
+#include "../driver.h"
+#include "../mednafen.h"
+#include "../md5.h"
+#include "../cdrom/cdromif.h"
+#include "../endian.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+#include <vector>
+#include <string>
+#include <algorithm>
+
+// Microseconds, monotonic where the platform allows it.
+static int64 Time64(void)
+{
+ #ifdef WIN32
+ static LARGE_INTEGER freq;
+ LARGE_INTEGER count;
+
+ if(!freq.QuadPart)
+  QueryPerformanceFrequency(&freq);
+
+ QueryPerformanceCounter(&count);
+
+ return((int64)((double)count.QuadPart * 1000000 / freq.QuadPart));
+ #else
+ #if HAVE_CLOCK_GETTIME && ( _POSIX_MONOTONIC_CLOCK > 0 || defined(CLOCK_MONOTONIC))
+ struct timespec tp;
+
+ if(clock_gettime(CLOCK_MONOTONIC, &tp) != -1)
+  return((int64)tp.tv_sec * 1000000 + tp.tv_nsec / 1000);
+ #endif
+
+ struct timeval tv;
+
+ gettimeofday(&tv, NULL);
+
+ return((int64)tv.tv_sec * 1000000 + tv.tv_usec);
+ #endif
+}
+
+static char *GetBaseDirectory(void)
+{
+ char *ol;
+ char *ret;
+
+ ol = getenv("MEDNAFEN_HOME");
+ if(ol != NULL && ol[0] != 0)
+ {
+  ret = strdup(ol);
+  return(ret);
+ }
+
+ ol = getenv("HOME");
+
+ if(ol)
+ {
+  ret=(char *)malloc(strlen(ol)+1+strlen(PSS ".mednafen"));
+  strcpy(ret,ol);
+  strcat(ret,PSS ".mednafen");
+  return(ret);
+ }
+
+ return(strdup(""));
+}
+
+//
+// Scripted input.
+//
+enum
+{
+ INPUT_NONE = 0,
+ INPUT_CYCLE,
+ INPUT_RANDOM
+};
+
+struct BenchPort
+{
+ std::vector<uint8> data;
+ std::vector<uint32> button_bits;	// Bit offsets of the digital buttons in "data".
+};
+
+static void BuildPort(MDFNGI *gi, unsigned port, BenchPort *bp)
+{
+ const InputPortInfoStruct *pi = &gi->InputInfo->Types[port];
+ const InputDeviceInfoStruct *zedevice = &pi->DeviceInfo[0];
+ uint32 bit_offset = 0;
+
+ for(int i = 0; i < pi->NumTypes; i++)
+ {
+  if(pi->DefaultDevice && !strcasecmp(pi->DeviceInfo[i].ShortName, pi->DefaultDevice))
+  {
+   zedevice = &pi->DeviceInfo[i];
+   break;
+  }
+ }
+
+ // Same data layout as the SDL driver's BuildPortInfo().
+ for(int x = 0; x < zedevice->NumInputs; x++)
+ {
+  const InputDeviceInputInfoStruct *idii = &zedevice->IDII[x];
+
+  switch(idii->Type)
+  {
+   case IDIT_BUTTON:
+   case IDIT_BUTTON_CAN_RAPID:
+	if(idii->SettingName != NULL)
+	 bp->button_bits.push_back(bit_offset);
+	bit_offset += 1;
+	break;
+
+   case IDIT_BYTE_SPECIAL:
+	bit_offset += 8;
+	break;
+
+   default:	// Analog buttons, axes, and misc, uint32.
+	bit_offset = ((bit_offset + 31) &~ 31) + 32;
+	break;
+  }
+ }
+
+ bp->data.assign((bit_offset + 7) / 8, 0);
+
+ MDFNI_SetInput(port, zedevice->ShortName, bp->data.size() ? &bp->data[0] : NULL, bp->data.size());
+
+ printf("Port %u: %s(%u buttons)\n", port, zedevice->ShortName, (unsigned)bp->button_bits.size());
+}
+
+static void UpdatePorts(std::vector<BenchPort> &ports, int mode, uint64 step, uint32 *lfsr)
+{
+ uint32 cycle_index = step;
+
+ for(unsigned port = 0; port < ports.size(); port++)
+ {
+  BenchPort *bp = &ports[port];
+
+  if(bp->data.size())
+   memset(&bp->data[0], 0, bp->data.size());
+
+  for(unsigned b = 0; b < bp->button_bits.size(); b++)
+  {
+   bool pressed;
+
+   if(mode == INPUT_CYCLE)
+    pressed = (cycle_index == b);
+   else
+   {
+    *lfsr = (*lfsr >> 1) ^ (-(*lfsr & 1) & 0xD0000001U);
+    pressed = (*lfsr & 0x3) == 0;
+   }
+
+   if(pressed)
+    bp->data[bp->button_bits[b] >> 3] |= 1 << (bp->button_bits[b] & 7);
+  }
+
+  if(cycle_index >= bp->button_bits.size())
+   cycle_index -= bp->button_bits.size();
+  else
+   cycle_index = ~0U;
+ }
+}
+
+static uint32 CountButtons(const std::vector<BenchPort> &ports)
+{
+ uint32 ret = 0;
+
+ for(unsigned port = 0; port < ports.size(); port++)
+  ret += ports[port].button_bits.size();
+
+ return(ret);
+}
+
+static std::string HashFrame(const EmulateSpecStruct *espec, const MDFN_Rect *LineWidths)
+{
+ const MDFN_Surface *surface = espec->surface;
+ const MDFN_Rect *DisplayRect = &espec->DisplayRect;
+ md5_context md5;
+ uint8 digest[16];
+
+ md5.starts();
+
+ for(int32 y = DisplayRect->y; y < DisplayRect->y + DisplayRect->h; y++)
+ {
+  const uint32 *row = surface->pixels + y * surface->pitch32;
+  int32 x = DisplayRect->x;
+  int32 w = DisplayRect->w;
+
+  if(LineWidths[0].w != ~0)
+  {
+   x = LineWidths[y].x;
+   w = LineWidths[y].w;
+  }
+
+  md5.update_u32_as_lsb(w);
+
+  for(int32 i = 0; i < w; i++)
+   md5.update_u32_as_lsb(row[x + i]);
+ }
+
+ md5.finish(digest);
+
+ return(md5_context::asciistr(digest, 0));
+}
+
+static int64 Percentile(const std::vector<uint32> &sorted, unsigned pct)
+{
+ if(!sorted.size())
+  return(0);
+
+ return(sorted[std::min<size_t>(sorted.size() - 1, (uint64)sorted.size() * pct / 100)]);
+}
+
+int main(int argc, char *argv[])
+{
+ const char *game_path = NULL;
+ const char *force_module = NULL;
+ const char *expect_video_hash = NULL;
+ const char *expect_audio_hash = NULL;
+ const char *qtrecord_path = NULL;
+ char *basedir = NULL;
+ uint32 num_frames = 3600;
+ int skip = 0;
+ bool sound = true;
+ int input_mode = INPUT_NONE;
+ uint32 input_period = 8;
+ int ret = 0;
+
+ for(int i = 1; i < argc; i++)
+ {
+  const char *arg = argv[i];
+  const char *val = (i + 1) < argc ? argv[i + 1] : NULL;
+
+  if(arg[0] != '-')
+  {
+   game_path = arg;
+   continue;
+  }
+
+  if(!strcmp(arg, "-nosound"))
+  {
+   sound = false;
+   continue;
+  }
+
+  if(!val)
+  {
+   fprintf(stderr, "Missing value for option \"%s\".\n", arg);
+   return(-1);
+  }
+  i++;
+
+  if(!strcmp(arg, "-frames"))
+   num_frames = strtoul(val, NULL, 10);
+  else if(!strcmp(arg, "-skip"))
+   skip = atoi(val);
+  else if(!strcmp(arg, "-module"))
+   force_module = val;
+  else if(!strcmp(arg, "-basedir"))
+   basedir = strdup(val);
+  else if(!strcmp(arg, "-input_period"))
+   input_period = std::max<uint32>(1, strtoul(val, NULL, 10));
+  else if(!strcmp(arg, "-expect_video_hash"))
+   expect_video_hash = val;
+  else if(!strcmp(arg, "-expect_audio_hash"))
+   expect_audio_hash = val;
+  else if(!strcmp(arg, "-qtrecord"))
+   qtrecord_path = val;
+  else if(!strcmp(arg, "-input"))
+  {
+   if(!strcasecmp(val, "none"))
+    input_mode = INPUT_NONE;
+   else if(!strcasecmp(val, "cycle"))
+    input_mode = INPUT_CYCLE;
+   else if(!strcasecmp(val, "random"))
+    input_mode = INPUT_RANDOM;
+   else
+   {
+    fprintf(stderr, "Unknown input mode \"%s\".\n", val);
+    return(-1);
+   }
+  }
+  else
+  {
+   fprintf(stderr, "Unknown option \"%s\".\n", arg);
+   return(-1);
+  }
+ }
+
+ if(!game_path)
+ {
+  fprintf(stderr, "Usage: %s [-frames N] [-skip 0|1] [-nosound] [-module NAME] [-basedir PATH] [-input none|cycle|random] [-input_period N] [-expect_video_hash MD5] [-expect_audio_hash MD5] [-qtrecord PATH] <game path>\n", argv[0]);
+  return(-1);
+ }
+
+ if(!basedir)
+  basedir = GetBaseDirectory();
+
+ std::vector<MDFNGI *> ExternalSystems;
+ std::vector<MDFNSetting> DriverSettings;
+
+ if(!MDFNI_InitializeModules(ExternalSystems) || !MDFNI_Initialize(basedir, DriverSettings))
+  return(-1);
+
+ MDFNGI *gi = MDFNI_LoadGame(force_module, game_path);
+
+ if(!gi)
+ {
+  MDFNI_Kill();
+  return(-1);
+ }
+
+ printf("Module: %s, %u frames\n", gi->shortname, num_frames);
+
+ if(qtrecord_path && !MDFNI_StartAVRecord(qtrecord_path, sound ? 48000 : 0))
+ {
+  MDFNI_CloseGame();
+  MDFNI_Kill();
+  return(-1);
+ }
+
+ std::vector<BenchPort> ports(gi->InputInfo ? gi->InputInfo->InputPorts : 0);
+ uint32 lfsr = 0x1;
+ uint64 input_step = 0;
+
+ for(unsigned port = 0; port < ports.size(); port++)
+  BuildPort(gi, port, &ports[port]);
+
+ const uint32 total_buttons = CountButtons(ports);
+
+ MDFN_Surface *surface = new MDFN_Surface(NULL, gi->fb_width, gi->fb_height, gi->fb_width, MDFN_PixelFormat(MDFN_COLORSPACE_RGB, 0, 8, 16, 24));
+ std::vector<MDFN_Rect> LineWidths(gi->fb_height);
+ std::vector<int16> SoundBuf(sound ? 0x10000 : 0);
+ std::vector<uint32> frame_times;
+ md5_context audio_md5;
+ uint8 digest[16];
+ uint64 total_master_cycles = 0;
+ uint64 total_audio_frames = 0;
+ EmulateSpecStruct espec;
+ std::string video_hash;
+
+ frame_times.reserve(num_frames);
+ audio_md5.starts();
+
+ const int64 start_time = Time64();
+
+ for(uint32 frame = 0; frame < num_frames; frame++)
+ {
+  if(input_mode != INPUT_NONE && total_buttons && !(frame % input_period))
+  {
+   UpdatePorts(ports, input_mode, input_step % total_buttons, &lfsr);
+   input_step++;
+  }
+
+  memset(&espec, 0, sizeof(EmulateSpecStruct));
+
+  LineWidths[0].w = ~0;
+
+  espec.surface = surface;
+  espec.LineWidths = &LineWidths[0];
+  espec.skip = (skip && (frame + 1) != num_frames);
+  espec.SoundRate = sound ? 48000 : 0;
+  espec.SoundBuf = sound ? &SoundBuf[0] : NULL;
+  espec.SoundBufMaxSize = SoundBuf.size() / 2;
+  espec.SoundVolume = 1.0;
+  espec.soundmultiplier = 1.0;
+
+  const int64 before_time = Time64();
+
+  MDFNI_Emulate(&espec);
+
+  frame_times.push_back(Time64() - before_time);
+
+  total_master_cycles += espec.MasterCycles;
+
+  if(sound && espec.SoundBufSize > 0)
+  {
+   const uint32 count = espec.SoundBufSize * gi->soundchan;
+
+   for(uint32 i = 0; i < count; i++)
+   {
+    uint8 le[2];
+
+    MDFN_en16lsb(le, espec.SoundBuf[i]);
+    audio_md5.update(le, 2);
+   }
+   total_audio_frames += espec.SoundBufSize;
+  }
+ }
+
+ const int64 elapsed_time = std::max<int64>(1, Time64() - start_time);
+
+ if(num_frames)
+  video_hash = HashFrame(&espec, &LineWidths[0]);
+
+ audio_md5.finish(digest);
+
+ const std::string audio_hash = md5_context::asciistr(digest, 0);
+ const double elapsed_seconds = (double)elapsed_time / 1000000;
+ const double master_clock = (double)gi->MasterClock / MDFN_MASTERCLOCK_FIXED(1);
+
+ std::sort(frame_times.begin(), frame_times.end());
+
+ printf("Elapsed: %.3f seconds, %.2f frames/second\n", elapsed_seconds, num_frames / elapsed_seconds);
+ printf("Frame time: p50 %lld us, p99 %lld us, max %lld us\n", (long long)Percentile(frame_times, 50), (long long)Percentile(frame_times, 99), (long long)(frame_times.size() ? frame_times.back() : 0));
+ printf("Emulated: %.3f seconds, %.0f master cycles/second, %.2fx realtime\n", total_master_cycles / master_clock, total_master_cycles / elapsed_seconds,
+	(total_master_cycles / master_clock) / elapsed_seconds);
+ printf("Video hash: %s\n", video_hash.c_str());
+ printf("Audio hash: %s(%llu frames)\n", audio_hash.c_str(), (unsigned long long)total_audio_frames);
+
+ {
+  CDIF_CacheStats cs;
+
+  if(MDFNI_GetCDCacheStats(&cs))
+   printf("CD read-ahead: %llu hits, %llu misses, %llu ms stalled\n", (unsigned long long)cs.hits, (unsigned long long)cs.misses, (unsigned long long)cs.stall_ms);
+ }
+
+ if(expect_video_hash && strcasecmp(expect_video_hash, video_hash.c_str()))
+ {
+  fprintf(stderr, "Video hash mismatch; expected %s\n", expect_video_hash);
+  ret = 1;
+ }
+
+ if(expect_audio_hash && strcasecmp(expect_audio_hash, audio_hash.c_str()))
+ {
+  fprintf(stderr, "Audio hash mismatch; expected %s\n", expect_audio_hash);
+  ret = 1;
+ }
+
+ if(qtrecord_path)
+  MDFNI_StopAVRecord();
+
+ MDFNI_CloseGame();
+ delete surface;
+
+ MDFNI_Kill();
+ free(basedir);
+
+ return(ret);
+}
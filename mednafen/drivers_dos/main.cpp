@@ -844,6 +844,26 @@ int MDFND_UnlockMutex(MDFN_Mutex *mutex)
  return(false);
 }
 
+MDFN_Cond *MDFND_CreateCond(void)
+{
+ return(NULL);
+}
+
+void MDFND_DestroyCond(MDFN_Cond *cond)
+{
+
+}
+
+int MDFND_SignalCond(MDFN_Cond *cond)
+{
+ return(false);
+}
+
+int MDFND_WaitCond(MDFN_Cond *cond, MDFN_Mutex *mutex)
+{
+ return(false);
+}
+
 
 int MDFND_NetworkConnect(void)
 {
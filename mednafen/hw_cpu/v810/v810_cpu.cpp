@@ -80,6 +80,7 @@ V810::V810()
  IOWrite32 = NULL;
 
  memset(FastMap, 0, sizeof(FastMap));
+ memset(FastMapDirect, 0, sizeof(FastMapDirect));
 
  memset(MemReadBus32, 0, sizeof(MemReadBus32));
  memset(MemWriteBus32, 0, sizeof(MemWriteBus32));
@@ -325,6 +326,8 @@ bool V810::Init(V810_Emu_Mode mode, bool vb_mode)
  in_bstr = FALSE;
  in_bstr_to = 0;
 
+ memset(FastMapDirect, 0, sizeof(FastMapDirect));
+
  if(mode == V810_EMU_MODE_FAST)
  {
   memset(DummyRegion, 0, V810_FAST_MAP_PSIZE);
@@ -348,6 +351,8 @@ void V810::Kill(void)
   MDFN_free(FastMapAllocList[i]);
 
  FastMapAllocList.clear();
+
+ memset(FastMapDirect, 0, sizeof(FastMapDirect));
 }
 
 void V810::SetInt(int level)
@@ -358,10 +363,12 @@ void V810::SetInt(int level)
  RecalcIPendingCache();
 }
 
-uint8 *V810::SetFastMap(uint32 addresses[], uint32 length, unsigned int num_addresses, const char *name)
+uint8 *V810::SetFastMap(uint32 addresses[], uint32 length, unsigned int num_addresses, const char *name, unsigned int direct, unsigned int direct_wait)
 {
  uint8 *ret = NULL;
 
+ assert(direct_wait < (256 >> V810_FAST_MAP_DIRECT_WAIT_SHIFT));
+
  for(unsigned int i = 0; i < num_addresses; i++)
  {
   assert((addresses[i] & (V810_FAST_MAP_PSIZE - 1)) == 0);
@@ -386,6 +393,7 @@ uint8 *V810::SetFastMap(uint32 addresses[], uint32 length, unsigned int num_addr
    //printf("%08x, %d, %s\n", addr, length, name);
 
    FastMap[addr / V810_FAST_MAP_PSIZE] = ret - addresses[i];
+   FastMapDirect[addr / V810_FAST_MAP_PSIZE] = direct | (direct_wait << V810_FAST_MAP_DIRECT_WAIT_SHIFT);
   }
  }
 
@@ -492,6 +500,85 @@ void V810::CheckBreakpoints(void (*callback)(int type, uint32 address, uint32 va
 }
 #endif
 
+// LD/ST data accesses; see SetFastMap().
+INLINE uint8 V810::DataRead8(v810_timestamp_t &timestamp, uint32 A)
+{
+ const uint8 direct = FastMapDirect[A >> V810_FAST_MAP_SHIFT];
+
+ if(direct & V810_FAST_MAP_DIRECT_READ)
+ {
+  timestamp += direct >> V810_FAST_MAP_DIRECT_WAIT_SHIFT;
+  return(FastMap[A >> V810_FAST_MAP_SHIFT][A]);
+ }
+
+ return(MemRead8(timestamp, A));
+}
+
+INLINE uint16 V810::DataRead16(v810_timestamp_t &timestamp, uint32 A)
+{
+ const uint8 direct = FastMapDirect[A >> V810_FAST_MAP_SHIFT];
+
+ if(direct & V810_FAST_MAP_DIRECT_READ)
+ {
+  timestamp += direct >> V810_FAST_MAP_DIRECT_WAIT_SHIFT;
+  return(LoadU16_LE((uint16 *)&FastMap[A >> V810_FAST_MAP_SHIFT][A]));
+ }
+
+ return(MemRead16(timestamp, A));
+}
+
+INLINE uint32 V810::DataRead32(v810_timestamp_t &timestamp, uint32 A)
+{
+ const uint8 direct = FastMapDirect[A >> V810_FAST_MAP_SHIFT];
+
+ if(direct & V810_FAST_MAP_DIRECT_READ)
+ {
+  timestamp += direct >> V810_FAST_MAP_DIRECT_WAIT_SHIFT;
+  return(LoadU32_LE((uint32 *)&FastMap[A >> V810_FAST_MAP_SHIFT][A]));
+ }
+
+ return(MemRead32(timestamp, A));
+}
+
+INLINE void V810::DataWrite8(v810_timestamp_t &timestamp, uint32 A, uint8 V)
+{
+ const uint8 direct = FastMapDirect[A >> V810_FAST_MAP_SHIFT];
+
+ if(direct & V810_FAST_MAP_DIRECT_WRITE)
+ {
+  timestamp += direct >> V810_FAST_MAP_DIRECT_WAIT_SHIFT;
+  FastMap[A >> V810_FAST_MAP_SHIFT][A] = V;
+ }
+ else
+  MemWrite8(timestamp, A, V);
+}
+
+INLINE void V810::DataWrite16(v810_timestamp_t &timestamp, uint32 A, uint16 V)
+{
+ const uint8 direct = FastMapDirect[A >> V810_FAST_MAP_SHIFT];
+
+ if(direct & V810_FAST_MAP_DIRECT_WRITE)
+ {
+  timestamp += direct >> V810_FAST_MAP_DIRECT_WAIT_SHIFT;
+  StoreU16_LE((uint16 *)&FastMap[A >> V810_FAST_MAP_SHIFT][A], V);
+ }
+ else
+  MemWrite16(timestamp, A, V);
+}
+
+INLINE void V810::DataWrite32(v810_timestamp_t &timestamp, uint32 A, uint32 V)
+{
+ const uint8 direct = FastMapDirect[A >> V810_FAST_MAP_SHIFT];
+
+ if(direct & V810_FAST_MAP_DIRECT_WRITE)
+ {
+  timestamp += direct >> V810_FAST_MAP_DIRECT_WAIT_SHIFT;
+  StoreU32_LE((uint32 *)&FastMap[A >> V810_FAST_MAP_SHIFT][A], V);
+ }
+ else
+  MemWrite32(timestamp, A, V);
+}
+
 #define SetPREG(n, val) { P_REG[n] = val; }
 
 INLINE void V810::SetSREG(v810_timestamp_t &timestamp, unsigned int which, uint32 value)
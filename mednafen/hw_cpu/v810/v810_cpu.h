@@ -14,6 +14,11 @@ typedef int32 v810_timestamp_t;
 #define V810_FAST_MAP_PSIZE     (1 << V810_FAST_MAP_SHIFT)
 #define V810_FAST_MAP_TRAMPOLINE_SIZE	1024
 
+// Flags for SetFastMap()'s "direct" argument.
+#define V810_FAST_MAP_DIRECT_READ	0x1
+#define V810_FAST_MAP_DIRECT_WRITE	0x2
+#define V810_FAST_MAP_DIRECT_WAIT_SHIFT	2	// Bits above the flags in FastMapDirect[] hold the wait states.
+
 // Exception codes
 enum
 {
@@ -166,7 +171,12 @@ class V810
  void SetIOWriteHandlers(void MDFN_FASTCALL (*write8)(v810_timestamp_t &, uint32, uint8), void MDFN_FASTCALL (*write16)(v810_timestamp_t &, uint32, uint16), void MDFN_FASTCALL (*write32)(v810_timestamp_t &, uint32, uint32));
 
  // Length specifies the number of bytes to map in, at each location specified by addresses[] (for mirroring)
- uint8 *SetFastMap(uint32 addresses[], uint32 length, unsigned int num_addresses, const char *name);
+ //
+ // "direct" is a mask of V810_FAST_MAP_DIRECT_* flags; LD/ST instructions that access the region with the corresponding direct flag
+ // set will read/write the memory directly instead of calling the MemRead*/MemWrite* handlers, adding "direct_wait"(< 64) cycles
+ // per access.  Only use it for plain RAM/ROM whose handlers have no side effects other than a fixed number of wait states(no
+ // page-miss penalties, no write protection, etc.); timing for the instruction itself is unchanged.
+ uint8 *SetFastMap(uint32 addresses[], uint32 length, unsigned int num_addresses, const char *name, unsigned int direct = 0, unsigned int direct_wait = 0);
 
  INLINE void ResetTS(v810_timestamp_t new_base_timestamp)
  {
@@ -309,8 +319,16 @@ class V810
  bool have_src_cache, have_dst_cache;
 
  uint8 *FastMap[(1ULL << 32) / V810_FAST_MAP_PSIZE];
+ uint8 FastMapDirect[(1ULL << 32) / V810_FAST_MAP_PSIZE];	// V810_FAST_MAP_DIRECT_* flags and wait states for each page.
  std::vector<void *> FastMapAllocList;
 
+ uint8 DataRead8(v810_timestamp_t &timestamp, uint32 A);
+ uint16 DataRead16(v810_timestamp_t &timestamp, uint32 A);
+ uint32 DataRead32(v810_timestamp_t &timestamp, uint32 A);
+ void DataWrite8(v810_timestamp_t &timestamp, uint32 A, uint8 V);
+ void DataWrite16(v810_timestamp_t &timestamp, uint32 A, uint16 V);
+ void DataWrite32(v810_timestamp_t &timestamp, uint32 A, uint32 V);
+
 
  #ifdef WANT_DEBUGGER
  void (*CPUHook)(const v810_timestamp_t timestamp, uint32 PC);
@@ -38,10 +38,11 @@ void MDFND_MidSync(const EmulateSpecStruct *espec);
 
 /* Being threading support. */
 // Mostly based off SDL's prototypes and semantics.
-// Driver code should actually define MDFN_Thread and MDFN_Mutex.
+// Driver code should actually define MDFN_Thread, MDFN_Mutex, and MDFN_Cond.
 
 struct MDFN_Thread;
 struct MDFN_Mutex;
+struct MDFN_Cond;
 
 MDFN_Thread *MDFND_CreateThread(int (*fn)(void *), void *data);
 void MDFND_WaitThread(MDFN_Thread *thread, int *status);
@@ -51,6 +52,13 @@ void MDFND_DestroyMutex(MDFN_Mutex *mutex);
 int MDFND_LockMutex(MDFN_Mutex *mutex);
 int MDFND_UnlockMutex(MDFN_Mutex *mutex);
 
+// MDFND_CreateCond() may return NULL if the driver doesn't support condition variables, in which case callers
+// should fall back to polling with MDFND_Sleep().
+MDFN_Cond *MDFND_CreateCond(void);
+void MDFND_DestroyCond(MDFN_Cond *cond);
+int MDFND_SignalCond(MDFN_Cond *cond);
+int MDFND_WaitCond(MDFN_Cond *cond, MDFN_Mutex *mutex);	// "mutex" must be locked by the caller.
+
 /* End threading support. */
 
 void MDFNI_Reset(void);
@@ -66,6 +74,15 @@ MDFNGI *MDFNI_LoadGame(const char *force_module, const char *path);
 */
 MDFNGI *MDFNI_LoadCD(const char *sysname, const char *devicename, const bool is_device);
 
+/* Converts a CD image(CUE, TOC, or CCD) into the compressed HCD format, and verifies the result.  "dest_path" must not exist.
+   Returns false on failure. */
+bool MDFNI_ConvertCDImage(const char *src_path, const char *dest_path);
+
+/* Sums the read-ahead cache statistics of the loaded game's CD interfaces into "stats".  Returns false(with "stats" zeroed) if none of them
+   keep statistics(e.g. no CD game is loaded, or the images are cached in memory). */
+struct CDIF_CacheStats;
+bool MDFNI_GetCDCacheStats(CDIF_CacheStats *stats);
+
 // Call this function as early as possible, even before MDFNI_Initialize()
 bool MDFNI_InitializeModules(const std::vector<MDFNGI *> &ExternalSystems);
 
@@ -52,12 +52,14 @@
 #include	"string/escape.h"
 
 #include	"cdrom/CDUtility.h"
+#include	"cdrom/CDAccess_HCD.h"
 
 static const char *CSD_forcemono = gettext_noop("Force monophonic sound output.");
 static const char *CSD_enable = gettext_noop("Enable (automatic) usage of this module.");
 static const char *CSD_tblur = gettext_noop("Enable video temporal blur(50/50 previous/current frame by default).");
 static const char *CSD_tblur_accum = gettext_noop("Accumulate color data rather than discarding it.");
 static const char *CSD_tblur_accum_amount = gettext_noop("Blur amount in accumulation mode, specified in percentage of accumulation buffer to mix with the current frame.");
+static const char *CSD_runahead = gettext_noop("Number of frames to speculatively run ahead of the real emulated frame, to hide game-internal input latency.");
 
 static MDFNSetting_EnumList CompressorList[] =
 {
@@ -91,12 +93,16 @@ static MDFNSetting MednafenSettings[] =
   { "netplay.localplayers", MDFNSF_NOFLAGS, gettext_noop("Local player count."), gettext_noop("Number of local players for network play.  This number is advisory to the server, and the server may assign fewer players if the number of players requested is higher than the number of controllers currently available."), MDFNST_UINT, "1", "0", "16" },
   { "netplay.nick", MDFNSF_NOFLAGS, gettext_noop("Nickname."), gettext_noop("Nickname to use for network play chat."), MDFNST_STRING, "" },
   { "netplay.gamekey", MDFNSF_NOFLAGS, gettext_noop("Key to hash with the MD5 hash of the game."), NULL, MDFNST_STRING, "" },
+  { "netplay.delta_state", MDFNSF_NOFLAGS, gettext_noop("Send save states as differences from the last synchronized state."), gettext_noop("Save states sent during network play are compressed faster, on multiple threads, and when possible only the difference from the last state every player has is sent.  All other players must be using a version of Mednafen that understands this format, so don't enable this to play with older versions."), MDFNST_BOOL, "0" },
 
   { "srwcompressor", MDFNSF_NOFLAGS, gettext_noop("Compressor to use with state rewinding"), NULL, MDFNST_ENUM, "quicklz", NULL, NULL, NULL, NULL, CompressorList },
 
   { "srwframes", MDFNSF_NOFLAGS, gettext_noop("Number of frames to keep states for when state rewinding is enabled."), 
 	gettext_noop("WARNING: Setting this to a large value may cause excessive RAM usage in some circumstances, such as with games that stream large volumes of data off of CDs."), MDFNST_UINT, "600", "10", "99999" },
 
+  { "srwmemory", MDFNSF_NOFLAGS, gettext_noop("Maximum amount of memory, in MiB, to use for compressed state rewinding data."),
+	gettext_noop("When this fills up, the oldest rewind data is discarded, even if fewer than \"srwframes\" frames are being kept."), MDFNST_UINT, "128", "8", "2048" },
+
   { "cd.image_memcache", MDFNSF_NOFLAGS, gettext_noop("Cache entire CD images in memory."), gettext_noop("Reads the entire CD image(s) into memory at startup(which will cause a small delay).  Can help obviate emulation hiccups due to emulated CD access.  May cause more harm than good on low memory systems, systems with swap enabled, and/or when the disc images in question are on a fast SSD."), MDFNST_BOOL, "0" },
 
   { "filesys.untrusted_fip_check", MDFNSF_NOFLAGS, gettext_noop("Enable untrusted file-inclusion path security check."),
@@ -122,6 +128,7 @@ static MDFNSetting MednafenSettings[] =
   { "qtrecord.h_double_threshold", MDFNSF_NOFLAGS, gettext_noop("Double the raw image's height if it's below this threshold."), NULL, MDFNST_UINT, "256", "0", "1073741824" },
 
   { "qtrecord.vcodec", MDFNSF_NOFLAGS, gettext_noop("Video codec to use."), NULL, MDFNST_ENUM, "cscd", NULL, NULL, NULL, NULL, VCodec_List },
+  { "qtrecord.threads", MDFNSF_NOFLAGS, gettext_noop("Number of video encoder threads."), gettext_noop("Frames are converted and compressed in parallel and written in order; the output is the same regardless of this setting.  0 encodes each frame on the emulation thread before emulation continues."), MDFNST_UINT, "2", "0", "16" },
   { NULL }
 };
 
@@ -184,6 +191,32 @@ static double last_sound_rate;
 static bool PrevInterlaced;
 static Deinterlacer deint;
 
+// Run-ahead; the state buffer and scratch sound buffer are kept around between frames so that there's no allocation in the steady state.
+static StateMem RunAheadState;
+static std::vector<int16> RunAheadSoundBuf;
+static bool RunAheadSpeculating = false;
+static bool RunAheadUsable;	// Cleared if the module turns out not to be able to save state.
+static bool RunAheadChecked;
+
+// Per-system settings read every frame by MDFNI_Emulate().
+static MDFN_SettingHandle SH_ForceMono;
+static MDFN_SettingHandle SH_RunAhead;
+
+static void BindGameSettings(void)
+{
+ const std::string sysname = MDFNGameInfo->shortname;
+
+ if(MDFNGameInfo->soundchan == 2)
+  SH_ForceMono.Bind((sysname + ".forcemono").c_str());
+
+ // Modules that can't save state(or that alter emulation state by doing so) don't get a run-ahead setting.
+ RunAheadUsable = MDFNGameInfo->StateAction && !MDFNGameInfo->SaveStateAltersState;
+ RunAheadChecked = false;
+
+ if(RunAheadUsable)
+  SH_RunAhead.Bind((sysname + ".runahead").c_str());
+}
+
 static std::vector<CDIF *> CDInterfaces;	// FIXME: Cleanup on error out.
 
 bool MDFNI_StartWAVRecord(const char *path, double SoundRate)
@@ -215,6 +248,7 @@ bool MDFNI_StartAVRecord(const char *path, double SoundRate)
   spec.VideoHeight = MDFNGameInfo->lcm_height;
   spec.VideoCodec = MDFN_GetSettingI("qtrecord.vcodec");
   spec.MasterClock = MDFNGameInfo->MasterClock;
+  spec.Threads = MDFN_GetSettingUI("qtrecord.threads");
 
   if(spec.VideoWidth < MDFN_GetSettingUI("qtrecord.w_double_threshold"))
    spec.VideoWidth *= 2;
@@ -295,6 +329,14 @@ void MDFNI_CloseGame(void)
   MDFNGameInfo = NULL;
   MDFN_StateEvilEnd();
 
+  if(RunAheadState.data)
+   free(RunAheadState.data);
+  memset(&RunAheadState, 0, sizeof(StateMem));
+  RunAheadSoundBuf.clear();
+
+  SH_ForceMono.Unbind();
+  SH_RunAhead.Unbind();
+
   for(unsigned i = 0; i < CDInterfaces.size(); i++)
    delete CDInterfaces[i];
   CDInterfaces.clear();
@@ -700,6 +742,7 @@ MDFNGI *MDFNI_LoadCD(const char *force_module, const char *devicename, const boo
  MDFN_ResetMessages();   // Save state, status messages, etc.
 
  TBlur_Init();
+ BindGameSettings();
 
  MDFN_StateEvilBegin();
 
@@ -752,12 +795,54 @@ static bool LoadIPS(MDFNFILE &GameFile, const char *path)
  return(1);
 }
 
+bool MDFNI_GetCDCacheStats(CDIF_CacheStats *stats)
+{
+ bool ret = false;
+
+ memset(stats, 0, sizeof(CDIF_CacheStats));
+
+ for(unsigned i = 0; i < CDInterfaces.size(); i++)
+ {
+  CDIF_CacheStats cs;
+
+  if(CDInterfaces[i]->GetCacheStats(&cs))
+  {
+   stats->hits += cs.hits;
+   stats->misses += cs.misses;
+   stats->stall_ms += cs.stall_ms;
+   ret = true;
+  }
+ }
+
+ return(ret);
+}
+
+bool MDFNI_ConvertCDImage(const char *src_path, const char *dest_path)
+{
+ MDFN_printf(_("Converting CD image \"%s\" to \"%s\"...\n"), src_path, dest_path);
+ MDFN_indent(1);
+
+ try
+ {
+  HCD_Convert(src_path, dest_path);
+ }
+ catch(std::exception &e)
+ {
+  MDFN_PrintError(_("Error converting CD image: %s"), e.what());
+  MDFN_indent(-1);
+  return(false);
+ }
+
+ MDFN_indent(-1);
+ return(true);
+}
+
 MDFNGI *MDFNI_LoadGame(const char *force_module, const char *name)
 {
         MDFNFILE GameFile;
 	std::vector<FileExtensionSpecStruct> valid_iae;
 
-	if(strlen(name) > 4 && (!strcasecmp(name + strlen(name) - 4, ".cue") || !strcasecmp(name + strlen(name) - 4, ".toc") || !strcasecmp(name + strlen(name) - 4, ".ccd") || !strcasecmp(name + strlen(name) - 4, ".m3u")))
+	if(strlen(name) > 4 && (!strcasecmp(name + strlen(name) - 4, ".cue") || !strcasecmp(name + strlen(name) - 4, ".toc") || !strcasecmp(name + strlen(name) - 4, ".ccd") || !strcasecmp(name + strlen(name) - 4, ".hcd") || !strcasecmp(name + strlen(name) - 4, ".m3u")))
 	{
 	 return(MDFNI_LoadCD(force_module, name, false));
 	}
@@ -920,6 +1005,7 @@ MDFNGI *MDFNI_LoadGame(const char *force_module, const char *name)
 	deint.ClearState();
 
 	TBlur_Init();
+	BindGameSettings();
 
         MDFN_StateEvilBegin();
 
@@ -1181,6 +1267,12 @@ int MDFNI_Initialize(const char *basedir, const std::vector<MDFNSetting> &Driver
 
          BuildDynamicSetting(&setting, sysname, "tblur.accum.amount", MDFNSF_COMMON_TEMPLATE | MDFNSF_CAT_VIDEO, CSD_tblur_accum_amount, MDFNST_FLOAT, "50", "0", "100");
 	 dynamic_settings.push_back(setting);
+
+	 if(MDFNSystems[i]->StateAction && !MDFNSystems[i]->SaveStateAltersState)
+	 {
+	  BuildDynamicSetting(&setting, sysname, "runahead", MDFNSF_COMMON_TEMPLATE, CSD_runahead, MDFNST_UINT, "0", "0", "8");
+	  dynamic_settings.push_back(setting);
+	 }
 	}
     
 	if(DriverSettings.size())
@@ -1404,8 +1496,7 @@ static void ProcessAudio(EmulateSpecStruct *espec)
    }
   }
 
-  // TODO: Optimize this.
-  if(MDFNGameInfo->soundchan == 2 && MDFN_GetSettingB(std::string(std::string(MDFNGameInfo->shortname) + ".forcemono").c_str()))
+  if(MDFNGameInfo->soundchan == 2 && SH_ForceMono.B())
   {
    for(int i = 0; i < SoundBufSize * MDFNGameInfo->soundchan; i += 2)
    {
@@ -1426,6 +1517,10 @@ void MDFN_MidSync(EmulateSpecStruct *espec)
  if(MDFNnetplay)
   return;
 
+ // Speculative frames must not output sound, poll input, or record movie data.
+ if(RunAheadSpeculating)
+  return;
+
  ProcessAudio(espec);
 
  MDFND_MidSync(espec);
@@ -1443,6 +1538,98 @@ void MDFN_MidLineUpdate(EmulateSpecStruct *espec, int y)
  //MDFND_MidLineUpdate(espec, y);
 }
 
+//
+// Run-ahead:  The real frame is emulated with video output disabled, and its sound and timing are what's handed back to the driver.
+// The state is then saved, "frames" speculative frames are emulated with the same input(only the last of which renders video, and
+// none of which output sound), and the state is restored.  The driver thus sees video from "frames" frames into the future, as
+// it would look if the input were held, which hides that much of the game's internal input lag.
+//
+static void EmulateRunAhead(EmulateSpecStruct *espec, const unsigned frames)
+{
+ if(!frames || !RunAheadUsable)
+ {
+  MDFNGameInfo->Emulate(espec);
+  return;
+ }
+
+ // The module may still be unable to save state(e.g. it's not implemented yet), so the first time around, try it before the real
+ // frame is run with its video skipped.
+ if(!RunAheadChecked)
+ {
+  RunAheadChecked = true;
+  RunAheadState.loc = 0;
+  RunAheadState.len = 0;
+
+  if(!MDFNSS_SaveSM(&RunAheadState, 0, 1))
+  {
+   RunAheadUsable = false;
+   MDFN_DispMessage(_("Run-ahead disabled: module \"%s\" can't save state."), MDFNGameInfo->shortname);
+   MDFNGameInfo->Emulate(espec);
+   return;
+  }
+ }
+
+ const bool skip_save = espec->skip;
+
+ espec->skip = true;
+ MDFNGameInfo->Emulate(espec);
+ espec->skip = skip_save;
+
+ // Frame is being skipped by the driver anyway, so there's nothing to speculate for.
+ if(espec->skip)
+  return;
+
+ // Don't free the old buffer, just rewind it; smem_write() will only realloc() if the state grew.
+ RunAheadState.loc = 0;
+ RunAheadState.len = 0;
+
+ if(!MDFNSS_SaveSM(&RunAheadState, 0, 1))
+ {
+  // Don't leave every following frame without video, too.
+  RunAheadUsable = false;
+  MDFN_DispMessage(_("Run-ahead state save failed; run-ahead disabled."));
+  return;
+ }
+
+ if(RunAheadSoundBuf.size() < (size_t)espec->SoundBufMaxSize * MDFNGameInfo->soundchan)
+  RunAheadSoundBuf.resize((size_t)espec->SoundBufMaxSize * MDFNGameInfo->soundchan);
+
+ RunAheadSpeculating = true;
+
+ for(unsigned ra = 1; ra <= frames; ra++)
+ {
+  EmulateSpecStruct tmp_espec = *espec;
+
+  tmp_espec.skip = (ra != frames);
+  tmp_espec.VideoFormatChanged = false;
+  tmp_espec.SoundFormatChanged = false;
+  tmp_espec.NeedRewind = false;
+  tmp_espec.NeedSoundReverse = false;
+  tmp_espec.MasterCycles = 0;
+  tmp_espec.MasterCyclesALMS = 0;
+  tmp_espec.SoundBufSize = 0;
+  tmp_espec.SoundBufSizeALMS = 0;
+
+  if(tmp_espec.SoundBuf)
+   tmp_espec.SoundBuf = &RunAheadSoundBuf[0];
+
+  MDFNGameInfo->Emulate(&tmp_espec);
+
+  if(ra == frames)
+  {
+   espec->DisplayRect = tmp_espec.DisplayRect;
+   espec->InterlaceOn = tmp_espec.InterlaceOn;
+   espec->InterlaceField = tmp_espec.InterlaceField;
+  }
+ }
+
+ RunAheadSpeculating = false;
+
+ RunAheadState.loc = 0;
+ if(!MDFNSS_LoadSM(&RunAheadState, 0, 1))
+  MDFN_DispMessage(_("Run-ahead state load failed."));
+}
+
 void MDFNI_Emulate(EmulateSpecStruct *espec)
 {
  multiplier_save = 1;
@@ -1529,52 +1716,10 @@ void MDFNI_Emulate(EmulateSpecStruct *espec)
  else
   espec->NeedSoundReverse = MDFN_StateEvil(espec->NeedRewind);
 
- MDFNGameInfo->Emulate(espec);
-
-#if 0
- static const unsigned SpeculativeRender = 6;
-
- if(SpeculativeRender == 0)
-  MDFNGameInfo->Emulate(espec);
+ if(MDFNGameInfo->GameType != GMT_PLAYER && !MDFNnetplay)
+  EmulateRunAhead(espec, SH_RunAhead.UI());
  else
- {
-  StateMem shoe;
-
-  for(unsigned ra = 0; ra <= SpeculativeRender; ra++)
-  {
-   EmulateSpecStruct tmp_espec = *espec;
-
-   if(ra != SpeculativeRender)
-   {
-    if(ra == 1)
-    {
-     memset(&shoe, 0, sizeof(shoe));
-     MDFNSS_SaveSM(&shoe, false, false);
-    }
-    tmp_espec.skip = true;
-    tmp_espec.NeedSoundReverse = false;
-//    tmp_espec.SoundBuf = NULL;
-//    tmp_espec.SoundBufMaxSize = 0;
-    MDFNGameInfo->Emulate(&tmp_espec);
-    espec->VideoFormatChanged = false;
-    espec->SoundFormatChanged = false;
-   }
-   else
-   {
-    MDFNGameInfo->Emulate(espec);
-
-    shoe.loc = 0;
-    MDFNSS_LoadSM(&shoe, false, false);
-
-    if(shoe.data)
-    {
-     free(shoe.data);
-     shoe.data = NULL;
-    }
-   }
-  }
- }
-#endif
+  MDFNGameInfo->Emulate(espec);
 
  //
  // Sanity checks
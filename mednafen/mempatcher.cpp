@@ -22,6 +22,7 @@
 #include <trio/trio.h>
 #include <errno.h>
 #include <vector>
+#include <algorithm>
 
 #include "general.h"
 #include "string/trim.h"
@@ -30,6 +31,10 @@
 #include "FileStream.h"
 #include "MemoryStream.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 MemoryPatch::MemoryPatch() : addr(0), val(0), compare(0), 
 			     mltpl_count(1), mltpl_addr_inc(0), mltpl_val_inc(0), copy_src_addr(0), copy_src_addr_inc(0),
 			     length(0), bigendian(false), status(false), icount(0), type(0)
@@ -47,10 +52,14 @@ static bool* RAMUseInSearch = NULL;
 static uint32 PageSize;
 static uint32 NumPages;
 
+//
+// Cheat search state for each page with RAMUseInSearch set: a snapshot of the page's RAM as of the last search, and a bitmap of the
+// addresses that are still candidates(bit set; bit "n % 32" of word "n / 32" for address "n" within the page).
+//
 typedef struct
 {
- bool excluded;
- uint8 value; 
+ uint8 *snapshot;	// NULL if the page isn't being searched.
+ uint32 *candidates;
 } CompareStruct;
 
 typedef MemoryPatch CHEATF;
@@ -74,7 +83,7 @@ typedef struct __CHEATF
 
 static std::vector<CHEATF> cheats;
 static bool savecheats;
-static CompareStruct **CheatComp = NULL;
+static CompareStruct *CheatComp = NULL;
 static uint32 resultsbytelen = 1;
 static bool resultsbigendian = 0;
 static bool CheatsActive = TRUE;
@@ -82,10 +91,167 @@ static bool CheatsActive = TRUE;
 bool SubCheatsOn = 0;
 std::vector<SUBCHEAT> SubCheats[8];
 
-static void RebuildSubCheats(void)
+//
+// Periodic('R', 'A', and 'T') cheats, and their conditions, compiled from "cheats" whenever it or the RAM map changes, so that
+// MDFNMP_ApplyPeriodicCheats() doesn't have to parse condition strings every frame.
+//
+enum
+{
+ COND_GE = 0,
+ COND_LE,
+ COND_GT,
+ COND_LT,
+ COND_EQ,
+ COND_NE,
+ COND_AND,
+ COND_NAND,
+ COND_XOR,
+ COND_NXOR,
+ COND_OR,
+ COND_NOR
+};
+
+struct CheatCondition
+{
+ unsigned op;
+ unsigned bytelen;
+ uint64 value;
+ uint32 addrs[8];	// Address of each byte, least-significant first.
+ uint8 *ptrs[8];	// Same, resolved through RAMPtrs(NULL for unmapped pages).
+};
+
+struct PeriodicCheat
+{
+ const CHEATF *cheat;
+ uint32 cond_begin;
+ uint32 cond_end;
+};
+
+static std::vector<CheatCondition> PeriodicConditions;
+static std::vector<PeriodicCheat> PeriodicCheats;
+
+/*
+ Condition format(ws = white space):
+ 
+  <variable size><ws><endian><ws><address><ws><operation><ws><value>
+	  [,second condition...etc.]
+
+  Value should be unsigned integer, hex(with a 0x prefix) or
+  base-10.  
+
+  Operations:
+   >=
+   <=
+   >
+   <
+   ==
+   !=
+   &	// Result of AND between two values is nonzero
+   !&   // Result of AND between two values is zero
+   ^    // same, XOR
+   !^
+   |	// same, OR
+   !|
+
+  Full example:
+
+  2 L 0xADDE == 0xDEAD, 1 L 0xC000 == 0xA0
+
+*/
+
+static void CompileConditions(const char *string)
+{
+ static const char *op_names[] = { ">=", "<=", ">", "<", "==", "!=", "&", "!&", "^", "!^", "|", "!|" };
+ char address[64];
+ char operation[64];
+ char value[64];
+ char endian;
+ unsigned int bytelen;
+
+ while(trio_sscanf(string, "%u %c %.63s %.63s %.63s", &bytelen, &endian, address, operation, value) == 5)
+ {
+  CheatCondition cond;
+  uint32 v_address;
+
+  memset(&cond, 0, sizeof(CheatCondition));
+
+  if(address[0] == '0' && address[1] == 'x')
+   v_address = strtoul(address + 2, NULL, 16);
+  else
+   v_address = strtoul(address, NULL, 10);
+
+  if(value[0] == '0' && value[1] == 'x')
+   cond.value = strtoull(value + 2, NULL, 16);
+  else
+   cond.value = strtoull(value, NULL, 0);
+
+  for(cond.op = 0; cond.op < sizeof(op_names) / sizeof(op_names[0]); cond.op++)
+   if(!strcmp(operation, op_names[cond.op]))
+    break;
+
+  if(cond.op == sizeof(op_names) / sizeof(op_names[0]))
+   puts("Invalid operation");
+  else
+  {
+   cond.bytelen = std::min<unsigned>(bytelen, 8);
+
+   for(unsigned int x = 0; x < cond.bytelen; x++)
+   {
+    const uint32 tmpaddr = (endian == 'B') ? (v_address + bytelen - 1 - x) : (v_address + x);
+
+    cond.addrs[x] = tmpaddr;
+
+    if(RAMPtrs)
+    {
+     const uint32 page = (tmpaddr / PageSize) % NumPages;
+
+     if(RAMPtrs[page])
+      cond.ptrs[x] = RAMPtrs[page] + (tmpaddr % PageSize);
+    }
+   }
+
+   PeriodicConditions.push_back(cond);
+  }
+
+  string = strchr(string, ',');
+  if(string == NULL)
+   break;
+  else
+   string++;
+ }
+}
+
+static void RebuildPeriodicCheats(void)
 {
  std::vector<CHEATF>::iterator chit;
 
+ PeriodicConditions.clear();
+ PeriodicCheats.clear();
+
+ if(!CheatsActive) return;
+
+ for(chit = cheats.begin(); chit != cheats.end(); chit++)
+ {
+  if(chit->status && (chit->type == 'R' || chit->type == 'A' || chit->type == 'T'))
+  {
+   PeriodicCheat pc;
+
+   pc.cheat = &*chit;
+   pc.cond_begin = PeriodicConditions.size();
+   CompileConditions(chit->conditions.c_str());
+   pc.cond_end = PeriodicConditions.size();
+
+   PeriodicCheats.push_back(pc);
+  }
+ }
+}
+
+static void RebuildCheats(void)
+{
+ std::vector<CHEATF>::iterator chit;
+
+ RebuildPeriodicCheats();
+
  SubCheatsOn = 0;
  for(int x = 0; x < 8; x++)
   SubCheats[x].clear();
@@ -119,6 +285,27 @@ static void RebuildSubCheats(void)
  }
 }
 
+static void FreeCheatSearch(void)
+{
+ if(!CheatComp)
+  return;
+
+ for(uint32 page = 0; page < NumPages; page++)
+ {
+  if(CheatComp[page].snapshot)
+  {
+   free(CheatComp[page].snapshot);
+   CheatComp[page].snapshot = NULL;
+  }
+
+  if(CheatComp[page].candidates)
+  {
+   free(CheatComp[page].candidates);
+   CheatComp[page].candidates = NULL;
+  }
+ }
+}
+
 bool MDFNMP_Init(uint32 ps, uint32 numpages)
 {
  PageSize = ps;
@@ -127,7 +314,7 @@ bool MDFNMP_Init(uint32 ps, uint32 numpages)
  RAMPtrs = (uint8 **)calloc(numpages, sizeof(uint8 *));
  RAMUseInSearch = (bool*)calloc(numpages, sizeof(bool));
 
- CheatComp = (CompareStruct **)calloc(numpages, sizeof(CompareStruct *));
+ CheatComp = (CompareStruct *)calloc(numpages, sizeof(CompareStruct));
 
  CheatsActive = MDFN_GetSettingB("cheats");
  return(1);
@@ -135,8 +322,12 @@ bool MDFNMP_Init(uint32 ps, uint32 numpages)
 
 void MDFNMP_Kill(void)
 {
+ PeriodicConditions.clear();
+ PeriodicCheats.clear();
+
  if(CheatComp)
  {
+  FreeCheatSearch();
   free(CheatComp);
   CheatComp = NULL;
  }
@@ -171,6 +362,8 @@ void MDFNMP_AddRAM(uint32 size, uint32 A, uint8 *RAM, bool use_in_search)
   if(RAM) // Don't increment the RAM pointer if we're passed a NULL pointer
    RAM += PageSize;
  }
+
+ RebuildPeriodicCheats();	// Re-resolve condition addresses.
 }
 
 void MDFNMP_InstallReadPatches(void)
@@ -351,8 +544,6 @@ void MDFN_LoadGameCheats(Stream* override)
    }
   }
 
-  RebuildSubCheats();
-
   if(!override)
   {
    MDFN_printf(_("%lu cheats loaded.\n"), (unsigned long)cheats.size());
@@ -373,6 +564,9 @@ void MDFN_LoadGameCheats(Stream* override)
   }
  }
 
+
+ RebuildCheats();
+
  //printf("%u\n", MDFND_GetTime() - st);
 }
 
@@ -524,11 +718,7 @@ static void WriteCheats(void)
 
 void MDFN_FlushGameCheats(int nosave)
 {
- if(CheatComp)
- {
-  free(CheatComp);
-  CheatComp = 0;
- }
+ FreeCheatSearch();
 
  if(savecheats && !nosave)
  {
@@ -544,7 +734,7 @@ void MDFN_FlushGameCheats(int nosave)
  }
 
  cheats.clear();
- RebuildSubCheats();
+ RebuildCheats();
 }
 
 void MDFNI_AddCheat(const MemoryPatch& patch)
@@ -554,7 +744,7 @@ void MDFNI_AddCheat(const MemoryPatch& patch)
  savecheats = true;
 
  MDFNMP_RemoveReadPatches();
- RebuildSubCheats();
+ RebuildCheats();
  MDFNMP_InstallReadPatches();
 }
 
@@ -565,221 +755,110 @@ void MDFNI_DelCheat(uint32 which)
  savecheats = true;
 
  MDFNMP_RemoveReadPatches();
- RebuildSubCheats();
+ RebuildCheats();
  MDFNMP_InstallReadPatches();
 }
 
-/*
- Condition format(ws = white space):
- 
-  <variable size><ws><endian><ws><address><ws><operation><ws><value>
-	  [,second condition...etc.]
-
-  Value should be unsigned integer, hex(with a 0x prefix) or
-  base-10.  
-
-  Operations:
-   >=
-   <=
-   >
-   <
-   ==
-   !=
-   &	// Result of AND between two values is nonzero
-   !&   // Result of AND between two values is zero
-   ^    // same, XOR
-   !^
-   |	// same, OR
-   !|
-
-  Full example:
-
-  2 L 0xADDE == 0xDEAD, 1 L 0xC000 == 0xA0
-
-*/
-
-static bool TestConditions(const char *string)
+static bool TestConditions(const CheatCondition *cond, const CheatCondition *cond_end)
 {
- char address[64];
- char operation[64];
- char value[64];
- char endian;
- unsigned int bytelen;
- bool passed = 1;
-
- while(trio_sscanf(string, "%u %c %.63s %.63s %.63s", &bytelen, &endian, address, operation, value) == 5 && passed)
+ for(; cond != cond_end; cond++)
  {
-  uint32 v_address;
-  uint64 v_value;
-  uint64 value_at_address;
-
-  if(address[0] == '0' && address[1] == 'x')
-   v_address = strtoul(address + 2, NULL, 16);
-  else
-   v_address = strtoul(address, NULL, 10);
+  uint64 value_at_address = 0;
+  bool passed;
 
-  if(value[0] == '0' && value[1] == 'x')
-   v_value = strtoull(value + 2, NULL, 16);
-  else
-   v_value = strtoull(value, NULL, 0);
-
-  value_at_address = 0;
-  for(unsigned int x = 0; x < bytelen; x++)
+  if(MDFNGameInfo->MemRead != NULL)
   {
-   unsigned int shiftie;
-
-   if(endian == 'B')
-    shiftie = (bytelen - 1 - x) * 8;
-   else
-    shiftie = x * 8;
-
-   if(MDFNGameInfo->MemRead != NULL)
-    value_at_address |= (uint64)MDFNGameInfo->MemRead(v_address + x) << shiftie;
-   else
-   {
-    uint32 page = ((v_address + x) / PageSize) % NumPages;
-
-    if(RAMPtrs[page])
-     value_at_address |= (uint64)RAMPtrs[page][(v_address + x) % PageSize] << shiftie;
-   }
-  }
-
-  //printf("A: %08x, V: %08llx, VA: %08llx, OP: %s\n", v_address, v_value, value_at_address, operation);
-  if(!strcmp(operation, ">="))
-  {
-   if(!(value_at_address >= v_value))
-    passed = 0;
-  }
-  else if(!strcmp(operation, "<="))
-  {
-   if(!(value_at_address <= v_value))
-    passed = 0;
-  }
-  else if(!strcmp(operation, ">"))
-  {
-   if(!(value_at_address > v_value))
-    passed = 0;
-  }
-  else if(!strcmp(operation, "<"))
-  {
-   if(!(value_at_address < v_value))
-    passed = 0;
-  }
-  else if(!strcmp(operation, "==")) 
-  {
-   if(!(value_at_address == v_value))
-    passed = 0;
-  }
-  else if(!strcmp(operation, "!="))
-  {
-   if(!(value_at_address != v_value))
-    passed = 0;
-  }
-  else if(!strcmp(operation, "&"))
-  {
-   if(!(value_at_address & v_value))
-    passed = 0;
-  }
-  else if(!strcmp(operation, "!&"))
-  {
-   if(value_at_address & v_value)
-    passed = 0;
-  }
-  else if(!strcmp(operation, "^"))
-  {
-   if(!(value_at_address ^ v_value))
-    passed = 0;
+   for(unsigned int x = 0; x < cond->bytelen; x++)
+    value_at_address |= (uint64)MDFNGameInfo->MemRead(cond->addrs[x]) << (x * 8);
   }
-  else if(!strcmp(operation, "!^"))
-  {
-   if(value_at_address ^ v_value)
-    passed = 0;
-  }
-  else if(!strcmp(operation, "|"))
+  else
   {
-   if(!(value_at_address | v_value))
-    passed = 0;
+   for(unsigned int x = 0; x < cond->bytelen; x++)
+    if(cond->ptrs[x])
+     value_at_address |= (uint64)*cond->ptrs[x] << (x * 8);
   }
-  else if(!strcmp(operation, "!|"))
+
+  switch(cond->op)
   {
-   if(value_at_address | v_value)
-    passed = 0;
+   default:
+   case COND_GE: passed = (value_at_address >= cond->value); break;
+   case COND_LE: passed = (value_at_address <= cond->value); break;
+   case COND_GT: passed = (value_at_address > cond->value); break;
+   case COND_LT: passed = (value_at_address < cond->value); break;
+   case COND_EQ: passed = (value_at_address == cond->value); break;
+   case COND_NE: passed = (value_at_address != cond->value); break;
+   case COND_AND: passed = (bool)(value_at_address & cond->value); break;
+   case COND_NAND: passed = !(value_at_address & cond->value); break;
+   case COND_XOR: passed = (bool)(value_at_address ^ cond->value); break;
+   case COND_NXOR: passed = !(value_at_address ^ cond->value); break;
+   case COND_OR: passed = (bool)(value_at_address | cond->value); break;
+   case COND_NOR: passed = !(value_at_address | cond->value); break;
   }
-  else
-   puts("Invalid operation");
-  string = strchr(string, ',');
-  if(string == NULL)
-   break;
-  else
-   string++;
-  //printf("Foo: %s\n", string);
+
+  if(!passed)
+   return(false);
  }
 
- return(passed);
+ return(true);
 }
 
 void MDFNMP_ApplyPeriodicCheats(void)
 {
- std::vector<CHEATF>::iterator chit;
-
+ std::vector<PeriodicCheat>::const_iterator pcit;
 
  if(!CheatsActive)
   return;
 
- //TestConditions("2 L 0x1F00F5 == 0xDEAD");
- //if(TestConditions("1 L 0x1F0058 > 0")) //, 1 L 0xC000 == 0x01"));
- for(chit = cheats.begin(); chit != cheats.end(); chit++)
+ for(pcit = PeriodicCheats.begin(); pcit != PeriodicCheats.end(); pcit++)
  {
-  if(chit->status && (chit->type == 'R' || chit->type == 'A' || chit->type == 'T'))
+  const CHEATF *chit = pcit->cheat;
+
+  if(pcit->cond_begin != pcit->cond_end && !TestConditions(&PeriodicConditions[pcit->cond_begin], &PeriodicConditions[0] + pcit->cond_end))
+   continue;
+
+  uint32 mltpl_count = chit->mltpl_count;
+  uint32 mltpl_addr = chit->addr;
+  uint64 mltpl_val = chit->val;
+  uint32 copy_src_addr = chit->copy_src_addr;
+
+  while(mltpl_count--)
   {
-   if(chit->conditions.size() == 0 || TestConditions(chit->conditions.c_str()))
+   uint8 carry = 0;
+
+   for(unsigned int x = 0; x < chit->length; x++)
    {
-    uint32 mltpl_count = chit->mltpl_count;
-    uint32 mltpl_addr = chit->addr;
-    uint64 mltpl_val = chit->val;
-    uint32 copy_src_addr = chit->copy_src_addr;
+    const uint32 tmpaddr = chit->bigendian ? (mltpl_addr + chit->length - 1 - x) : (mltpl_addr + x);
+    const uint32 page = (tmpaddr / PageSize) % NumPages;
+    const uint8 tmpval = mltpl_val >> (x * 8);
 
-    while(mltpl_count--)
+    if(RAMPtrs[page])
     {
-     uint8 carry = 0;
-
-     for(unsigned int x = 0; x < chit->length; x++)
+     if(chit->type == 'A')
      {
-      const uint32 tmpaddr = chit->bigendian ? (mltpl_addr + chit->length - 1 - x) : (mltpl_addr + x);
-      const uint32 page = (tmpaddr / PageSize) % NumPages;
-      const uint8 tmpval = mltpl_val >> (x * 8);
-
-      if(RAMPtrs[page])
-      {
-       if(chit->type == 'A')
-       {
-	unsigned t = RAMPtrs[page][tmpaddr % PageSize] + tmpval + carry;
+      unsigned t = RAMPtrs[page][tmpaddr % PageSize] + tmpval + carry;
 
-	carry = t >> 8;
+      carry = t >> 8;
 
-        RAMPtrs[page][tmpaddr % PageSize] = t;
-       }
-       else if(chit->type == 'T')
-       {
-        const uint32 tmpsrcaddr = chit->bigendian ? (copy_src_addr + chit->length - 1 - x) : (copy_src_addr + x);
-        const uint32 srcpage = (tmpsrcaddr / PageSize) % NumPages;
-	uint8 cv = 0;
+      RAMPtrs[page][tmpaddr % PageSize] = t;
+     }
+     else if(chit->type == 'T')
+     {
+      const uint32 tmpsrcaddr = chit->bigendian ? (copy_src_addr + chit->length - 1 - x) : (copy_src_addr + x);
+      const uint32 srcpage = (tmpsrcaddr / PageSize) % NumPages;
+      uint8 cv = 0;
 
-        if(RAMPtrs[srcpage])
-	 cv = RAMPtrs[srcpage][tmpsrcaddr % PageSize];
+      if(RAMPtrs[srcpage])
+       cv = RAMPtrs[srcpage][tmpsrcaddr % PageSize];
 
-        RAMPtrs[page][tmpaddr % PageSize] = cv;
-       }
-       else
-        RAMPtrs[page][tmpaddr % PageSize] = tmpval;
-      }
+      RAMPtrs[page][tmpaddr % PageSize] = cv;
      }
-     mltpl_addr += chit->mltpl_addr_inc;
-     mltpl_val += chit->mltpl_val_inc;
-     copy_src_addr += chit->copy_src_addr_inc;
+     else
+      RAMPtrs[page][tmpaddr % PageSize] = tmpval;
     }
-
-   } // end if(chit->conditions.size() == 0 || TestConditions(chit->conditions.c_str()))
+   }
+   mltpl_addr += chit->mltpl_addr_inc;
+   mltpl_val += chit->mltpl_val_inc;
+   copy_src_addr += chit->copy_src_addr_inc;
   }
  }
 }
@@ -808,7 +887,7 @@ void MDFNI_SetCheat(uint32 which, const MemoryPatch& patch)
  savecheats = true;
 
  MDFNMP_RemoveReadPatches();
- RebuildSubCheats();
+ RebuildCheats();
  MDFNMP_InstallReadPatches();
 }
 
@@ -820,23 +899,91 @@ int MDFNI_ToggleCheat(uint32 which)
  savecheats = true;
 
  MDFNMP_RemoveReadPatches();
- RebuildSubCheats();
+ RebuildCheats();
  MDFNMP_InstallReadPatches();
 
  return(cheats[which].status);
 }
 
+static INLINE bool IsCandidate(const uint32 *candidates, uint32 addr)
+{
+ return((candidates[addr >> 5] >> (addr & 31)) & 1);
+}
+
+// "v" must be nonzero.
+static INLINE unsigned LowestBitIndex(uint32 v)
+{
+ #if defined(__GNUC__)
+ return(__builtin_ctz(v));
+ #else
+ unsigned ret = 0;
+
+ while(!(v & 1))
+ {
+  v >>= 1;
+  ret++;
+ }
+
+ return(ret);
+ #endif
+}
+
+static INLINE uint32 CountBits(uint32 v)
+{
+ v = v - ((v >> 1) & 0x55555555);
+ v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+ v = (v + (v >> 4)) & 0x0F0F0F0F;
+
+ return((v * 0x01010101) >> 24);
+}
+
+// Gathers the snapshot and current values at "addr" in "page", continuing into the following page(s) if necessary; bytes on pages that
+// aren't being searched read as 0.
+static INLINE void GatherSearchValues(uint32 page, uint32 addr, unsigned int bytelen, bool bigendian, uint64 *ccval, uint64 *ramval)
+{
+ *ccval = *ramval = 0;
+
+ for(unsigned int x = 0; x < bytelen; x++)
+ {
+  uint32 curpage = (page + (addr + x) / PageSize) % NumPages;
+
+  if(CheatComp[curpage].snapshot)
+  {
+   unsigned int shiftie;
+
+   if(bigendian)
+    shiftie = (bytelen - 1 - x) * 8;
+   else
+    shiftie = x * 8;
+
+   *ccval |= (uint64)CheatComp[curpage].snapshot[(addr + x) % PageSize] << shiftie;
+   *ramval |= (uint64)RAMPtrs[curpage][(addr + x) % PageSize] << shiftie;
+  }
+ }
+}
+
 void MDFNI_CheatSearchSetCurrentAsOriginal(void)
 {
+ const uint32 words = (PageSize + 31) / 32;
+
  for(uint32 page = 0; page < NumPages; page++)
  {
-  if(CheatComp[page])
+  if(CheatComp[page].snapshot)
   {
-   for(uint32 addr = 0; addr < PageSize; addr++)
+   uint8 *snapshot = CheatComp[page].snapshot;
+   const uint32 *candidates = CheatComp[page].candidates;
+
+   for(uint32 w = 0; w < words; w++)
    {
-    if(!CheatComp[page][addr].excluded)
+    const uint32 addr = w * 32;
+
+    if(candidates[w] == 0xFFFFFFFF && (addr + 32) <= PageSize)
+     memcpy(&snapshot[addr], &RAMPtrs[page][addr], 32);
+    else if(candidates[w])
     {
-     CheatComp[page][addr].value = RAMPtrs[page][addr];
+     for(uint32 x = addr; x < addr + 32 && x < PageSize; x++)
+      if(IsCandidate(candidates, x))
+       snapshot[x] = RAMPtrs[page][x];
     }
    }
   }
@@ -847,12 +994,14 @@ void MDFNI_CheatSearchShowExcluded(void)
 {
  for(uint32 page = 0; page < NumPages; page++)
  {
-  if(CheatComp[page])
+  if(CheatComp[page].snapshot)
   {
-   for(uint32 addr = 0; addr < PageSize; addr++)
-   {
-    CheatComp[page][addr].excluded = 0;
-   }
+   uint32 *candidates = CheatComp[page].candidates;
+
+   memset(candidates, 0xFF, (PageSize / 32) * sizeof(uint32));
+
+   if(PageSize & 31)
+    candidates[PageSize / 32] = (1U << (PageSize & 31)) - 1;
   }
  }
 }
@@ -860,17 +1009,15 @@ void MDFNI_CheatSearchShowExcluded(void)
 
 int32 MDFNI_CheatSearchGetCount(void)
 {
+ const uint32 words = (PageSize + 31) / 32;
  uint32 count = 0;
 
  for(uint32 page = 0; page < NumPages; page++)
  {
-  if(CheatComp[page])
+  if(CheatComp[page].snapshot)
   {
-   for(uint32 addr = 0; addr < PageSize; addr++)
-   {
-    if(!CheatComp[page][addr].excluded)
-     count++;
-   }
+   for(uint32 w = 0; w < words; w++)
+    count += CountBits(CheatComp[page].candidates[w]);
   }
  }
  return count;
@@ -880,33 +1027,25 @@ int32 MDFNI_CheatSearchGetCount(void)
 
 void MDFNI_CheatSearchGet(int (*callb)(uint32 a, uint64 last, uint64 current, void *data), void *data)
 {
+ const uint32 words = (PageSize + 31) / 32;
+
  for(uint32 page = 0; page < NumPages; page++)
  {
-  if(CheatComp[page])
+  if(CheatComp[page].snapshot)
   {
-   for(uint32 addr = 0; addr < PageSize; addr++)
+   for(uint32 w = 0; w < words; w++)
    {
-    if(!CheatComp[page][addr].excluded)
+    uint32 bits = CheatComp[page].candidates[w];
+
+    while(bits)
     {
+     const uint32 addr = w * 32 + LowestBitIndex(bits);
      uint64 ccval;
      uint64 ramval;
 
-     ccval = ramval = 0;
-     for(unsigned int x = 0; x < resultsbytelen; x++)
-     {
-      uint32 curpage = (page + (addr + x) / PageSize) % NumPages;
-      if(CheatComp[curpage])
-      {
-       unsigned int shiftie;
+     bits &= bits - 1;
 
-       if(resultsbigendian)
-        shiftie = (resultsbytelen - 1 - x) * 8;
-       else
-        shiftie = x * 8;
-       ccval |= (uint64)CheatComp[curpage][(addr + x) % PageSize].value << shiftie;
-       ramval |= (uint64)RAMPtrs[curpage][(addr + x) % PageSize] << shiftie;
-      }
-     }
+     GatherSearchValues(page, addr, resultsbytelen, resultsbigendian, &ccval, &ramval);
 
      if(!callb(page * PageSize + addr, ccval, ramval, data))
       return;
@@ -925,16 +1064,17 @@ void MDFNI_CheatSearchBegin(void)
  {
   if(RAMUseInSearch[page] && RAMPtrs[page])
   {
-   if(!CheatComp[page])
-    CheatComp[page] = (CompareStruct *)calloc(PageSize, sizeof(CompareStruct));
-
-   for(uint32 addr = 0; addr < PageSize; addr++)
+   if(!CheatComp[page].snapshot)
    {
-    CheatComp[page][addr].excluded = 0;
-    CheatComp[page][addr].value = RAMPtrs[page][addr];
+    CheatComp[page].snapshot = (uint8 *)malloc(PageSize);
+    CheatComp[page].candidates = (uint32 *)malloc((PageSize + 31) / 32 * sizeof(uint32));
    }
+
+   memcpy(CheatComp[page].snapshot, RAMPtrs[page], PageSize);
   }
  }
+
+ MDFNI_CheatSearchShowExcluded();
 }
 
 
@@ -945,77 +1085,302 @@ static uint64 INLINE CAbs(uint64 x)
  return x;
 }
 
+struct CheatSearchParams
+{
+ int type;
+ uint64 v1;
+ uint64 v2;
+ unsigned int bytelen;
+ bool bigendian;
+};
+
+// Returns false if the address should be excluded.
+static INLINE bool CheatSearchTest(const CheatSearchParams *p, uint64 ccval, uint64 ramval)
+{
+ switch(p->type)
+ {
+  case 0: // Change to a specific value.
+	return(ccval == p->v1 && ramval == p->v2);
+
+  case 1: // Search for relative change(between values).
+	return(ccval == p->v1 && CAbs(ccval - ramval) == p->v2);
+
+  case 2: // Purely relative change.
+	return(CAbs(ccval - ramval) == p->v2);
+
+  case 3: // Any change
+	return(ccval != ramval);
+
+  case 4: // Value decreased
+	return(ramval < ccval);
+
+  case 5: // Value increased
+	return(ramval > ccval);
+ }
+
+ return(true);
+}
+
+#if defined(__SSE2__)
+//
+// SSE2 search of 16 consecutive addresses at a time, for 1-, 2-, and 4-byte values that lie entirely within a page.  Values of 2 and 4
+// bytes at each address are assembled from overlapping unaligned loads, so e.g. for 2-byte little-endian values, lane "n" of the first
+// vector holds the value at address "n" for n = 0...7, and of the second vector for n = 8...15.
+//
+// Note that CAbs() is a no-op on unsigned values, so types 1 and 2 match only where "ccval - ramval" doesn't wrap.
+//
+template<unsigned W> struct CheatSearchVec;
+
+template<> struct CheatSearchVec<1>
+{
+ static INLINE __m128i set1(uint64 v) { return _mm_set1_epi8(v); }
+ static INLINE __m128i eq(__m128i a, __m128i b) { return _mm_cmpeq_epi8(a, b); }
+ static INLINE __m128i gtu(__m128i a, __m128i b) { const __m128i bias = _mm_set1_epi8(0x80); return _mm_cmpgt_epi8(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias)); }
+ static INLINE __m128i sub(__m128i a, __m128i b) { return _mm_sub_epi8(a, b); }
+
+ template<bool bigendian>
+ static INLINE void load(const uint8 *p, __m128i *v)
+ {
+  v[0] = _mm_loadu_si128((const __m128i *)p);
+ }
+
+ static INLINE uint32 mask(const __m128i *m)
+ {
+  return(_mm_movemask_epi8(m[0]));
+ }
+};
+
+template<> struct CheatSearchVec<2>
+{
+ static INLINE __m128i set1(uint64 v) { return _mm_set1_epi16(v); }
+ static INLINE __m128i eq(__m128i a, __m128i b) { return _mm_cmpeq_epi16(a, b); }
+ static INLINE __m128i gtu(__m128i a, __m128i b) { const __m128i bias = _mm_set1_epi16(0x8000); return _mm_cmpgt_epi16(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias)); }
+ static INLINE __m128i sub(__m128i a, __m128i b) { return _mm_sub_epi16(a, b); }
+
+ template<bool bigendian>
+ static INLINE void load(const uint8 *p, __m128i *v)
+ {
+  const __m128i a = _mm_loadu_si128((const __m128i *)p);
+  const __m128i b = _mm_loadu_si128((const __m128i *)(p + 1));
+
+  if(bigendian)
+  {
+   v[0] = _mm_unpacklo_epi8(b, a);
+   v[1] = _mm_unpackhi_epi8(b, a);
+  }
+  else
+  {
+   v[0] = _mm_unpacklo_epi8(a, b);
+   v[1] = _mm_unpackhi_epi8(a, b);
+  }
+ }
+
+ static INLINE uint32 mask(const __m128i *m)
+ {
+  return(_mm_movemask_epi8(_mm_packs_epi16(m[0], m[1])));
+ }
+};
+
+template<> struct CheatSearchVec<4>
+{
+ static INLINE __m128i set1(uint64 v) { return _mm_set1_epi32(v); }
+ static INLINE __m128i eq(__m128i a, __m128i b) { return _mm_cmpeq_epi32(a, b); }
+ static INLINE __m128i gtu(__m128i a, __m128i b) { const __m128i bias = _mm_set1_epi32(0x80000000); return _mm_cmpgt_epi32(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias)); }
+ static INLINE __m128i sub(__m128i a, __m128i b) { return _mm_sub_epi32(a, b); }
+
+ template<bool bigendian>
+ static INLINE void load(const uint8 *p, __m128i *v)
+ {
+  __m128i lo[2], hi[2];	// Less- and more-significant halves.
+
+  CheatSearchVec<2>::load<bigendian>(bigendian ? (p + 2) : p, lo);
+  CheatSearchVec<2>::load<bigendian>(bigendian ? p : (p + 2), hi);
+
+  v[0] = _mm_unpacklo_epi16(lo[0], hi[0]);
+  v[1] = _mm_unpackhi_epi16(lo[0], hi[0]);
+  v[2] = _mm_unpacklo_epi16(lo[1], hi[1]);
+  v[3] = _mm_unpackhi_epi16(lo[1], hi[1]);
+ }
+
+ static INLINE uint32 mask(const __m128i *m)
+ {
+  return(_mm_movemask_epi8(_mm_packs_epi16(_mm_packs_epi32(m[0], m[1]), _mm_packs_epi32(m[2], m[3]))));
+ }
+};
+
+// Returns a bitmask of which of the 16 addresses starting at "cc"/"ram" to keep.
+template<unsigned W, bool bigendian>
+static INLINE uint32 CheatSearchBlock(const CheatSearchParams *p, const uint8 *cc, const uint8 *ram, const __m128i v1, const __m128i v2)
+{
+ typedef CheatSearchVec<W> V;
+ __m128i ccv[W], ramv[W], m[W];
+
+ V::template load<bigendian>(cc, ccv);
+ V::template load<bigendian>(ram, ramv);
+
+ for(unsigned i = 0; i < W; i++)
+ {
+  switch(p->type)
+  {
+   case 0: m[i] = _mm_and_si128(V::eq(ccv[i], v1), V::eq(ramv[i], v2)); break;
+   case 1: m[i] = _mm_and_si128(V::eq(ccv[i], v1), _mm_andnot_si128(V::gtu(ramv[i], ccv[i]), V::eq(V::sub(ccv[i], ramv[i]), v2))); break;
+   case 2: m[i] = _mm_andnot_si128(V::gtu(ramv[i], ccv[i]), V::eq(V::sub(ccv[i], ramv[i]), v2)); break;
+   case 3: m[i] = _mm_xor_si128(V::eq(ccv[i], ramv[i]), _mm_set1_epi32(~0)); break;
+   case 4: m[i] = V::gtu(ccv[i], ramv[i]); break;
+   case 5: m[i] = V::gtu(ramv[i], ccv[i]); break;
+   default: m[i] = _mm_set1_epi32(~0); break;
+  }
+ }
+
+ return(V::mask(m));
+}
+
+// Searches the addresses in [0, returned value) of the page, in groups of 32(one candidate bitmap word).
+template<unsigned W, bool bigendian>
+static uint32 CheatSearchPageVec(const CheatSearchParams *p, const uint8 *cc, const uint8 *ram, uint32 *candidates)
+{
+ const uint64 max_value = ((uint64)1 << (W * 8)) - 1;
+ const uint32 end = (PageSize - (W - 1)) & ~31;
+ const __m128i v1 = CheatSearchVec<W>::set1(p->v1);
+ const __m128i v2 = CheatSearchVec<W>::set1(p->v2);
+ bool none = false;
+
+ // Values that can't be represented in W bytes can't match.
+ if(p->type <= 1 && p->v1 > max_value)
+  none = true;
+
+ if(p->type <= 2 && p->v2 > max_value)
+  none = true;
+
+ for(uint32 addr = 0; addr < end; addr += 32)
+ {
+  uint32 *w = &candidates[addr >> 5];
+
+  if(!*w)
+   continue;
+
+  if(none)
+   *w = 0;
+  else
+   *w &= CheatSearchBlock<W, bigendian>(p, cc + addr, ram + addr, v1, v2) | (CheatSearchBlock<W, bigendian>(p, cc + addr + 16, ram + addr + 16, v1, v2) << 16);
+ }
+
+ return(end);
+}
+#endif
+
+static void CheatSearchPage(const CheatSearchParams *p, uint32 page)
+{
+ uint32 *candidates = CheatComp[page].candidates;
+ uint32 addr = 0;
+
+ #if defined(__SSE2__)
+ {
+  const uint8 *cc = CheatComp[page].snapshot;
+  const uint8 *ram = RAMPtrs[page];
+
+  if(PageSize >= 64)
+  {
+   if(p->bytelen == 1)
+    addr = CheatSearchPageVec<1, false>(p, cc, ram, candidates);
+   else if(p->bytelen == 2)
+    addr = p->bigendian ? CheatSearchPageVec<2, true>(p, cc, ram, candidates) : CheatSearchPageVec<2, false>(p, cc, ram, candidates);
+   else if(p->bytelen == 4)
+    addr = p->bigendian ? CheatSearchPageVec<4, true>(p, cc, ram, candidates) : CheatSearchPageVec<4, false>(p, cc, ram, candidates);
+  }
+ }
+ #endif
+
+ for(; addr < PageSize; addr++)
+ {
+  if(IsCandidate(candidates, addr))
+  {
+   uint64 ccval;
+   uint64 ramval;
+
+   GatherSearchValues(page, addr, p->bytelen, p->bigendian, &ccval, &ramval);
+
+   if(!CheatSearchTest(p, ccval, ramval))
+    candidates[addr >> 5] &= ~(1U << (addr & 31));
+  }
+ }
+}
+
+//
+// Large searches are split by page across several threads.
+//
+enum { CHEATSEARCH_MAX_THREADS = 4, CHEATSEARCH_THREAD_MIN_BYTES = 512 * 1024 };
+
+struct CheatSearchWork
+{
+ const CheatSearchParams *p;
+ const uint32 *pages;
+ uint32 count;
+};
+
+static int CheatSearchThreadStart(void *data)
+{
+ const CheatSearchWork *cw = (const CheatSearchWork *)data;
+
+ for(uint32 i = 0; i < cw->count; i++)
+  CheatSearchPage(cw->p, cw->pages[i]);
+
+ return(0);
+}
+
 void MDFNI_CheatSearchEnd(int type, uint64 v1, uint64 v2, unsigned int bytelen, bool bigendian)
 {
+ CheatSearchParams p;
+ std::vector<uint32> pages;
+ CheatSearchWork work[CHEATSEARCH_MAX_THREADS];
+ MDFN_Thread *threads[CHEATSEARCH_MAX_THREADS];
+ unsigned num_parts;
+ unsigned num_threads = 0;
+
  v1 &= (~0ULL) >> (8 - bytelen);
  v2 &= (~0ULL) >> (8 - bytelen);
 
  resultsbytelen = bytelen;
  resultsbigendian = bigendian;
 
+ p.type = type;
+ p.v1 = v1;
+ p.v2 = v2;
+ p.bytelen = bytelen;
+ p.bigendian = bigendian;
+
  for(uint32 page = 0; page < NumPages; page++)
+  if(CheatComp[page].snapshot)
+   pages.push_back(page);
+
+ if(type >= 0 && type <= 5 && pages.size())
  {
-  if(CheatComp[page])
-  {
-   for(uint32 addr = 0; addr < PageSize; addr++)
-   {
-    if(!CheatComp[page][addr].excluded)
-    {
-     bool doexclude = 0;
-     uint64 ccval;
-     uint64 ramval;
+  num_parts = std::min<uint64>(CHEATSEARCH_MAX_THREADS, std::max<uint64>(1, (uint64)pages.size() * PageSize / CHEATSEARCH_THREAD_MIN_BYTES));
+  num_parts = std::min<uint32>(num_parts, pages.size());
 
-     ccval = ramval = 0;
-     for(unsigned int x = 0; x < bytelen; x++)
-     {
-      uint32 curpage = (page + (addr + x) / PageSize) % NumPages;
-      if(CheatComp[curpage])
-      {
-       unsigned int shiftie;
+  for(unsigned i = 0; i < num_parts; i++)
+  {
+   const uint32 begin = (uint64)pages.size() * i / num_parts;
+   const uint32 end = (uint64)pages.size() * (i + 1) / num_parts;
 
-       if(bigendian)
-        shiftie = (bytelen - 1 - x) * 8;
-       else
-        shiftie = x * 8;
-       ccval |= (uint64)CheatComp[curpage][(addr + x) % PageSize].value << shiftie;
-       ramval |= (uint64)RAMPtrs[curpage][(addr + x) % PageSize] << shiftie;
-      }
-     }
+   work[i].p = &p;
+   work[i].pages = &pages[begin];
+   work[i].count = end - begin;
+  }
 
-     switch(type)
-     {
-      case 0: // Change to a specific value.
-	if(!(ccval == v1 && ramval == v2))
-	 doexclude = 1;
-	break;
-	 
-      case 1: // Search for relative change(between values).
-	if(!(ccval == v1 && CAbs(ccval - ramval) == v2))
-	 doexclude = 1;
-	break;
-
-      case 2: // Purely relative change.
-	if(!(CAbs(ccval - ramval) == v2))
-	 doexclude = 1;
-	break;
-      case 3: // Any change
-        if(!(ccval != ramval))
-         doexclude = 1;
-        break;
-      case 4: // Value decreased
-        if(ramval >= ccval)
-         doexclude = 1;
-        break;
-      case 5: // Value increased
-        if(ramval <= ccval)
-         doexclude = 1;
-        break;
-     }
-     if(doexclude)
-      CheatComp[page][addr].excluded = TRUE;
-    }
-   }
+  // Run the first part on this thread, along with any part that we fail to create a thread for.
+  for(unsigned i = 1; i < num_parts; i++)
+  {
+   if(!(threads[num_threads] = MDFND_CreateThread(CheatSearchThreadStart, &work[i])))
+    CheatSearchThreadStart(&work[i]);
+   else
+    num_threads++;
   }
+
+  CheatSearchThreadStart(&work[0]);
+
+  for(unsigned i = 0; i < num_threads; i++)
+   MDFND_WaitThread(threads[i], NULL);
  }
 
  if(type >= 4)
@@ -1028,7 +1393,7 @@ static void SettingChanged(const char *name)
 
  CheatsActive = MDFN_GetSettingB("cheats");
 
- RebuildSubCheats();
+ RebuildCheats();
 
  MDFNMP_InstallReadPatches();
 }
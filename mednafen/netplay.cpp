@@ -26,6 +26,8 @@
 #include <string.h>
 #include <zlib.h>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <math.h>
 #include <trio/trio.h>
 
@@ -49,6 +51,8 @@ static uint32 LocalPlayersMask = 0;
 static uint32 TotalInputStateSize = 0;
 static uint32 LocalInputStateSize = 0;
 
+static void InvalidateBaseState(void);
+
 static void NetError(const char *format, ...)
 {
  char *temp = NULL;
@@ -83,6 +87,7 @@ void MDFNI_NetplayStop(void)
 	{
 	 Joined = false;
 	 MDFNnetplay = 0;
+	 InvalidateBaseState();
  	 MDFN_FlushGameCheats(1);	/* Don't save netplay cheats. */
  	 MDFN_LoadGameCheats(0);		/* Reload our original cheats. */
 	 if(OurNick)
@@ -179,6 +184,7 @@ int NetplayStart(const char *PortDeviceCache[16], const uint32 PortDataLenCache[
  LocalPlayersMask = 0;
  LocalInputStateSize = 0; 
  Joined = 0;
+ InvalidateBaseState();
 
  MDFN_FlushGameCheats(0);	/* Save our pre-netplay cheats. */
 
@@ -393,12 +399,281 @@ static int SendIntegrity(void)
 }
 
 
-static void SendState(void)
+//
+// Save state transfers.
+//
+// Full states can be sent in the original format(4-byte uncompressed length followed by a single zlib stream), which every client
+// understands.  With "netplay.delta_state" enabled, states are instead sent in the extended format below: compressed at a fast zlib level,
+// in independent chunks spread over several threads, and, when we're loading a state of our own, as just the XOR difference from a "base
+// state".  That's the last state we sent or received over the connection; every peer keeps its last few such states(until somebody joins),
+// so it doesn't matter if the server interleaves states sent by two peers at once.  The base state is identified by its MD5 hash; a peer
+// that doesn't have it can't stay in sync(the server won't relay a request for a full state), so it disconnects with an error instead of
+// loading garbage.  States sent because the server asked for one are always full states.
+//
+// Extended format(all integers little-endian):
+//  uint32	0xFFFFFFFF(an impossible uncompressed length in the original format)
+//  uint32	Format version(STATEX_VERSION)
+//  uint32	Flags(STATEX_FLAG_*)
+//  uint32	Uncompressed state length
+//  uint32	Reserved(0)
+//  uint8[16]	MD5 hash of the base state(delta only)
+//  uint8[16]	MD5 hash of the state
+//  uint32	Chunk size(uncompressed)
+//  uint32	Chunk count
+//  uint32	Compressed size of each chunk, chunk count times
+//  Compressed chunks
+//
+enum
+{
+ STATEX_MAGIC = 0xFFFFFFFF,
+ STATEX_VERSION = 1,
+ STATEX_FLAG_DELTA = 0x1,
+ STATEX_HEADER_SIZE = 60,
+ STATEX_CHUNK_SIZE = 256 * 1024,
+ STATEX_MAX_THREADS = 4,
+ STATEX_ZLIB_LEVEL = 1,
+ STATEX_MAX_BASE_STATES = 4
+};
+
+struct BaseStateEntry
+{
+ std::vector<uint8> data;
+ uint8 md5[16];
+};
+
+static std::vector<BaseStateEntry> BaseStates;	// Oldest first.
+
+static void InvalidateBaseState(void)
+{
+ BaseStates.clear();
+}
+
+static const BaseStateEntry *FindBaseState(const uint8 *md5_digest)
+{
+ for(unsigned i = 0; i < BaseStates.size(); i++)
+ {
+  if(!memcmp(BaseStates[i].md5, md5_digest, 16))
+   return(&BaseStates[i]);
+ }
+
+ return(NULL);
+}
+
+// Makes the state the most recent base state, dropping the oldest one if need be.
+static void AddBaseState(const uint8 *data, uint32 len, const uint8 *md5_digest = NULL)
+{
+ BaseStateEntry bse;
+
+ if(md5_digest)
+  memcpy(bse.md5, md5_digest, 16);
+ else
+ {
+  md5_context md5;
+
+  md5.starts();
+  md5.update(data, len);
+  md5.finish(bse.md5);
+ }
+
+ for(unsigned i = 0; i < BaseStates.size(); i++)
+ {
+  if(!memcmp(BaseStates[i].md5, bse.md5, 16))
+  {
+   BaseStates.erase(BaseStates.begin() + i);
+   break;
+  }
+ }
+
+ if(BaseStates.size() >= STATEX_MAX_BASE_STATES)
+  BaseStates.erase(BaseStates.begin());
+
+ bse.data.assign(data, data + len);
+ BaseStates.push_back(bse);
+}
+
+struct StateChunk
+{
+ const uint8 *src;
+ uLong src_len;
+ uint8 *dest;
+ uLongf dest_len;	// Capacity going in, (de)compressed size coming out.
+ int zresult;
+};
+
+struct StateChunkWork
+{
+ std::vector<StateChunk> *chunks;
+ bool compress;
+ MDFN_Mutex *mutex;
+ uint32 next;
+};
+
+static void StateChunkWorkRun(StateChunkWork *cw)
+{
+ for(;;)
+ {
+  StateChunk *c;
+  uint32 i;
+
+  if(cw->mutex)
+   MDFND_LockMutex(cw->mutex);
+
+  i = cw->next++;
+
+  if(cw->mutex)
+   MDFND_UnlockMutex(cw->mutex);
+
+  if(i >= cw->chunks->size())
+   break;
+
+  c = &(*cw->chunks)[i];
+
+  if(cw->compress)
+   c->zresult = compress2((Bytef *)c->dest, &c->dest_len, (const Bytef *)c->src, c->src_len, STATEX_ZLIB_LEVEL);
+  else
+   c->zresult = uncompress((Bytef *)c->dest, &c->dest_len, (const Bytef *)c->src, c->src_len);
+ }
+}
+
+static int StateChunkWorkThread(void *data)
+{
+ StateChunkWorkRun((StateChunkWork *)data);
+
+ return(0);
+}
+
+// (De)compresses all of "chunks", spread over up to STATEX_MAX_THREADS threads(including the calling one).
+static void RunStateChunkWork(std::vector<StateChunk> &chunks, bool compress)
+{
+ StateChunkWork cw;
+ MDFN_Thread *threads[STATEX_MAX_THREADS - 1];
+ unsigned num_threads = 0;
+
+ cw.chunks = &chunks;
+ cw.compress = compress;
+ cw.mutex = NULL;
+ cw.next = 0;
+
+ if(chunks.size() > 1 && (cw.mutex = MDFND_CreateMutex()))
+ {
+  while(num_threads < (STATEX_MAX_THREADS - 1) && (num_threads + 1) < chunks.size())
+  {
+   if(!(threads[num_threads] = MDFND_CreateThread(StateChunkWorkThread, &cw)))
+    break;
+
+   num_threads++;
+  }
+ }
+
+ StateChunkWorkRun(&cw);
+
+ for(unsigned i = 0; i < num_threads; i++)
+  MDFND_WaitThread(threads[i], NULL);
+
+ if(cw.mutex)
+  MDFND_DestroyMutex(cw.mutex);
+}
+
+static void SendStateLegacy(const uint8 *data, uint32 len)
 {
- StateMem sm;
  uLongf clen;
  std::vector<uint8> cbuf;
 
+ clen = len + len / 1000 + 12;
+ cbuf.resize(4 + clen);
+ MDFN_en32lsb(&cbuf[0], len);
+ compress2((Bytef *)&cbuf[0] + 4, &clen, (Bytef *)data, len, 7);
+
+ SendCommand(MDFNNPCMD_LOADSTATE, clen + 4);
+ MDFND_SendData(&cbuf[0], clen + 4);
+}
+
+static void SendStateX(const uint8 *data, uint32 len, const uint8 *digest, const bool allow_delta)
+{
+ const BaseStateEntry *base = (allow_delta && BaseStates.size()) ? &BaseStates.back() : NULL;
+ const bool delta = (base != NULL);
+ const uint32 chunk_count = (len + STATEX_CHUNK_SIZE - 1) / STATEX_CHUNK_SIZE;
+ const uint32 header_size = STATEX_HEADER_SIZE + 4 * chunk_count;
+ std::vector<uint8> xbuf;
+ std::vector<uint8> cbuf;
+ std::vector<StateChunk> chunks(chunk_count);
+ const uint8 *src = data;
+ uint32 wpos;
+
+ if(delta)
+ {
+  const uint32 common_len = std::min<uint32>(len, base->data.size());
+
+  xbuf.resize(len);
+
+  for(uint32 i = 0; i < common_len; i++)
+   xbuf[i] = data[i] ^ base->data[i];
+
+  if(len > common_len)
+   memcpy(&xbuf[common_len], data + common_len, len - common_len);
+
+  src = &xbuf[0];
+ }
+
+ wpos = header_size;
+ for(uint32 i = 0; i < chunk_count; i++)
+ {
+  StateChunk *c = &chunks[i];
+
+  c->src = src + i * STATEX_CHUNK_SIZE;
+  c->src_len = std::min<uint32>(STATEX_CHUNK_SIZE, len - i * STATEX_CHUNK_SIZE);
+  c->dest_len = compressBound(c->src_len);
+  c->zresult = Z_OK;
+  wpos += c->dest_len;
+ }
+
+ cbuf.resize(wpos);
+
+ wpos = header_size;
+ for(uint32 i = 0; i < chunk_count; i++)
+ {
+  chunks[i].dest = &cbuf[wpos];
+  wpos += chunks[i].dest_len;
+ }
+
+ RunStateChunkWork(chunks, true);
+
+ memset(&cbuf[0], 0, STATEX_HEADER_SIZE);
+ MDFN_en32lsb(&cbuf[0], STATEX_MAGIC);
+ MDFN_en32lsb(&cbuf[4], STATEX_VERSION);
+ MDFN_en32lsb(&cbuf[8], delta ? (uint32)STATEX_FLAG_DELTA : 0);
+ MDFN_en32lsb(&cbuf[12], len);
+
+ if(delta)
+  memcpy(&cbuf[20], base->md5, 16);
+
+ memcpy(&cbuf[36], digest, 16);
+ MDFN_en32lsb(&cbuf[52], STATEX_CHUNK_SIZE);
+ MDFN_en32lsb(&cbuf[56], chunk_count);
+
+ // Pack the compressed chunks together; each one only ever moves toward the start of the buffer.
+ wpos = header_size;
+ for(uint32 i = 0; i < chunk_count; i++)
+ {
+  const StateChunk *c = &chunks[i];
+
+  if(c->zresult != Z_OK)
+   throw MDFN_Error(0, _("Error compressing save state data: %d"), c->zresult);
+
+  MDFN_en32lsb(&cbuf[STATEX_HEADER_SIZE + i * 4], c->dest_len);
+  memmove(&cbuf[wpos], c->dest, c->dest_len);
+  wpos += c->dest_len;
+ }
+
+ SendCommand(MDFNNPCMD_LOADSTATE, wpos);
+ MDFND_SendData(&cbuf[0], wpos);
+}
+
+// "full" is set when the server asks for our state, since whoever needs it might not have any of our base states.
+static void SendState(const bool full)
+{
+ StateMem sm;
+
  memset(&sm, 0, sizeof(StateMem));
 
  if(!MDFNSS_SaveSM(&sm, 0, 0))
@@ -406,14 +681,120 @@ static void SendState(void)
   throw MDFN_Error(0, _("Error during save state generation."));
  }
 
- clen = sm.len + sm.len / 1000 + 12;
- cbuf.resize(4 + clen);
- MDFN_en32lsb(&cbuf[0], sm.len);
- compress2((Bytef *)&cbuf[0] + 4, &clen, (Bytef *)sm.data, sm.len, 7);
+ try
+ {
+  md5_context md5;
+  uint8 digest[16];
+
+  md5.starts();
+  md5.update(sm.data, sm.len);
+  md5.finish(digest);
+
+  if(MDFN_GetSettingB("netplay.delta_state"))
+   SendStateX(sm.data, sm.len, digest, !full);
+  else
+   SendStateLegacy(sm.data, sm.len);
+
+  AddBaseState(sm.data, sm.len, digest);
+ }
+ catch(...)
+ {
+  free(sm.data);
+  throw;
+ }
+
  free(sm.data);
+}
 
- SendCommand(MDFNNPCMD_LOADSTATE, clen + 4);
- MDFND_SendData(&cbuf[0], clen + 4);
+// Decodes an extended format state in "cbuf" into "buf"; the MD5 hash of the state is stored in "digest".
+static void RecvStateX(const std::vector<uint8> &cbuf, std::vector<uint8> *buf, uint8 *digest)
+{
+ const uint32 clen = cbuf.size();
+ const BaseStateEntry *base = NULL;
+ uint32 version, flags, len, chunk_size, chunk_count;
+ uint32 rpos;
+ std::vector<StateChunk> chunks;
+
+ if(clen < STATEX_HEADER_SIZE)
+  throw MDFN_Error(0, _("Compressed save state data is too small: %u"), clen);
+
+ version = MDFN_de32lsb(&cbuf[4]);
+ flags = MDFN_de32lsb(&cbuf[8]);
+ len = MDFN_de32lsb(&cbuf[12]);
+ chunk_size = MDFN_de32lsb(&cbuf[52]);
+ chunk_count = MDFN_de32lsb(&cbuf[56]);
+ memcpy(digest, &cbuf[36], 16);
+
+ if(version != STATEX_VERSION)
+  throw MDFN_Error(0, _("Unsupported save state transfer format version: %u"), version);
+
+ if(len > 12 * 1024 * 1024) // Uncompressed length sanity check - 12 MiB max.
+  throw MDFN_Error(0, _("Uncompressed save state data is too large: %u"), len);
+
+ if(!chunk_size || chunk_count != ((uint64)len + chunk_size - 1) / chunk_size || ((clen - STATEX_HEADER_SIZE) / 4) < chunk_count)
+  throw MDFN_Error(0, _("Save state transfer header is corrupt."));
+
+ // A state we already have(e.g. our own state, relayed back to us).
+ if((base = FindBaseState(digest)))
+ {
+  *buf = base->data;
+  return;
+ }
+
+ if(flags & STATEX_FLAG_DELTA)
+ {
+  if(!(base = FindBaseState(&cbuf[20])))
+   throw MDFN_Error(0, _("Received a save state relative to one we don't have; can't stay in sync."));
+ }
+
+ buf->resize(len);
+ chunks.resize(chunk_count);
+
+ rpos = STATEX_HEADER_SIZE + 4 * chunk_count;
+ for(uint32 i = 0; i < chunk_count; i++)
+ {
+  StateChunk *c = &chunks[i];
+  const uint32 chunk_clen = MDFN_de32lsb(&cbuf[STATEX_HEADER_SIZE + i * 4]);
+
+  if(chunk_clen > (clen - rpos))
+   throw MDFN_Error(0, _("Save state transfer header is corrupt."));
+
+  c->src = &cbuf[rpos];
+  c->src_len = chunk_clen;
+  c->dest = &(*buf)[i * chunk_size];
+  c->dest_len = std::min<uint32>(chunk_size, len - i * chunk_size);
+  c->zresult = Z_OK;
+
+  rpos += chunk_clen;
+ }
+
+ RunStateChunkWork(chunks, false);
+
+ for(uint32 i = 0; i < chunk_count; i++)
+ {
+  if(chunks[i].zresult != Z_OK || chunks[i].dest_len != std::min<uint32>(chunk_size, len - i * chunk_size))
+   throw MDFN_Error(0, _("Error decompressing save state data: %d"), chunks[i].zresult);
+ }
+
+ if(flags & STATEX_FLAG_DELTA)
+ {
+  const uint32 common_len = std::min<uint32>(len, base->data.size());
+
+  for(uint32 i = 0; i < common_len; i++)
+   (*buf)[i] ^= base->data[i];
+ }
+
+ {
+  md5_context md5;
+  uint8 check_digest[16];
+
+  md5.starts();
+  md5.update(len ? &(*buf)[0] : NULL, len);
+  md5.finish(check_digest);
+
+  if(memcmp(check_digest, digest, 16))
+   throw MDFN_Error(0, _("Received save state data is corrupt(MD5 mismatch)."));
+ }
 }
 
 static void RecvState(const uint32 clen)
@@ -421,6 +802,8 @@ static void RecvState(const uint32 clen)
  StateMem sm;
  std::vector<uint8> cbuf;
  std::vector<uint8> buf;
+ uint8 digest[16];
+ bool have_digest = false;
 
  memset(&sm, 0, sizeof(StateMem));
 
@@ -438,24 +821,34 @@ static void RecvState(const uint32 clen)
 
  MDFND_RecvData(&cbuf[0], clen);
 
- uLongf len = MDFN_de32lsb(&cbuf[0]);
- if(len > 12 * 1024 * 1024) // Uncompressed length sanity check - 12 MiB max.
+ if(MDFN_de32lsb(&cbuf[0]) == STATEX_MAGIC)
  {
-  throw MDFN_Error(0, _("Uncompressed save state data is too large: %u"), len);
+  RecvStateX(cbuf, &buf, digest);
+  have_digest = true;
  }
+ else
+ {
+  uLongf len = MDFN_de32lsb(&cbuf[0]);
+  if(len > 12 * 1024 * 1024) // Uncompressed length sanity check - 12 MiB max.
+  {
+   throw MDFN_Error(0, _("Uncompressed save state data is too large: %u"), len);
+  }
 
- buf.resize(len);
+  buf.resize(len);
 
- uncompress((Bytef *)&buf[0], &len, (Bytef *)&cbuf[0] + 4, clen - 4);
+  uncompress((Bytef *)&buf[0], &len, (Bytef *)&cbuf[0] + 4, clen - 4);
+ }
 
  sm.data = &buf[0];
- sm.len = len;
+ sm.len = buf.size();
 
  if(!MDFNSS_LoadSM(&sm, 0, 0))
  {
   throw MDFN_Error(0, _("Error during save state loading."));
  }
 
+ AddBaseState(&buf[0], buf.size(), have_digest ? digest : NULL);
+
  if(MDFNMOV_IsRecording())
   MDFNMOV_RecordState();
 }
@@ -498,7 +891,7 @@ void NetplaySendState(void)
 {
  try
  {
-  SendState();
+  SendState(false);
  }
  catch(std::exception &e)
  {
@@ -561,7 +954,7 @@ try
 			break;
 
    case MDFNNPCMD_REQUEST_STATE:
-			SendState();
+			SendState(true);
 	  	 	break;
 
    case MDFNNPCMD_LOADSTATE:
@@ -804,6 +1197,10 @@ try
 
 			 mps_string = GenerateMPSString(mps);
 
+			 // Whoever joined won't have our base state for delta state transfers.
+			 if(buf[TotalInputStateSize] == MDFNNPCMD_YOUJOINED || buf[TotalInputStateSize] == MDFNNPCMD_PLAYERJOINED)
+			  InvalidateBaseState();
+
 			 if(buf[TotalInputStateSize] == MDFNNPCMD_YOULEFT)
 			 {
 			  // Uhm, not supported yet!
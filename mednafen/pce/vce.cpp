@@ -120,6 +120,8 @@ VCE::VCE(bool want_sgfx, bool nospritelimit)
 
  fb = NULL;
  pitch32 = 0;
+ SH_SLStart.Bind("pce.slstart");
+ SH_SLEnd.Bind("pce.slend");
  RunHook = NULL;
  HBlankHook = NULL;
  VBlankHook = NULL;
@@ -152,6 +154,9 @@ VCE::VCE(bool want_sgfx, bool nospritelimit)
 
 VCE::~VCE()
 {
+ SH_SLStart.Unbind();
+ SH_SLEnd.Unbind();
+
  for(int chip = 0; chip < chip_count; chip++)
   delete vdc[chip];
 }
@@ -233,8 +238,8 @@ void VCE::StartFrame(MDFN_Surface *surface, MDFN_Rect *DisplayRect, MDFN_Rect *L
   DisplayRect->y = 0 + 14;
   DisplayRect->h = 240; //263 - 14;
 
-  DisplayRect->y = 14 + MDFN_GetSettingUI("pce.slstart");
-  DisplayRect->h = MDFN_GetSettingUI("pce.slend") - MDFN_GetSettingUI("pce.slstart") + 1;
+  DisplayRect->y = 14 + SH_SLStart.UI();
+  DisplayRect->h = SH_SLEnd.UI() - SH_SLStart.UI() + 1;
 
   for(int y = 0; y < 263; y++)
    LineWidths[y].w = 0;
@@ -249,6 +249,8 @@ class VCE : public HuC6280_Support
 	uint32 pitch32;	// Pitch(in 32-bit pixels)
 	bool FrameDone;
 
+	MDFN_SettingHandle SH_SLStart, SH_SLEnd;	// Read every frame.
+
 	void (*RunHook)(int32 clocks, uint16 *pixels);
 	
 	// Called when the state changes, with the new state.
@@ -47,6 +47,7 @@
 #include "../video.h"
 #include "../clamp.h"
 #include "../sound/OwlResampler.h"
+#include "../SPSCQueue.h"
 
 #ifdef __MMX__
 #include <mmintrin.h>
@@ -195,13 +196,57 @@ static int32 HPhase;
 static int32 HPhaseCounter;
 static int32 vdc_lb_pos;
 
-static MDFN_ALIGN(8) uint16 vdc_linebuffers[2][512];
 static MDFN_ALIGN(8) uint32 vdc_linebuffer[512];
 static MDFN_ALIGN(8) uint32 vdc_linebuffer_yuved[512];
-static MDFN_ALIGN(8) uint32 rainbow_linebuffer[256];
 
-// 8 * 2 for left + right padding for scrolling
-static MDFN_ALIGN(8) uint32 bg_linebuffer[256 + 8 + 8];
+//
+// Per-scanline compositor state: the line buffers, and the VCE state the BG drawing and layer mixing read(other than the palette cache),
+// latched when the work for the line is started.  With "pcfx.threaded_render" enabled, the BG layers and mixing for a line are done on the
+// render thread from one of these while the emulation moves on to the following lines; see SyncRender() and friends.
+//
+typedef struct
+{
+ //
+ // Latched at the start of active display, for DrawLineBG().
+ //
+ int32 raster_counter;
+ int rb_type;
+
+ uint16 bg_palette_offset[2];	// fx_vce.palette_offset[1...2]
+
+ bool chroma_key;		// Not in 7.16MHz pixel mode.
+ uint16 ChromaKeyY;
+ uint16 ChromaKeyU;
+ uint16 ChromaKeyV;
+
+ //
+ // Latched at hblank, for MixVDC() and MixLayers().  The render thread may still be drawing the BG layers from the fields above
+ // then, so the mixing gets its own copy of the line number.
+ //
+ int32 mix_raster_counter;
+ bool frame_interlaced;
+ bool odd_field;
+ bool dot_clock;
+ uint16 vdc_combo;		// fx_vce.picture_mode & 0xC0
+ uint16 vdc_palette_offset;	// fx_vce.palette_offset[0]
+
+ uint16 picture_mode;		// From vce_rendercache
+ uint16 CCR;
+ uint16 BLE;
+ uint16 SPBL;
+ uint16 coefficients[6];
+ uint32 LayerPriority[8];
+
+ MDFN_ALIGN(8) uint16 vdc_linebuffers[2][512];
+ MDFN_ALIGN(8) uint32 rainbow_linebuffer[256];
+ MDFN_ALIGN(8) uint32 bg_linebuffer[256 + 8 + 8];	// 8 * 2 for left + right padding for scrolling
+} king_line_t;
+
+// Must be at least (render queue size / 2) + 2, so that a line isn't reused while the render thread might still be working on it.
+enum { KING_LINE_COUNT = 8 };
+
+static king_line_t KINGLines[KING_LINE_COUNT];
+static unsigned KINGLineIndex;
 
 
 
@@ -495,6 +540,48 @@ static king_t *king = NULL;
 static uint8 BGLayerDisable;
 static bool RAINBOWLayerDisable;
 
+//
+// Render thread; see king_line_t.  Commands are queued in line order, a BG command when a line's active display starts, and a mix command
+// at its hblank.  BG commands read KRAM and the KING BG registers, so writes to those wait on any queued BG commands; everything else the
+// render thread reads is either latched into king_line_t, or waited on with SyncRender() before it's changed.
+//
+enum
+{
+ KING_RENDER_BG = 0,
+ KING_RENDER_MIX,
+ KING_RENDER_EXIT
+};
+
+struct KINGRenderCmd
+{
+ uint32 type;
+ king_line_t *ln;
+};
+
+static SPSCQueue<KINGRenderCmd> *RenderQueue = NULL;
+static MDFN_Thread *RenderThread = NULL;
+static uint32 RenderBGQueued;	// Emulation thread only.
+static uint32 RenderBGDone;	// Written by the render thread.
+static unsigned RenderBGPage;	// KRAM page the queued BG commands read from.
+
+static INLINE void SyncRender(void)
+{
+ if(RenderThread)
+  RenderQueue->WaitEmpty();
+}
+
+static INLINE void SyncRenderBG(void)
+{
+ if(RenderThread && RenderBGQueued != __atomic_load_n(&RenderBGDone, __ATOMIC_ACQUIRE))
+  RenderQueue->WaitEmpty();
+}
+
+static INLINE void SyncRenderKRAM(const unsigned page)
+{
+ if(page == RenderBGPage)
+  SyncRenderBG();
+}
+
 static void RedoKINGIRQCheck(void);
 
 static INLINE void REGSETP(uint16 &reg, const uint8 data, const bool msb)
@@ -634,6 +721,8 @@ static void KING_GetAddressSpaceBytes(const char *name, uint32 Address, uint32 L
 
 static void KING_PutAddressSpaceBytes(const char *name, uint32 Address, uint32 Length, uint32 Granularity, bool hl, const uint8 *Buffer)
 {
+ SyncRender();
+
  if(!strcmp(name, "kram0") || !strcmp(name, "kram1"))
  {
   int wk = name[4] - '0';
@@ -680,6 +769,7 @@ static void DoRealDMA(uint8 db)
   king->DMALatch = db;
  else
  {
+  SyncRenderKRAM(king->PageSetting & 1);
   king->DMAPagePtr[king->DMATransferAddr & 0x3FFFF] = king->DMALatch | (db << 8);
   king->DMATransferAddr = ((king->DMATransferAddr + 1) & 0x1FFFF) | (king->DMATransferAddr & 0x20000);
   king->DMATransferSize = (king->DMATransferSize - 2) & 0x3FFFF;
@@ -778,6 +868,7 @@ void FXVCE_Write16(uint32 A, uint16 V)
 			   break;
 
 		case 0x02: fx_vce.palette_rw_latch = V;
+			   SyncRender();
 			   fx_vce.palette_table[fx_vce.palette_rw_offset] = fx_vce.palette_rw_latch;
 			   RedoPaletteCache(fx_vce.palette_rw_offset);
 			   fx_vce.palette_rw_offset = (fx_vce.palette_rw_offset + 1) & 0x1FF;
@@ -888,6 +979,7 @@ uint8 KING_Read8(const v810_timestamp_t timestamp, uint32 A)
 void KING_EndFrame(v810_timestamp_t timestamp, v810_timestamp_t ts_base)
 {
  PCFX_SetEvent(PCFX_EVENT_KING, KING_Update(timestamp));
+ SyncRender();	// The frame is handed off to the driver after we return.
  scsicd_ne = SCSICD_Run(timestamp);
 
  SCSICD_ResetTS(ts_base);
@@ -1354,6 +1446,10 @@ void KING_Write16(const v810_timestamp_t timestamp, uint32 A, uint16 V)
    //ADPCMDBG("Write: %02x(%d), %04x", king->AR, msh, V);
   }
 
+  // Page setting through BG affine transformation coefficients, all read by the BG drawing code.
+  if(king->AR >= 0x0F && king->AR <= 0x3D)
+   SyncRenderBG();
+
 	      switch(king->AR)
 	      {
 		default: 
@@ -1500,6 +1596,7 @@ void KING_Write16(const v810_timestamp_t timestamp, uint32 A, uint16 V)
                             PCFXDBG_CheckBP(BPOINT_AUX_WRITE, (king->KRAMWA & 0x3FFFF) | (page ? 0x40000 : 0), V, 1);
 			   #endif
 
+			   SyncRenderKRAM(page);
 			   king->KRAM[page][king->KRAMWA & 0x3FFFF] = V;
 			   king->KRAMWA = (king->KRAMWA &~ 0x1FFFF) | ((king->KRAMWA + inc_amount) & 0x1FFFF);
 			  }
@@ -1732,6 +1829,8 @@ uint16 KING_GetADPCMHalfWord(int ch)
 }
 
 static uint32 HighDotClockWidth;
+static MDFN_SettingHandle SH_SLStart, SH_SLEnd;	// Read every frame.
+static void SetThreadedRender(bool threaded);
 extern RavenBuffer* FXCDDABufs[2]; // FIXME, externals are evil!
 
 bool KING_Init(void)
@@ -1742,6 +1841,8 @@ bool KING_Init(void)
  king->lastts = 0;
 
  HighDotClockWidth = MDFN_GetSettingUI("pcfx.high_dotclock_width");
+ SH_SLStart.Bind("pcfx.slstart");
+ SH_SLEnd.Bind("pcfx.slend");
  BGLayerDisable = 0;
 
  BuildCMT();
@@ -1808,11 +1909,18 @@ bool KING_Init(void)
 
  SCSICD_Init(SCSICD_PCFX, 3, FXCDDABufs[0]->Buf(), FXCDDABufs[1]->Buf(), 153600 * MDFN_GetSettingUI("pcfx.cdspeed"), 21477273, KING_CDIRQ, KING_StuffSubchannels);
 
+ SetThreadedRender(MDFN_GetSettingB("pcfx.threaded_render"));
+
  return(1);
 }
 
 void KING_Close(void)
 {
+ SetThreadedRender(false);
+
+ SH_SLStart.Unbind();
+ SH_SLEnd.Unbind();
+
  if(king)
  {
   free(king);
@@ -1825,6 +1933,7 @@ void KING_Close(void)
 void KING_Reset(const v810_timestamp_t timestamp)
 {
  KING_Update(timestamp);
+ SyncRender();
 
  memset(&fx_vce, 0, sizeof(fx_vce));
 
@@ -1847,11 +1956,10 @@ void KING_Reset(const v810_timestamp_t timestamp)
  HPhaseCounter = 1;
  vdc_lb_pos = 0;
 
- memset(vdc_linebuffers, 0, sizeof(vdc_linebuffers));
+ memset(KINGLines, 0, sizeof(KINGLines));
+ KINGLineIndex = 0;
  memset(vdc_linebuffer, 0, sizeof(vdc_linebuffer));
  memset(vdc_linebuffer_yuved, 0, sizeof(vdc_linebuffer_yuved));
- memset(rainbow_linebuffer, 0, sizeof(rainbow_linebuffer));
- memset(bg_linebuffer, 0, sizeof(bg_linebuffer));
 
 
  king->dma_cycle_counter = 0x7FFFFFFF;
@@ -1945,8 +2053,10 @@ static INLINE int32 max(int32 a, int32 b)
  return(b);
 }
 
-static void DrawBG(uint32 *target, int n, bool sub)
+static void DrawBG(king_line_t *ln, int n, bool sub)
 {
+ uint32 *target = ln->bg_linebuffer;
+
  // TODO: Verify behavior when size is out of bounds on BG1-3.
  // With BG0 at least, it behaves as if the size is at its minimum, with caveats(TO BE INVESTIGATED).
  const uint32 bg_ss_table[2][0x10] = 
@@ -1976,7 +2086,7 @@ static void DrawBG(uint32 *target, int n, bool sub)
 #endif
  const uint32 layer_or = (LAYER_BG0 + n) << 28;
 
- const uint32 palette_offset = ((fx_vce.palette_offset[1 + (n >> 1)] >> ((n & 1) ? 8 : 0)) << 1) & 0x1FF;
+ const uint32 palette_offset = ((ln->bg_palette_offset[n >> 1] >> ((n & 1) ? 8 : 0)) << 1) & 0x1FF;
  const uint32 *palette_ptr = &vce_rendercache.palette_table_cache[palette_offset];
  const uint32 bat_and_cg_page = (king->PageSetting & 0x0010) ? 1 : 0;
 
@@ -1985,7 +2095,7 @@ static void DrawBG(uint32 *target, int n, bool sub)
  const uint32 XScroll = king->BGXScroll[n];
  const uint32 YScroll = king->BGYScroll[n];
 
- const uint32 YOffset = (YScroll + (fx_vce.raster_counter - 22)) & 0xFFFF;
+ const uint32 YOffset = (YScroll + (ln->raster_counter - 22)) & 0xFFFF;
 
  const uint32 bat_offset = king->BGBATAddr[n] * 1024;
  const uint32 bat_sub_offset = n ? bat_offset : (king->BG0SubBATAddr * 1024);
@@ -2136,7 +2246,7 @@ static void DrawBG(uint32 *target, int n, bool sub)
 	 const int32 bat_height_mask = endless ? (bat_height - 1) : 0xFFFF;		\
          int32 a, b, c, d;	\
          int32 raw_x_coord = (int32)sign_11_to_s16(XScroll) - (int16)king->BGAffinCenterX;	\
-         int32 raw_y_coord = fx_vce.raster_counter + (int32)sign_11_to_s16(YScroll) - 22 - (int16)king->BGAffinCenterY;		\
+         int32 raw_y_coord = ln->raster_counter + (int32)sign_11_to_s16(YScroll) - 22 - (int16)king->BGAffinCenterY;		\
          int32 xaccum;	\
          int32 yaccum;	\
 	\
@@ -2476,8 +2586,8 @@ void KING_StartFrame(VDC **arg_vdc_chips, EmulateSpecStruct *espec)	//MDFN_Surfa
  DisplayRect->x = 0;
  DisplayRect->w = 256;
 
- DisplayRect->y = MDFN_GetSettingUI("pcfx.slstart");
- DisplayRect->h = MDFN_GetSettingUI("pcfx.slend") - DisplayRect->y + 1;
+ DisplayRect->y = SH_SLStart.UI();
+ DisplayRect->h = SH_SLEnd.UI() - DisplayRect->y + 1;
 
  if(fx_vce.frame_interlaced)
  {
@@ -2490,12 +2600,125 @@ void KING_StartFrame(VDC **arg_vdc_chips, EmulateSpecStruct *espec)	//MDFN_Surfa
  }
 }
 
-static int rb_type;
 //  unsigned int width = (fx_vce.picture_mode & 0x08) ? 341 : 256;
 
+// BG layers, and chroma keying of the RAINBOW layer.
+static void DrawLineBG(king_line_t *ln)
+{
+ if(ln->rb_type == 1) // YUV
+ {
+  // Only chroma key when we're not in 7.16MHz pixel mode
+  if(ln->chroma_key)
+  {
+   const unsigned int ymin = ln->ChromaKeyY & 0xFF;
+   const unsigned int ymax = ln->ChromaKeyY >> 8;
+   const unsigned int umin = ln->ChromaKeyU & 0xFF;
+   const unsigned int umax = ln->ChromaKeyU >> 8;
+   const unsigned int vmin = ln->ChromaKeyV & 0xFF;
+   const unsigned int vmax = ln->ChromaKeyV >> 8;
+
+   if((ln->ChromaKeyY | ln->ChromaKeyU | ln->ChromaKeyV) == 0)
+   {
+    //puts("Opt: 0 chroma key");
+    for(int x = 0; x < 256; x++)
+    {
+     if(!(ln->rainbow_linebuffer[x] & 0xFFFFFF))
+      ln->rainbow_linebuffer[x] = 0;
+    }
+   }
+   else if(ymin == ymax && umin == umax && vmin == vmax)
+   {
+    const uint32 compare_color = (ymin << 16) | (umin << 8) | (vmin << 0);
+
+    //puts("Opt: Single color chroma key");
+
+    for(int x = 0; x < 256; x++)
+    {
+     if((ln->rainbow_linebuffer[x] & 0xFFFFFF) == compare_color)
+      ln->rainbow_linebuffer[x] = 0;
+    }
+   }
+   else if(ymin <= ymax && umin <= umax && vmin <= vmax)
+   {
+    const uint32 yv_min_sub = (ymin << 16) | vmin;
+    const uint32 u_min_sub = umin << 8;
+    const uint32 yv_max_add = ((0xFF - ymax) << 16) | (0xFF - vmax);
+    const uint32 u_max_add = (0xFF - umax) << 8;
+
+    for(int x = 0; x < 256; x++)
+    {
+     const uint32 pixel = ln->rainbow_linebuffer[x];
+     const uint32 yv = pixel & 0xFF00FF;
+     const uint32 u = pixel & 0x00FF00;
+     uint32 testie;
+
+     testie = ((yv - yv_min_sub) | (yv + yv_max_add)) & 0xFF00FF00;
+     testie |= ((u - u_min_sub) | (u + u_max_add)) & 0x00FF00FF;
+
+     if(!testie)
+      ln->rainbow_linebuffer[x] = 0;
+    }
+   }
+   else
+   {
+    //puts("Opt: color keying off\n");
+   }
+  }
+ }
+
+  /*
+      4 = Foremost
+      1 = Hindmost
+      0 = Hidden
+  */
+
+ MDFN_FastU32MemsetM8(ln->bg_linebuffer + 8, 0, 256);
+
+  // Only bother to draw the BGs if the microprogram is enabled.
+ if(king->MPROGControl & 0x1)
+ {
+  for(int prio = 1; prio <= 7; prio++)
+  {
+   for(int x = 0; x < 4; x++)
+   {
+    int thisprio = (king->priority >> (x * 3)) & 0x7;
+
+    if(BGLayerDisable & (1 << x)) continue;
+
+    if(thisprio == prio)
+    {
+     //if(fx_vce.raster_counter == 50)
+      // CanDrawBG_Fast(x);
+
+     // TODO/FIXME: TEST MORE
+     if(CanDrawBG_Fast(x)) // && (rand() & 1))
+	DrawBG_Fast(ln, x);
+     else
+      DrawBG(ln, x, 0);
+    }
+   }
+  }
+ }
+}
+
+static void QueueRender(const uint32 type, king_line_t *ln)
+{
+ KINGRenderCmd *cmd;
+
+ if(!RenderQueue->CanWrite())
+  RenderQueue->WaitCanWrite();
+
+ cmd = RenderQueue->WritePtr();
+ cmd->type = type;
+ cmd->ln = ln;
+ RenderQueue->WriteCommit();
+}
+
 static void DrawActive(void)
 {
- rb_type = -1;
+ king_line_t *ln = &KINGLines[KINGLineIndex];
+
+ ln->rb_type = -1;
 
  #ifdef WANT_DEBUGGER
  if(GfxDecode_Buf && GfxDecode_Line == (int32)fx_vce.raster_counter)
@@ -2557,7 +2780,7 @@ static void DrawActive(void)
    }
   }
 
-  rb_type = RAINBOW_FetchRaster(skip ? NULL : rainbow_linebuffer, LAYER_RAINBOW << 28, &vce_rendercache.palette_table_cache[((fx_vce.palette_offset[3] >> 0) & 0xFF) << 1]);
+  ln->rb_type = RAINBOW_FetchRaster(skip ? NULL : ln->rainbow_linebuffer, LAYER_RAINBOW << 28, &vce_rendercache.palette_table_cache[((fx_vce.palette_offset[3] >> 0) & 0xFF) << 1]);
 
   king->RAINBOWStartPending = FALSE;
  } // end   if(fx_vce.raster_counter < 262)
@@ -2566,118 +2789,39 @@ static void DrawActive(void)
  {
   if(!skip)
   {
-   if(rb_type == 1) // YUV
-   {
-    // Only chroma key when we're not in 7.16MHz pixel mode
-    if(!(fx_vce.picture_mode & 0x08))
-    {
-     const unsigned int ymin = fx_vce.ChromaKeyY & 0xFF;
-     const unsigned int ymax = fx_vce.ChromaKeyY >> 8;
-     const unsigned int umin = fx_vce.ChromaKeyU & 0xFF;
-     const unsigned int umax = fx_vce.ChromaKeyU >> 8;
-     const unsigned int vmin = fx_vce.ChromaKeyV & 0xFF;
-     const unsigned int vmax = fx_vce.ChromaKeyV >> 8;
-
-     if((fx_vce.ChromaKeyY | fx_vce.ChromaKeyU | fx_vce.ChromaKeyV) == 0)
-     {
-      //puts("Opt: 0 chroma key");
-      for(int x = 0; x < 256; x++)
-      {
-       if(!(rainbow_linebuffer[x] & 0xFFFFFF))
-        rainbow_linebuffer[x] = 0;
-      }
-     }
-     else if(ymin == ymax && umin == umax && vmin == vmax)
-     {
-      const uint32 compare_color = (ymin << 16) | (umin << 8) | (vmin << 0);
-
-      //puts("Opt: Single color chroma key");
-
-      for(int x = 0; x < 256; x++)
-      {
-       if((rainbow_linebuffer[x] & 0xFFFFFF) == compare_color)
-        rainbow_linebuffer[x] = 0;
-      }
-     }
-     else if(ymin <= ymax && umin <= umax && vmin <= vmax)
-     {
-      const uint32 yv_min_sub = (ymin << 16) | vmin;
-      const uint32 u_min_sub = umin << 8;
-      const uint32 yv_max_add = ((0xFF - ymax) << 16) | (0xFF - vmax);
-      const uint32 u_max_add = (0xFF - umax) << 8;
-
-      for(int x = 0; x < 256; x++)
-      {
-       const uint32 pixel = rainbow_linebuffer[x];
-       const uint32 yv = pixel & 0xFF00FF;
-       const uint32 u = pixel & 0x00FF00;
-       uint32 testie;
-
-       testie = ((yv - yv_min_sub) | (yv + yv_max_add)) & 0xFF00FF00;
-       testie |= ((u - u_min_sub) | (u + u_max_add)) & 0x00FF00FF;
-
-       if(!testie)
-        rainbow_linebuffer[x] = 0;
-      }
-     }
-     else
-     {
-      //puts("Opt: color keying off\n");
-     }
-    }
-   }
-
-    /*
-        4 = Foremost
-        1 = Hindmost
-        0 = Hidden
-    */
-
-   MDFN_FastU32MemsetM8(bg_linebuffer + 8, 0, 256);
-
-    // Only bother to draw the BGs if the microprogram is enabled.
-   if(king->MPROGControl & 0x1)
+   ln->raster_counter = fx_vce.raster_counter;
+   ln->bg_palette_offset[0] = fx_vce.palette_offset[1];
+   ln->bg_palette_offset[1] = fx_vce.palette_offset[2];
+   ln->chroma_key = !(fx_vce.picture_mode & 0x08);
+   ln->ChromaKeyY = fx_vce.ChromaKeyY;
+   ln->ChromaKeyU = fx_vce.ChromaKeyU;
+   ln->ChromaKeyV = fx_vce.ChromaKeyV;
+
+   if(RenderThread)
    {
-    for(int prio = 1; prio <= 7; prio++)
-    {
-     for(int x = 0; x < 4; x++)
-     {
-      int thisprio = (king->priority >> (x * 3)) & 0x7;
-
-      if(BGLayerDisable & (1 << x)) continue;
-
-      if(thisprio == prio)
-      {
-       //if(fx_vce.raster_counter == 50)
-        // CanDrawBG_Fast(x);
-
-       // TODO/FIXME: TEST MORE
-       if(CanDrawBG_Fast(x)) // && (rand() & 1))
-	DrawBG_Fast(bg_linebuffer, x);
-       else
-        DrawBG(bg_linebuffer, x, 0);
-      }
-     }
-    }
+    RenderBGPage = (king->PageSetting & 0x0010) ? 1 : 0;
+    RenderBGQueued++;
+    QueueRender(KING_RENDER_BG, ln);
    }
-
+   else
+    DrawLineBG(ln);
   } // end if(!skip)
  } // end if(fx_vce.raster_counter >= 22 && fx_vce.raster_counter < 262)
 }
 
-static INLINE void VDC_PIXELMIX(bool SPRCOMBO_ON, bool BGCOMBO_ON)
+static INLINE void VDC_PIXELMIX(const king_line_t *ln, bool SPRCOMBO_ON, bool BGCOMBO_ON)
 {
     static const uint32 vdc_layer_num[2] = { LAYER_VDC_BG << 28, LAYER_VDC_SPR << 28};
     const uint32 vdc_poffset[2] = {
-                                (((uint32)fx_vce.palette_offset[0] >> 0) & 0xFF) << 1, // BG
-                                (((uint32)fx_vce.palette_offset[0] >> 8) & 0xFF) << 1 // SPR
+                                (((uint32)ln->vdc_palette_offset >> 0) & 0xFF) << 1, // BG
+                                (((uint32)ln->vdc_palette_offset >> 8) & 0xFF) << 1 // SPR
                                };
 
-    const int width = fx_vce.dot_clock ? 342 : 256; // 342, not 341, to prevent garbage pixels in high dot clock mode.
+    const int width = ln->dot_clock ? 342 : 256; // 342, not 341, to prevent garbage pixels in high dot clock mode.
 
     for(int x = 0; x < width; x++)
     {
-     const uint32 zort[2] = { vdc_linebuffers[0][x], vdc_linebuffers[1][x] };
+     const uint32 zort[2] = { ln->vdc_linebuffers[0][x], ln->vdc_linebuffers[1][x] };
      uint32 tmp_pixel;
    
      /* SPR combination */
@@ -2696,25 +2840,25 @@ static INLINE void VDC_PIXELMIX(bool SPRCOMBO_ON, bool BGCOMBO_ON)
     }
 }
 
-static void MixVDC(void) NO_INLINE;
-static void MixVDC(void)
+static void MixVDC(const king_line_t *ln) NO_INLINE;
+static void MixVDC(const king_line_t *ln)
 {
     // Optimization for when both layers are disabled in the VCE.
-    if(!vce_rendercache.LayerPriority[LAYER_VDC_BG] && !vce_rendercache.LayerPriority[LAYER_VDC_SPR])
+    if(!ln->LayerPriority[LAYER_VDC_BG] && !ln->LayerPriority[LAYER_VDC_SPR])
     {
      MDFN_FastU32MemsetM8(vdc_linebuffer_yuved, 0, 512);
     }
-    else switch(fx_vce.picture_mode & 0xC0)
+    else switch(ln->vdc_combo)
     {
-     case 0x00: VDC_PIXELMIX(0, 0); break;      // None on
-     case 0x40: VDC_PIXELMIX(0, 1); break;      // BG combo on
-     case 0x80: VDC_PIXELMIX(1, 0); break;      // SPR combo on
-     case 0xC0: VDC_PIXELMIX(1, 1); break;      // Both on
+     case 0x00: VDC_PIXELMIX(ln, 0, 0); break;      // None on
+     case 0x40: VDC_PIXELMIX(ln, 0, 1); break;      // BG combo on
+     case 0x80: VDC_PIXELMIX(ln, 1, 0); break;      // SPR combo on
+     case 0xC0: VDC_PIXELMIX(ln, 1, 1); break;      // Both on
     }
 }
 
 
-static void MixLayers(void)
+static void MixLayers(const king_line_t *ln)
 {
  uint32 *pXBuf = surface->pixels;
 
@@ -2727,21 +2871,21 @@ static void MixLayers(void)
 
     for(int n = 0; n < 8; n++)
     {
-     priority_remap[n] = vce_rendercache.LayerPriority[n];
+     priority_remap[n] = ln->LayerPriority[n];
      //printf("%d: %d\n", n, priority_remap[n]);
     }
 
     // Rainbow layer disabled?
-    if(rb_type == -1 || RAINBOWLayerDisable)
+    if(ln->rb_type == -1 || RAINBOWLayerDisable)
      priority_remap[LAYER_RAINBOW] = 0;
 
     ble_cache[LAYER_NONE] = 0;
     for(int x = 0; x < 4; x++)
-     ble_cache[LAYER_BG0 + x] = (vce_rendercache.BLE >> (4 + x * 2)) & 0x3;
+     ble_cache[LAYER_BG0 + x] = (ln->BLE >> (4 + x * 2)) & 0x3;
 
-    ble_cache[LAYER_VDC_BG] = (vce_rendercache.BLE >> 0) & 0x3;
-    ble_cache[LAYER_VDC_SPR] = (vce_rendercache.BLE >> 2) & 0x3;
-    ble_cache[LAYER_RAINBOW] = (vce_rendercache.BLE >> 12) & 0x3;
+    ble_cache[LAYER_VDC_BG] = (ln->BLE >> 0) & 0x3;
+    ble_cache[LAYER_VDC_SPR] = (ln->BLE >> 2) & 0x3;
+    ble_cache[LAYER_RAINBOW] = (ln->BLE >> 12) & 0x3;
 
     for(int x = 0; x < 8; x++)
      if(ble_cache[x])
@@ -2757,22 +2901,22 @@ static void MixLayers(void)
 
     for(int x = 0; x < 3; x++)
     {
-     coeff_cache_y_fore[x] = vce_rendercache.coefficient_mul_table_y[(vce_rendercache.coefficients[x * 2 + 0] >> 8) & 0xF];
-     coeff_cache_u_fore[x] = vce_rendercache.coefficient_mul_table_uv[(vce_rendercache.coefficients[x * 2 + 0] >> 4) & 0xF];
-     coeff_cache_v_fore[x] = vce_rendercache.coefficient_mul_table_uv[(vce_rendercache.coefficients[x * 2 + 0] >> 0) & 0xF];
+     coeff_cache_y_fore[x] = vce_rendercache.coefficient_mul_table_y[(ln->coefficients[x * 2 + 0] >> 8) & 0xF];
+     coeff_cache_u_fore[x] = vce_rendercache.coefficient_mul_table_uv[(ln->coefficients[x * 2 + 0] >> 4) & 0xF];
+     coeff_cache_v_fore[x] = vce_rendercache.coefficient_mul_table_uv[(ln->coefficients[x * 2 + 0] >> 0) & 0xF];
 
-     coeff_cache_y_back[x] = vce_rendercache.coefficient_mul_table_y[(vce_rendercache.coefficients[x * 2 + 1] >> 8) & 0xF];
-     coeff_cache_u_back[x] = vce_rendercache.coefficient_mul_table_uv[(vce_rendercache.coefficients[x * 2 + 1] >> 4) & 0xF];
-     coeff_cache_v_back[x] = vce_rendercache.coefficient_mul_table_uv[(vce_rendercache.coefficients[x * 2 + 1] >> 0) & 0xF];
+     coeff_cache_y_back[x] = vce_rendercache.coefficient_mul_table_y[(ln->coefficients[x * 2 + 1] >> 8) & 0xF];
+     coeff_cache_u_back[x] = vce_rendercache.coefficient_mul_table_uv[(ln->coefficients[x * 2 + 1] >> 4) & 0xF];
+     coeff_cache_v_back[x] = vce_rendercache.coefficient_mul_table_uv[(ln->coefficients[x * 2 + 1] >> 0) & 0xF];
     }
 
     uint32 *target;
     uint32 BPC_Cache = (LAYER_NONE << 28); // Backmost pixel color(cache)
 
-    if(fx_vce.frame_interlaced)
-     target = pXBuf + surface->pitch32 * ((fx_vce.raster_counter - 22) * 2 + fx_vce.odd_field);
+    if(ln->frame_interlaced)
+     target = pXBuf + surface->pitch32 * ((ln->mix_raster_counter - 22) * 2 + ln->odd_field);
     else
-     target = pXBuf + surface->pitch32 * (fx_vce.raster_counter - 22);
+     target = pXBuf + surface->pitch32 * (ln->mix_raster_counter - 22);
     
 
     // If at least one layer is enabled with the HuC6261, hindmost color is palette[0]
@@ -2784,13 +2928,13 @@ static void MixLayers(void)
     //  or if it just outputs black.
     // TODO:  See if enabling front/back cellophane in high dot-clock mode will set the hindmost color, even though the cellophane color mixing
     //  is disabled in high dot-clock mode.
-    if(vce_rendercache.picture_mode & 0x7F00)
+    if(ln->picture_mode & 0x7F00)
      BPC_Cache |= vce_rendercache.palette_table_cache[0];
     else			
      BPC_Cache |= 0x008080;
 
 #define DOCELLO(pixpoo) \
-	if((pixel[pixpoo] >> 28) != LAYER_VDC_SPR || ((vce_rendercache.SPBL >> ((vdc_linebuffer[x] & 0xF0)>> 4)) & 1))	\
+	if((pixel[pixpoo] >> 28) != LAYER_VDC_SPR || ((ln->SPBL >> ((vdc_linebuffer[x] & 0xF0)>> 4)) & 1))	\
         {	\
          int which_co = (ble_cache[pixel[pixpoo] >> 28] - 1);	\
          uint8 back_y = coeff_cache_y_back[which_co][(zeout >> 16) & 0xFF];	\
@@ -2816,8 +2960,8 @@ static void MixLayers(void)
       uint32 prio[3];	\
       uint32 zeout = BPC_Cache;	\
       prio[0] = priority_remap[vdc_linebuffer_yuved[index_341] >> 28];  \
-      prio[1] = priority_remap[(bg_linebuffer + 8)[index_256] >> 28];	\
-      prio[2] = priority_remap[rainbow_linebuffer[index_256] >> 28];	\
+      prio[1] = priority_remap[(ln->bg_linebuffer + 8)[index_256] >> 28];	\
+      prio[2] = priority_remap[ln->rainbow_linebuffer[index_256] >> 28];	\
       pixel[0] = 0;	\
       pixel[1] = 0;	\
       pixel[2] = 0;	\
@@ -2826,8 +2970,8 @@ static void MixLayers(void)
        uint8 pi1 = VCEPrioMap[prio[0]][prio[1]][prio[2]][1];	\
        uint8 pi2 = VCEPrioMap[prio[0]][prio[1]][prio[2]][2];	\
        /*assert(pi0 == 3 || !pixel[pi0]);*/ pixel[pi0] = vdc_linebuffer_yuved[index_341]; 	\
-       /*assert(pi1 == 3 || !pixel[pi1]);*/ pixel[pi1] = (bg_linebuffer + 8)[index_256];	\
-       /*assert(pi2 == 3 || !pixel[pi2]);*/ pixel[pi2] = rainbow_linebuffer[index_256];		\
+       /*assert(pi1 == 3 || !pixel[pi1]);*/ pixel[pi1] = (ln->bg_linebuffer + 8)[index_256];	\
+       /*assert(pi2 == 3 || !pixel[pi2]);*/ pixel[pi2] = ln->rainbow_linebuffer[index_256];		\
       }
 
 #define LAYER_MIX_FINAL_NOCELLO	\
@@ -2946,14 +3090,120 @@ static void MixLayers(void)
      #include "king_mix_body.inc"
      #undef YUV888_TO_xxx
     }
-    DisplayRect->w = fx_vce.dot_clock ? HighDotClockWidth : 256;
+    DisplayRect->w = ln->dot_clock ? HighDotClockWidth : 256;
     DisplayRect->x = 0;
 
 	// FIXME
-    if(fx_vce.frame_interlaced)
-     LineWidths[(fx_vce.raster_counter - 22) * 2 + fx_vce.odd_field] = *DisplayRect;
+    if(ln->frame_interlaced)
+     LineWidths[(ln->mix_raster_counter - 22) * 2 + ln->odd_field] = *DisplayRect;
     else
-     LineWidths[fx_vce.raster_counter - 22] = *DisplayRect;
+     LineWidths[ln->mix_raster_counter - 22] = *DisplayRect;
+}
+
+static void MixLine(const king_line_t *ln)
+{
+ MixVDC(ln);
+ MixLayers(ln);
+}
+
+// The VDCs don't always output the full width the mixing reads(e.g. 341 pixels instead of 342 in 7.16MHz mode, or nothing at all when
+// skipping); the rest of the line is left over from the previous line.
+static void FinishVDCLine(void)
+{
+ const king_line_t *prev = &KINGLines[(KINGLineIndex + KING_LINE_COUNT - 1) % KING_LINE_COUNT];
+ king_line_t *ln = &KINGLines[KINGLineIndex];
+ const int32 start = skip ? 0 : vdc_lb_pos;
+
+ for(unsigned chip = 0; chip < 2; chip++)
+  memcpy(&ln->vdc_linebuffers[chip][start], &prev->vdc_linebuffers[chip][start], (512 - start) * sizeof(uint16));
+}
+
+static void MixActive(void)
+{
+ king_line_t *ln = &KINGLines[KINGLineIndex];
+
+ ln->mix_raster_counter = fx_vce.raster_counter;
+ ln->frame_interlaced = fx_vce.frame_interlaced;
+ ln->odd_field = fx_vce.odd_field;
+ ln->dot_clock = fx_vce.dot_clock;
+ ln->vdc_combo = fx_vce.picture_mode & 0xC0;
+ ln->vdc_palette_offset = fx_vce.palette_offset[0];
+
+ ln->picture_mode = vce_rendercache.picture_mode;
+ ln->CCR = vce_rendercache.CCR;
+ ln->BLE = vce_rendercache.BLE;
+ ln->SPBL = vce_rendercache.SPBL;
+ memcpy(ln->coefficients, vce_rendercache.coefficients, sizeof(ln->coefficients));
+ memcpy(ln->LayerPriority, vce_rendercache.LayerPriority, sizeof(ln->LayerPriority));
+
+ if(RenderThread)
+  QueueRender(KING_RENDER_MIX, ln);
+ else
+  MixLine(ln);
+}
+
+static int RenderThreadStart(void *arg)
+{
+ for(;;)
+ {
+  KINGRenderCmd *cmd;
+
+  if(!RenderQueue->CanRead())
+   RenderQueue->WaitCanRead();
+
+  cmd = RenderQueue->ReadPtr();
+
+  if(cmd->type == KING_RENDER_EXIT)
+  {
+   RenderQueue->ReadCommit();
+   break;
+  }
+
+  if(cmd->type == KING_RENDER_BG)
+  {
+   DrawLineBG(cmd->ln);
+   __atomic_add_fetch(&RenderBGDone, 1, __ATOMIC_RELEASE);
+  }
+  else
+   MixLine(cmd->ln);
+
+  RenderQueue->ReadCommit();
+ }
+
+ return(0);
+}
+
+static void SetThreadedRender(bool threaded)
+{
+ if(RenderThread)
+ {
+  QueueRender(KING_RENDER_EXIT, NULL);
+
+  MDFND_WaitThread(RenderThread, NULL);
+  RenderThread = NULL;
+ }
+
+ if(RenderQueue)
+ {
+  delete RenderQueue;
+  RenderQueue = NULL;
+ }
+
+ RenderBGQueued = 0;
+ RenderBGDone = 0;
+
+ if(threaded)
+ {
+  RenderQueue = new SPSCQueue<KINGRenderCmd>(8);
+
+  if(!(RenderThread = MDFND_CreateThread(RenderThreadStart, NULL)))
+  {
+   MDFN_printf(_("Error creating KING render thread; falling back to non-threaded rendering.\n"));
+
+   delete RenderQueue;
+   RenderQueue = NULL;
+  }
+ }
 }
 
 static INLINE void RunVDCs(const int master_cycles, uint16 *pixels0, uint16 *pixels1)
@@ -3005,7 +3255,7 @@ static void MDFN_FASTCALL KING_RunGfx(int32 clocks)
   }
   else
   {
-   RunVDCs(chunk_clocks, vdc_linebuffers[0], vdc_linebuffers[1]);
+   RunVDCs(chunk_clocks, KINGLines[KINGLineIndex].vdc_linebuffers[0], KINGLines[KINGLineIndex].vdc_linebuffers[1]);
   }
 
   assert(HPhaseCounter >= 0);
@@ -3017,19 +3267,19 @@ static void MDFN_FASTCALL KING_RunGfx(int32 clocks)
    {
     case HPHASE_ACTIVE: vdc_lb_pos = 0;
 			fx_vce.in_hblank = false;
+			KINGLineIndex = (KINGLineIndex + 1) % KING_LINE_COUNT;
 			DoHBlankVCECaching();
 			DrawActive();
 			HPhaseCounter += 1024;
 			break;
 
     case HPHASE_HBLANK_PART1:
+			FinishVDCLine();
+
                         if(!skip)
                         {
                          if(fx_vce.raster_counter >= 22 && fx_vce.raster_counter < 262)
-                         {
-                          MixVDC();
-                          MixLayers();
-                         }
+                          MixActive();
                         }
 			fx_vce.in_hblank = true;
                         fx_vce.in_vdc_hsync = true;
@@ -3063,6 +3313,7 @@ static void MDFN_FASTCALL KING_RunGfx(int32 clocks)
 			 if(!fx_vce.frame_interlaced)
 			  fx_vce.odd_field = 0;
 
+			 SyncRender();
 			 PCFX_V810.Exit();
 			}
 
@@ -3108,6 +3359,8 @@ static void MDFN_FASTCALL KING_RunGfx(int32 clocks)
 
 void KING_SetPixelFormat(const MDFN_PixelFormat &format) 
 {
+ SyncRender();
+
  rs = format.Rshift;
  gs = format.Gshift;
  bs = format.Bshift;
@@ -3116,6 +3369,8 @@ void KING_SetPixelFormat(const MDFN_PixelFormat &format)
 
 void KING_SetLayerEnableMask(uint64 mask)
 {
+ SyncRender();
+
  uint64 ms = mask;
  // "BG0\0BG1\0BG2\0BG3\0VDC-A BG\0VDC-A SPR\0VDC-B BG\0VDC-B SPR\0RAINBOW\0",
 
@@ -3158,6 +3413,8 @@ void KING_SetLayerEnableMask(uint64 mask)
 
 int KING_StateAction(StateMem *sm, int load, int data_only)
 {
+ SyncRender();
+
  SFORMAT KINGStateRegs[] =
  {
   SFVARN(king->AR, "AR"),
@@ -3315,6 +3572,7 @@ int KING_StateAction(StateMem *sm, int load, int data_only)
 #ifdef WANT_DEBUGGER
 void KING_SetRegister(const std::string &name, uint32 value)
 {
+ SyncRender();
 
  if(name == "AR")
   king->AR = value & 0x7F;
@@ -3777,6 +4035,8 @@ uint32 KING_GetRegister(const std::string &name, std::string *special)
 
 void FXVDCVCE_SetRegister(const std::string &name, uint32 value)
 {
+ SyncRender();
+
  if(name == "VCEPRIO0")
  {
   fx_vce.priority[0] = value & 0x0777;
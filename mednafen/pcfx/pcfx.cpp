@@ -527,7 +527,9 @@ static bool LoadCommon(std::vector<CDIF *> *CDInterfaces)
   return(0);
  }
 
- if(!(BIOSROM = PCFX_V810.SetFastMap(BIOSROM_Map_Addresses, 0x00100000, 1, _("BIOS ROM"))))
+ // BIOS ROM reads only cost a fixed 2 wait states in mem_rbyte()/mem_rhword(), so LD instructions can read it directly.  RAM can't
+ // be read directly, its page-miss penalty depends on RAM_LPA.
+ if(!(BIOSROM = PCFX_V810.SetFastMap(BIOSROM_Map_Addresses, 0x00100000, 1, _("BIOS ROM"), V810_FAST_MAP_DIRECT_READ, 2)))
  {
   return(0);
  }
@@ -1087,6 +1089,8 @@ static MDFNSetting PCFXSettings[] =
   { "pcfx.slstart", MDFNSF_NOFLAGS, gettext_noop("First rendered scanline."), NULL, MDFNST_UINT, "4", "0", "239" },
   { "pcfx.slend", MDFNSF_NOFLAGS, gettext_noop("Last rendered scanline."), NULL, MDFNST_UINT, "235", "0", "239" },
 
+  { "pcfx.threaded_render", MDFNSF_NOFLAGS, gettext_noop("Composite KING/VCE scanlines on a separate thread."), gettext_noop("The BG layers and final layer mixing for each scanline are done by a separate render thread while the emulation continues with the following scanlines.  Output is identical to non-threaded rendering.  Takes effect when a game is loaded."), MDFNST_BOOL, "0" },
+
   { "pcfx.rainbow.chromaip", MDFNSF_NOFLAGS, gettext_noop("Enable bilinear interpolation on the chroma channel of RAINBOW YUV output."), gettext_noop("This is an enhancement-related setting.  Enabling it may cause graphical glitches with some games."), MDFNST_BOOL, "0" },
 
   { "pcfx.adpcm.suppress_channel_reset_clicks", MDFNSF_NOFLAGS, gettext_noop("Hack to suppress clicks caused by forced channel resets."), NULL, MDFNST_BOOL, "1" },
@@ -1104,7 +1104,7 @@ pscpu_timestamp_t PS_CDC::Update(const pscpu_timestamp_t timestamp)
     else if(DriveStatus == DS_SEEKING)
     {
      CurSector = SeekTarget;
-     Cur_CDIF->ReadRawSector(buf, CurSector);
+     Cur_CDIF->ReadRawSector(buf, CurSector, false);
      DecodeSubQ(buf + 2352);
 
      DriveStatus = StatusAfterSeek;
@@ -1117,7 +1117,7 @@ pscpu_timestamp_t PS_CDC::Update(const pscpu_timestamp_t timestamp)
     else if(DriveStatus == DS_SEEKING_LOGICAL)
     {
      CurSector = SeekTarget;
-     Cur_CDIF->ReadRawSector(buf, CurSector);
+     Cur_CDIF->ReadRawSector(buf, CurSector, false);
      DecodeSubQ(buf + 2352);
      memcpy(HeaderBuf, buf + 12, 12);
 
@@ -1610,7 +1610,7 @@ void PS_CDC::PreSeekHack(bool logical, uint32 target)
  {
   do
   {
-   Cur_CDIF->ReadRawSector(buf, target++);
+   Cur_CDIF->ReadRawSector(buf, target++, false);
 
    // GetLocL related kludge, for Gran Turismo 1 music, perhaps others?
    if(NeedHBuf)
@@ -140,10 +140,10 @@ static INLINE bool ChCan(const unsigned ch, const uint32 CRModeCache)
 	abort();
 
   case CH_MDEC_IN:
-	return(MDEC_DMACanWrite());
+	return(MDEC->DMACanWrite());
 
   case CH_MDEC_OUT:
-	return(MDEC_DMACanRead());
+	return(MDEC->DMACanRead());
   
   case CH_GPU: 
 	if(CRModeCache & 0x1)
@@ -204,10 +204,10 @@ static void RecalcHalt(void)
  }
 
 #if 0
- if((DMACH[0].WordCounter || (DMACH[0].ChanControl & (1 << 24))) && (DMACH[0].ChanControl & 0x200) /*&& MDEC_DMACanWrite()*/)
+ if((DMACH[0].WordCounter || (DMACH[0].ChanControl & (1 << 24))) && (DMACH[0].ChanControl & 0x200) /*&& MDEC->DMACanWrite()*/)
   Halt = true;
 
- if((DMACH[1].WordCounter || (DMACH[1].ChanControl & (1 << 24))) && (DMACH[1].ChanControl & 0x200) && (DMACH[1].WordCounter || MDEC_DMACanRead()))
+ if((DMACH[1].WordCounter || (DMACH[1].ChanControl & (1 << 24))) && (DMACH[1].ChanControl & 0x200) && (DMACH[1].WordCounter || MDEC->DMACanRead()))
   Halt = true;
 
  if((DMACH[2].WordCounter || (DMACH[2].ChanControl & (1 << 24))) && (DMACH[2].ChanControl & 0x200) && ((DMACH[2].ChanControl & 0x1) && (DMACH[2].WordCounter || GPU->DMACanWrite())))
@@ -253,7 +253,7 @@ static INLINE void ChRW(const unsigned ch, const uint32 CRModeCache, uint32 *V)
 
   case CH_MDEC_IN:
 	  if(CRModeCache & 0x1)
-	   MDEC_DMAWrite(*V);
+	   MDEC->DMAWrite(*V);
 	  else
 	   *V = 0;
 	  break;
@@ -263,7 +263,7 @@ static INLINE void ChRW(const unsigned ch, const uint32 CRModeCache, uint32 *V)
 	  {
 	  }
 	  else
-	   *V = MDEC_DMARead();
+	   *V = MDEC->DMARead();
 	  break;
 
   case CH_GPU:
@@ -588,7 +588,7 @@ pscpu_timestamp_t DMA_Update(const pscpu_timestamp_t timestamp)
  lastts = timestamp;
 
  GPU->Update(timestamp);
- MDEC_Run(clocks);
+ MDEC->Run(clocks);
 
  RunChannel(timestamp, clocks, 0);
  RunChannel(timestamp, clocks, 1);
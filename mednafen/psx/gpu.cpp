@@ -100,10 +100,22 @@ static const int32 dither_table[4][4] =
  {  3, -1,  2, -2 },
 };
 
-PS_GPU::PS_GPU(bool pal_clock_and_tv, int sls, int sle) : BlitterFIFO(0x20) // 0x10 on actual PS1 GPU, 0x20 here(see comment at top of gpu.h)	// 0x10)
+static int RenderThreadStart_C(void *v_arg)
+{
+ return ((PS_GPU *)v_arg)->RenderThreadStart();
+}
+
+PS_GPU::PS_GPU(bool pal_clock_and_tv, int sls, int sle, bool threaded) : BlitterFIFO(0x20) // 0x10 on actual PS1 GPU, 0x20 here(see comment at top of gpu.h)	// 0x10)
 {
  HardwarePALType = pal_clock_and_tv;
 
+ GPURAM = new uint16[512][1024];
+
+ RasterEnable = true;
+ RenderGPU = NULL;
+ RenderQueue = NULL;
+ RenderThread = NULL;
+
  for(int y = 0; y < 4; y++)
   for(int x = 0; x < 4; x++)
    for(int v = 0; v < 512; v++)
@@ -139,11 +151,57 @@ PS_GPU::PS_GPU(bool pal_clock_and_tv, int sls, int sle) : BlitterFIFO(0x20) // 0
 
  LineVisFirst = sls;
  LineVisLast = sle;
+
+ if(threaded)
+ {
+  RenderGPU = new PS_GPU(pal_clock_and_tv, sls, sle, false);
+  delete[] RenderGPU->GPURAM;
+  RenderGPU->GPURAM = GPURAM;
+
+  RenderQueue = new SPSCQueue<RenderCmd>(1024);
+
+  if(!(RenderThread = MDFND_CreateThread(RenderThreadStart_C, this)))
+  {
+   PSX_WARNING("[GPU] Error creating render thread; falling back to non-threaded rendering.");
+
+   delete RenderQueue;
+   RenderQueue = NULL;
+
+   RenderGPU->GPURAM = NULL;
+   delete RenderGPU;
+   RenderGPU = NULL;
+  }
+  else
+   RasterEnable = false;
+ }
 }
 
 PS_GPU::~PS_GPU()
 {
+ if(RenderThread)
+ {
+  RenderCmd *rc;
+
+  if(!RenderQueue->CanWrite())
+   RenderQueue->WaitCanWrite();
+
+  rc = RenderQueue->WritePtr();
+  rc->func = NULL;
+  RenderQueue->WriteCommit();
+
+  MDFND_WaitThread(RenderThread, NULL);
+  RenderThread = NULL;
+
+  delete RenderQueue;
+  RenderQueue = NULL;
+
+  RenderGPU->GPURAM = NULL;
+  delete RenderGPU;
+  RenderGPU = NULL;
+ }
 
+ delete[] GPURAM;
+ GPURAM = NULL;
 }
 
 void PS_GPU::SoftReset(void) // Control command 0x00
@@ -221,7 +279,8 @@ void PS_GPU::SoftReset(void) // Control command 0x00
 
 void PS_GPU::Power(void)
 {
- memset(GPURAM, 0, sizeof(GPURAM));
+ Fence();
+ memset(GPURAM, 0, sizeof(*GPURAM) * 512);
 
  DMAControl = 0;
 
@@ -466,6 +525,9 @@ void PS_GPU::Command_FBFill(const uint32 *cb)
  DrawTimeAvail -= 46;	// Approximate
  DrawTimeAvail -= ((width * height) >> 3) + (height * 9);
 
+ if(!RasterEnable)
+  return;
+
  for(int32 y = 0; y < height; y++)
  {
   const int32 d_y = (y + destY) & 511;
@@ -503,6 +565,8 @@ void PS_GPU::Command_FBCopy(const uint32 *cb)
 
  DrawTimeAvail -= (width * height) * 2;
 
+ Fence();
+
  for(int32 y = 0; y < height; y++)
  {
   for(int32 x = 0; x < width; x++)
@@ -523,6 +587,9 @@ void PS_GPU::Command_FBWrite(const uint32 *cb)
 {
  assert(InCmd == INCMD_NONE);
 
+ // The data itself is written to GPURAM directly from ProcessFIFO(), and nothing else can be queued while INCMD_FBWRITE is in effect.
+ Fence();
+
  FBRW_X = (cb[1] >>  0) & 0x3FF;
  FBRW_Y = (cb[1] >> 16) & 0x3FF;
 
@@ -546,6 +613,8 @@ void PS_GPU::Command_FBRead(const uint32 *cb)
 {
  assert(InCmd == INCMD_NONE);
 
+ Fence();
+
  FBRW_X = (cb[1] >>  0) & 0x3FF;
  FBRW_Y = (cb[1] >> 16) & 0x3FF;
 
@@ -680,11 +749,127 @@ CTEntry PS_GPU::Commands[4][256] =
 
 static uint64 PrimitiveCounter[256] = { 0 }; // Debug
 
+INLINE void PS_GPU::RunCommand(void (PS_GPU::*func)(const uint32 *cb), const uint32 *cb, unsigned cb_len, bool deferrable)
+{
+ RenderCmd *rc;
+
+ if(!RenderQueue || !deferrable)
+ {
+  ((this)->*func)(cb);
+  return;
+ }
+
+ if(MDFN_UNLIKELY(!RenderQueue->CanWrite()))
+  RenderQueue->WaitCanWrite();
+
+ rc = RenderQueue->WritePtr();
+
+ rc->func = func;
+ memcpy(rc->CB, cb, cb_len * sizeof(uint32));
+
+ // Must be captured before func is called, since it may change InCmd.
+ rc->InCmd = InCmd;
+ rc->dtd = dtd;
+ rc->dfe = dfe;
+ rc->field_ram_readout = field_ram_readout;
+ rc->tww = tww;
+ rc->twh = twh;
+ rc->twx = twx;
+ rc->twy = twy;
+
+ rc->ClipX0 = ClipX0;
+ rc->ClipY0 = ClipY0;
+ rc->ClipX1 = ClipX1;
+ rc->ClipY1 = ClipY1;
+ rc->OffsX = OffsX;
+ rc->OffsY = OffsY;
+ rc->MaskSetOR = MaskSetOR;
+ rc->MaskEvalAND = MaskEvalAND;
+
+ rc->TexPageX = TexPageX;
+ rc->TexPageY = TexPageY;
+ rc->SpriteFlip = SpriteFlip;
+ rc->abr = abr;
+ rc->TexMode = TexMode;
+
+ rc->DisplayMode = DisplayMode;
+ rc->DisplayFB_YStart = DisplayFB_YStart;
+
+ // Timing(and InCmd/InQuad/InPLine bookkeeping) only; RasterEnable is false.
+ ((this)->*func)(cb);
+
+ RenderQueue->WriteCommit();
+}
+
+void PS_GPU::LoadRenderCmdState(const RenderCmd *rc)
+{
+ InCmd = rc->InCmd;
+ dtd = rc->dtd;
+ dfe = rc->dfe;
+ field_ram_readout = rc->field_ram_readout;
+
+ if(tww != rc->tww || twh != rc->twh || twx != rc->twx || twy != rc->twy)
+ {
+  tww = rc->tww;
+  twh = rc->twh;
+  twx = rc->twx;
+  twy = rc->twy;
+  RecalcTexWindowLUT();
+ }
+
+ ClipX0 = rc->ClipX0;
+ ClipY0 = rc->ClipY0;
+ ClipX1 = rc->ClipX1;
+ ClipY1 = rc->ClipY1;
+ OffsX = rc->OffsX;
+ OffsY = rc->OffsY;
+ MaskSetOR = rc->MaskSetOR;
+ MaskEvalAND = rc->MaskEvalAND;
+
+ TexPageX = rc->TexPageX;
+ TexPageY = rc->TexPageY;
+ SpriteFlip = rc->SpriteFlip;
+ abr = rc->abr;
+ TexMode = rc->TexMode;
+
+ DisplayMode = rc->DisplayMode;
+ DisplayFB_YStart = rc->DisplayFB_YStart;
+}
+
+int PS_GPU::RenderThreadStart(void)
+{
+ for(;;)
+ {
+  const RenderCmd *rc;
+
+  if(!RenderQueue->CanRead())
+   RenderQueue->WaitCanRead();
+
+  rc = RenderQueue->ReadPtr();
+
+  if(!rc->func)
+  {
+   RenderQueue->ReadCommit();
+   break;
+  }
+
+  RenderGPU->LoadRenderCmdState(rc);
+  ((RenderGPU)->*(rc->func))(rc->CB);
+
+  // Only after the command has been fully drawn, so that Fence() on the emu thread means what it says.
+  RenderQueue->ReadCommit();
+ }
+
+ return(1);
+}
+
 void PS_GPU::ProcessFIFO(void)
 {
  if(!BlitterFIFO.CanRead())
   return;
 
+ PSX_PROF_SCOPE(PSX_PROF_GPU_RASTER);
+
  switch(InCmd)
  {
   default:
@@ -741,7 +926,7 @@ void PS_GPU::ProcessFIFO(void)
 	  CB[i] = BlitterFIFO.ReadUnit();
 	 }
 
-	 ((this)->*(command->func[TexMode | (MaskEvalAND ? 0x4 : 0x0)]))(CB);
+	 RunCommand(command->func[TexMode | (MaskEvalAND ? 0x4 : 0x0)], CB, vl, true);
 	}
 	return;
        }
@@ -771,7 +956,7 @@ void PS_GPU::ProcessFIFO(void)
 	  CB[i] = BlitterFIFO.ReadUnit();
 	 }
 
-	 ((this)->*(command->func[TexMode | (MaskEvalAND ? 0x4 : 0x0)]))(CB);
+	 RunCommand(command->func[TexMode | (MaskEvalAND ? 0x4 : 0x0)], CB, vl, true);
 	}
 	return;
        }
@@ -832,7 +1017,7 @@ void PS_GPU::ProcessFIFO(void)
    command = &Commands[abr][cc];
 
    //int32 olddt = DrawTimeAvail;
-   ((this)->*(command->func[TexMode | (MaskEvalAND ? 0x4 : 0x0)]))(CB);
+   RunCommand(command->func[TexMode | (MaskEvalAND ? 0x4 : 0x0)], CB, command->len, cc == 0x02 || (cc >= 0x20 && cc <= 0x7F));
    //printf("COMMAND: %08x -- %8d ---- scanline=%d -- adta=%8d\n", CB[0], DrawTimeAvail - olddt, scanline, DrawTimeAvail);
   }
  }
@@ -1370,6 +1555,8 @@ pscpu_timestamp_t PS_GPU::Update(const pscpu_timestamp_t sys_timestamp)
      LineWidths[dest_line].x = 0;
      LineWidths[dest_line].w = dmw;
 
+     Fence();
+
      {
       const uint16 *src = GPURAM[DisplayFB_CurLineYReadout];
       const uint32 black = surface->MakeColor(0, 0, 0);
@@ -5,6 +5,7 @@
 #define __MDFN_PSX_GPU_H
 
 #include "../cdrom/SimpleFIFO.h"
+#include "../SPSCQueue.h"
 
 namespace MDFN_IEN_PSX
 {
@@ -40,7 +41,7 @@ class PS_GPU
 {
  public:
 
- PS_GPU(bool pal_clock_and_tv, int sls, int sle) MDFN_COLD;
+ PS_GPU(bool pal_clock_and_tv, int sls, int sle, bool threaded = false) MDFN_COLD;
  ~PS_GPU() MDFN_COLD;
 
  void Power(void) MDFN_COLD;
@@ -87,14 +88,19 @@ class PS_GPU
 
  INLINE uint16 PeekRAM(uint32 A)
  {
+  Fence();
   return(GPURAM[(A >> 10) & 0x1FF][A & 0x3FF]);
  }
 
  INLINE void PokeRAM(uint32 A, uint16 V)
  {
+  Fence();
   GPURAM[(A >> 10) & 0x1FF][A & 0x3FF] = V;
  }
 
+ // FIXME: Semi-private:
+ int RenderThreadStart(void);
+
  private:
 
  void ProcessFIFO(void);
@@ -103,7 +109,7 @@ class PS_GPU
  void SoftReset(void);
 
  // Y, X
- uint16 GPURAM[512][1024];
+ uint16 (*GPURAM)[1024];
 
  uint32 DMAControl;
 
@@ -209,6 +215,51 @@ class PS_GPU
 
  static CTEntry Commands[4][256];
 
+ //
+ // Threaded rasterization("psx.gpu.threaded").
+ //
+ // The emu thread still runs every drawing command itself, with RasterEnable false, so that DrawTimeAvail is charged exactly
+ // as it would be otherwise; the command is then replayed, with a snapshot of the drawing environment it was issued under, by RenderGPU
+ // on the render thread.  GPURAM is shared with RenderGPU, and belongs to the render thread until Fence() returns.
+ //
+ struct RenderCmd
+ {
+  void (PS_GPU::*func)(const uint32 *cb);	// NULL to make the render thread exit.
+  uint32 CB[0x10];
+
+  uint8 InCmd;
+  bool dtd;
+  bool dfe;
+  bool field_ram_readout;
+  uint8 tww, twh, twx, twy;
+
+  int32 ClipX0, ClipY0, ClipX1, ClipY1;
+  int32 OffsX, OffsY;
+  uint32 MaskSetOR, MaskEvalAND;
+
+  int32 TexPageX, TexPageY;
+  uint32 SpriteFlip;
+  uint32 abr;
+  uint32 TexMode;
+
+  uint32 DisplayMode;
+  uint32 DisplayFB_YStart;
+ };
+
+ void RunCommand(void (PS_GPU::*func)(const uint32 *cb), const uint32 *cb, unsigned cb_len, bool deferrable);
+ void LoadRenderCmdState(const RenderCmd *rc);
+
+ INLINE void Fence(void)
+ {
+  if(RenderQueue)
+   RenderQueue->WaitEmpty();
+ }
+
+ bool RasterEnable;
+ PS_GPU *RenderGPU;
+ SPSCQueue<RenderCmd> *RenderQueue;
+ MDFN_Thread *RenderThread;
+
  SimpleFIFO<uint32> BlitterFIFO;
 
  uint32 DataReadBuffer;
@@ -20,10 +20,28 @@
 #include "gte.h"
 #endif
 
-static uint32 ReciprocalTable[0x8000] =
+// Set to 1 to compute the RTPS/RTPT reciprocal the way the hardware does(a 257-entry table and two Newton-Raphson steps) instead
+// of looking it up in the 128KiB precomputed table; the results are identical for every divisor.
+#define GTE_DIVIDE_UNR 0
+
+#if GTE_DIVIDE_UNR
+static uint8 UNRTable[0x101];
+
+static void InitUNRTable(void)
+{
+ for(int i = 0; i < 0x101; i++)
+ {
+  const int32 tmp = ((0x40000 / (i + 0x100)) + 1) / 2 - 0x101;
+
+  UNRTable[i] = (tmp < 0) ? 0 : tmp;
+ }
+}
+#else
+static const uint32 ReciprocalTable[0x8000] =
 {
  #include "gte_divrecip.inc"
 };
+#endif
 
 /* Notes:
 
@@ -201,6 +219,10 @@ static INLINE uint8 Sat5(int16 cc)
 
 void GTE_Power(void)
 {
+#if GTE_DIVIDE_UNR
+ InitUNRTable();
+#endif
+
  memset(CR, 0, sizeof(CR));
  //memset(DR, 0, sizeof(DR));
 
@@ -920,10 +942,60 @@ INLINE void MAC_to_IR(int lm)
  IR3 = Lm_B(2, MAC[3], lm);
 }
 
+//
+// crv + matrix * v for "count"(up to 3) vectors, with the 44-bit accumulator overflow checks and wrapping that A_MV() does after each
+// addition; results(before the sf shift) go to "tmp".  Not for the AbbyNormal matrix or the FC vector, see MultiplyMatrixByVector().
+//
+static INLINE void MultiplyMatrixByVectors(const gtematrix *matrix, const int16 *const *v, unsigned count, const int32 *crv, int64 (*tmp)[3])
+{
+ // Each product is within [-2**30, 2**30], so with |crv| < 2**31 - 2**20(i.e. anything but a huge translation vector) no partial
+ // sum can reach the +/-2**43 overflow limits, and we can skip A_MV() altogether.
+ if(((uint32)crv[0] + 0x7FF00000) < 0xFFE00000 && ((uint32)crv[1] + 0x7FF00000) < 0xFFE00000 && ((uint32)crv[2] + 0x7FF00000) < 0xFFE00000)
+ {
+  for(unsigned j = 0; j < count; j++)
+  {
+   for(unsigned i = 0; i < 3; i++)
+   {
+    tmp[j][i] = ((int64)crv[i] << 12) + (int64)(matrix->MX[i][0] * v[j][0]) + (int64)(matrix->MX[i][1] * v[j][1]) + (int64)(matrix->MX[i][2] * v[j][2]);
+   }
+  }
+  return;
+ }
+
+ for(unsigned j = 0; j < count; j++)
+ {
+  for(unsigned i = 0; i < 3; i++)
+  {
+   tmp[j][i] = (int64)crv[i] << 12;
+
+   tmp[j][i] = A_MV(i, tmp[j][i] + matrix->MX[i][0] * v[j][0]);
+   tmp[j][i] = A_MV(i, tmp[j][i] + matrix->MX[i][1] * v[j][1]);
+   tmp[j][i] = A_MV(i, tmp[j][i] + matrix->MX[i][2] * v[j][2]);
+  }
+ }
+}
+
+static INLINE void MAC_from_tmp(const int64 *tmp, uint32 sf)
+{
+ MAC[1] = tmp[0] >> sf;
+ MAC[2] = tmp[1] >> sf;
+ MAC[3] = tmp[2] >> sf;
+}
+
 INLINE void MultiplyMatrixByVector(const gtematrix *matrix, const int16 *v, const int32 *crv, uint32 sf, int lm)
 {
  unsigned i;
 
+ if(matrix != &Matrices.AbbyNormal && crv != CRVectors.FC)
+ {
+  int64 tmp[1][3];
+
+  MultiplyMatrixByVectors(matrix, &v, 1, crv, tmp);
+  MAC_from_tmp(tmp[0], sf);
+  MAC_to_IR(lm);
+  return;
+ }
+
  for(i = 0; i < 3; i++)
  {
   int64 tmp;
@@ -970,28 +1042,10 @@ INLINE void MultiplyMatrixByVector(const gtematrix *matrix, const int16 *v, cons
  MAC_to_IR(lm);
 }
 
-
-INLINE void MultiplyMatrixByVector_PT(const gtematrix *matrix, const int16 *v, const int32 *crv, uint32 sf, int lm)
+// Second half of MultiplyMatrixByVector_PT(), given the results of MultiplyMatrixByVectors().
+static INLINE void PT_Finish(const int64 *tmp, uint32 sf, int lm)
 {
- int64 tmp[3];
- unsigned i;
-
- for(i = 0; i < 3; i++)
- {
-  int32 mulr[3];
-
-  tmp[i] = (int64)crv[i] << 12;
-
-  mulr[0] = matrix->MX[i][0] * v[0];
-  mulr[1] = matrix->MX[i][1] * v[1];
-  mulr[2] = matrix->MX[i][2] * v[2];
-
-  tmp[i] = A_MV(i, tmp[i] + mulr[0]);
-  tmp[i] = A_MV(i, tmp[i] + mulr[1]);
-  tmp[i] = A_MV(i, tmp[i] + mulr[2]);
-
-  MAC[1 + i] = tmp[i] >> sf;
- }
+ MAC_from_tmp(tmp, sf);
 
  IR1 = Lm_B(0, MAC[1], lm);
  IR2 = Lm_B(1, MAC[2], lm);
@@ -1004,6 +1058,34 @@ INLINE void MultiplyMatrixByVector_PT(const gtematrix *matrix, const int16 *v, c
  Z_FIFO[3] = Lm_D(tmp[2] >> 12, TRUE);
 }
 
+INLINE void MultiplyMatrixByVector_PT(const gtematrix *matrix, const int16 *v, const int32 *crv, uint32 sf, int lm)
+{
+ int64 tmp[1][3];
+
+ MultiplyMatrixByVectors(matrix, &v, 1, crv, tmp);
+ PT_Finish(tmp[0], sf, lm);
+}
+
+//
+// Light and color matrix passes of NCT/NCCT/NCDT for all three vectors at once.  Only the IR values from the light pass feed into the
+// color pass, and the FLAG bits are just OR'd together, so the caller ends up with the same state as doing each vertex in turn by
+// setting MAC from "color_tmp" and calling MAC_to_IR() per vertex.
+//
+static INLINE void NormColorVectors(uint32 sf, int lm, int64 (*color_tmp)[3])
+{
+ int64 light_tmp[3][3];
+ int16 light_ir[3][3];
+ const int16 *light_v[3] = { Vectors[0], Vectors[1], Vectors[2] };
+ const int16 *color_v[3] = { light_ir[0], light_ir[1], light_ir[2] };
+
+ MultiplyMatrixByVectors(&Matrices.Light, light_v, 3, CRVectors.Null, light_tmp);
+
+ for(unsigned j = 0; j < 3; j++)
+  for(unsigned i = 0; i < 3; i++)
+   light_ir[j][i] = Lm_B(i, light_tmp[j][i] >> sf, lm);
+
+ MultiplyMatrixByVectors(&Matrices.Color, color_v, 3, CRVectors.B, color_tmp);
+}
 
 #define DECODE_FIELDS							\
  const uint32 sf MDFN_NOWARN_UNUSED = (instr & (1 << 19)) ? 12 : 0;		\
@@ -1072,7 +1154,19 @@ static INLINE uint32 Divide(uint32 dividend, uint32 divisor)
   dividend <<= shift_bias;
   divisor <<= shift_bias;
 
+#if GTE_DIVIDE_UNR
+  {
+   const uint32 u = UNRTable[(divisor - 0x7FC0) >> 7] + 0x101;
+   uint32 recip;
+
+   recip = (0x2000080 - divisor * u) >> 8;
+   recip = (0x80 + recip * u) >> 8;
+
+   return ((int64)dividend * recip + 32768) >> 16;
+  }
+#else
   return ((int64)dividend * ReciprocalTable[divisor & 0x7FFF] + 32768) >> 16;
+#endif
  }
  else
  {
@@ -1117,13 +1211,18 @@ int32 RTPS(uint32 instr)
 int32 RTPT(uint32 instr)
 {
  DECODE_FIELDS;
+ const int16 *vs[3] = { Vectors[0], Vectors[1], Vectors[2] };
+ int64 tmp[3][3];
  int i;
 
+ // The matrix products don't depend on each other, only the per-vertex FIFO pushes have to be done in order.
+ MultiplyMatrixByVectors(&Matrices.Rot, vs, 3, CRVectors.T, tmp);
+
  for(i = 0; i < 3; i++)
  {
   int64 h_div_sz;
 
-  MultiplyMatrixByVector_PT(&Matrices.Rot, Vectors[i], CRVectors.T, sf, lm);
+  PT_Finish(tmp[i], sf, lm);
   h_div_sz = Divide(H, Z_FIFO[3]);
 
   TransformXY(h_div_sz);
@@ -1159,14 +1258,32 @@ int32 NCS(uint32 instr)
 int32 NCT(uint32 instr)
 {
  DECODE_FIELDS;
+ int64 color_tmp[3][3];
  int i;
 
+ NormColorVectors(sf, lm, color_tmp);
+
  for(i = 0; i < 3; i++)
-  NormColor(sf, lm, i);
+ {
+  MAC_from_tmp(color_tmp[i], sf);
+  MAC_to_IR(lm);
+  MAC_to_RGB_FIFO();
+ }
 
  return(30);
 }
 
+INLINE void NormColorColor_Finish(uint32 sf, int lm)
+{
+ MAC[1] = ((RGB.R << 4) * IR1) >> sf;
+ MAC[2] = ((RGB.G << 4) * IR2) >> sf;
+ MAC[3] = ((RGB.B << 4) * IR3) >> sf;
+
+ MAC_to_IR(lm);
+
+ MAC_to_RGB_FIFO();
+}
+
 INLINE void NormColorColor(uint32 v, uint32 sf, int lm)
 {
  int16 tmp_vector[3];
@@ -1176,13 +1293,7 @@ INLINE void NormColorColor(uint32 v, uint32 sf, int lm)
  tmp_vector[0] = IR1; tmp_vector[1] = IR2; tmp_vector[2] = IR3;
  MultiplyMatrixByVector(&Matrices.Color, tmp_vector, CRVectors.B, sf, lm);
 
- MAC[1] = ((RGB.R << 4) * IR1) >> sf;
- MAC[2] = ((RGB.G << 4) * IR2) >> sf;
- MAC[3] = ((RGB.B << 4) * IR3) >> sf;
-
- MAC_to_IR(lm);
-
- MAC_to_RGB_FIFO();
+ NormColorColor_Finish(sf, lm);
 }
 
 int32 NCCS(uint32 instr)
@@ -1198,9 +1309,16 @@ int32 NCCT(uint32 instr)
 {
  int i;
  DECODE_FIELDS;
+ int64 color_tmp[3][3];
+
+ NormColorVectors(sf, lm, color_tmp);
 
  for(i = 0; i < 3; i++)
-  NormColorColor(i, sf, lm);
+ {
+  MAC_from_tmp(color_tmp[i], sf);
+  MAC_to_IR(lm);
+  NormColorColor_Finish(sf, lm);
+ }
 
  return(39);
 }
@@ -1326,10 +1444,15 @@ int32 NCDT(uint32 instr)
 {
  int i;
  DECODE_FIELDS;
+ int64 color_tmp[3][3];
+
+ NormColorVectors(sf, lm, color_tmp);
 
  for(i = 0; i < 3; i++)
  {
-  NormColorDepthCue(i, sf, lm);
+  MAC_from_tmp(color_tmp[i], sf);
+  MAC_to_IR(lm);
+  DepthCue(TRUE, FALSE, sf, lm);
  }
 
  return(44);
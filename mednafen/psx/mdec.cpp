@@ -18,7 +18,7 @@
 #include "psx.h"
 #include "mdec.h"
 
-#include "../cdrom/SimpleFIFO.h"
+#include "../cputest/cputest.h"
 #include <math.h>
 
 #if defined(__SSE2__)
@@ -26,6 +26,17 @@
 #include <emmintrin.h>
 #endif
 
+#if defined(__SSE2__) && defined(__GNUC__) && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+ #define MDEC_HAVE_AVX2 1
+ #include <immintrin.h>
+#else
+ #define MDEC_HAVE_AVX2 0
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+ #include <arm_neon.h>
+#endif
+
 #if defined(ARCH_POWERPC_ALTIVEC) && defined(HAVE_ALTIVEC_H)
  #include <altivec.h>
 #endif
@@ -33,34 +44,6 @@
 namespace MDFN_IEN_PSX
 {
 
-
-static bool block_ready;
-static int16 block_y[2][2][8][8];
-static int16 block_cb[8][8];	// [y >> 1][x >> 1]
-static int16 block_cr[8][8];	// [y >> 1][x >> 1]
-
-static int32 run_time;
-static uint32 Command;
-
-static uint8 QMatrix[2][64];
-static uint32 QMIndex;
-
-static int16 IDCTMatrix[64] MDFN_ALIGN(16);
-static uint32 IDCTMIndex;
-
-static uint8 QScale;
-
-static int16 Coeff[6][64] MDFN_ALIGN(16);
-static uint32 CoeffIndex;
-static uint32 DecodeWB;
-
-static SimpleFIFO<uint16> InputBuffer(65536);
-static SimpleFIFO<uint16> OutBuffer(384);
-
-static uint32 InCounter;
-static bool BlockEnd;
-static bool DecodeEnd;
-
 static const uint8 ZigZag[64] =
 {
  0x00, 0x08, 0x01, 0x02, 0x09, 0x10, 0x18, 0x11, 
@@ -73,7 +56,32 @@ static const uint8 ZigZag[64] =
  0x2e, 0x27, 0x2f, 0x36, 0x3d, 0x3e, 0x37, 0x3f, 
 };
 
-void MDEC_Power(void)
+PS_MDEC::PS_MDEC() : InputBuffer(65536), OutBuffer(384)
+{
+
+}
+
+PS_MDEC::~PS_MDEC()
+{
+
+}
+
+void PS_MDEC::RebuildIDCTMatrixT(void)
+{
+ for(unsigned x = 0; x < 8; x++)
+ {
+  for(unsigned u = 0; u < 8; u++)
+  {
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+   IDCTMatrixT[(u * 8) + x] = IDCTMatrix[(x * 8) + u];
+#else
+   IDCTMatrixT[((u >> 1) * 16) + (x * 2) + (u & 1)] = IDCTMatrix[(x * 8) + u];
+#endif
+  }
+ }
+}
+
+void PS_MDEC::Power(void)
 {
 #if 0
  for(int i = 0; i < 64; i++)
@@ -94,6 +102,7 @@ void MDEC_Power(void)
  QMIndex = 0;
 
  memset(IDCTMatrix, 0, sizeof(IDCTMatrix));
+ RebuildIDCTMatrixT();
  IDCTMIndex = 0;
 
  QScale = 0;
@@ -109,7 +118,7 @@ void MDEC_Power(void)
  DecodeEnd = 0;
 }
 
-int MDEC_StateAction(StateMem *sm, int load, int data_only)
+int PS_MDEC::StateAction(StateMem *sm, int load, int data_only)
 {
  SFORMAT StateRegs[] =
  {
@@ -154,15 +163,14 @@ int MDEC_StateAction(StateMem *sm, int load, int data_only)
 
  if(load)
  {
-
+  RebuildIDCTMatrixT();
  }
 
  return(ret);
 }
 
 
-static void DecodeImage(void);
-static INLINE void WriteImageData(uint16 V)
+void PS_MDEC::WriteImageData(uint16 V)
 {
  const uint32 qmw = (bool)(DecodeWB < 2);
 
@@ -245,36 +253,107 @@ static INLINE void WriteImageData(uint16 V)
   }
 }
 
+#if defined(__SSE2__)
+static INLINE void Transpose8x8(__m128i *r)
+{
+ __m128i a0, a1, a2, a3, a4, a5, a6, a7;
+ __m128i b0, b1, b2, b3, b4, b5, b6, b7;
+
+ a0 = _mm_unpacklo_epi16(r[0], r[1]);
+ a1 = _mm_unpackhi_epi16(r[0], r[1]);
+ a2 = _mm_unpacklo_epi16(r[2], r[3]);
+ a3 = _mm_unpackhi_epi16(r[2], r[3]);
+ a4 = _mm_unpacklo_epi16(r[4], r[5]);
+ a5 = _mm_unpackhi_epi16(r[4], r[5]);
+ a6 = _mm_unpacklo_epi16(r[6], r[7]);
+ a7 = _mm_unpackhi_epi16(r[6], r[7]);
+
+ b0 = _mm_unpacklo_epi32(a0, a2);
+ b1 = _mm_unpackhi_epi32(a0, a2);
+ b2 = _mm_unpacklo_epi32(a1, a3);
+ b3 = _mm_unpackhi_epi32(a1, a3);
+ b4 = _mm_unpacklo_epi32(a4, a6);
+ b5 = _mm_unpackhi_epi32(a4, a6);
+ b6 = _mm_unpacklo_epi32(a5, a7);
+ b7 = _mm_unpackhi_epi32(a5, a7);
+
+ r[0] = _mm_unpacklo_epi64(b0, b4);
+ r[1] = _mm_unpackhi_epi64(b0, b4);
+ r[2] = _mm_unpacklo_epi64(b1, b5);
+ r[3] = _mm_unpackhi_epi64(b1, b5);
+ r[4] = _mm_unpacklo_epi64(b2, b6);
+ r[5] = _mm_unpackhi_epi64(b2, b6);
+ r[6] = _mm_unpacklo_epi64(b3, b7);
+ r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+#endif
+
+//
+// Coefficients are clamped to [-0x4000, 0x3FFF] and matrix entries to [-0x1000, 0x0FFF], so none of the sums below can overflow 32 bits, nor
+// can their rounded and shifted results overflow 16 bits; the order of summation and saturating packs therefore don't affect the results.
+//
 template<bool phase>
-static void IDCT_1D_Multi(int16 *in_coeff, int16 *out_coeff)
+static void IDCT_1D_Multi(const int16 *matrix_t, int16 *in_coeff, int16 *out_coeff)
 {
 #if defined(__SSE2__)
 {
+ const __m128i rounding = _mm_set1_epi32(0x4000);
+ __m128i rows[8];
+
+ for(unsigned col = 0; col < 8; col++)
+ {
+  const __m128i c = _mm_loadu_si128((__m128i *)&in_coeff[(col * 8)]);
+  __m128i sum_lo = rounding;
+  __m128i sum_hi = rounding;
+
+#define IDCT_MAC_PAIR(p) {														\
+			   const __m128i cp = _mm_shuffle_epi32(c, (p) * 0x55);							\
+			   sum_lo = _mm_add_epi32(sum_lo, _mm_madd_epi16(cp, _mm_loadu_si128((__m128i *)&matrix_t[(p) * 16 + 0])));	\
+			   sum_hi = _mm_add_epi32(sum_hi, _mm_madd_epi16(cp, _mm_loadu_si128((__m128i *)&matrix_t[(p) * 16 + 8])));	\
+			 }
+  IDCT_MAC_PAIR(0)
+  IDCT_MAC_PAIR(1)
+  IDCT_MAC_PAIR(2)
+  IDCT_MAC_PAIR(3)
+#undef IDCT_MAC_PAIR
+
+  rows[col] = _mm_packs_epi32(_mm_srai_epi32(sum_lo, 15), _mm_srai_epi32(sum_hi, 15));
+ }
+
+ if(!phase)
+  Transpose8x8(rows);
+
+ for(unsigned i = 0; i < 8; i++)
+  _mm_storeu_si128((__m128i *)&out_coeff[i * 8], rows[i]);
+}
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
  for(unsigned col = 0; col < 8; col++)
  {
-  __m128i c =  _mm_load_si128((__m128i *)&in_coeff[(col * 8)]);
+  const int16 *c = &in_coeff[col * 8];
+  int32x4_t sum_lo = vdupq_n_s32(0x4000);
+  int32x4_t sum_hi = vdupq_n_s32(0x4000);
+  int16x8_t res;
 
-  for(unsigned x = 0; x < 8; x++)
+  for(unsigned u = 0; u < 8; u++)
   {
-   __m128i sum;
-   __m128i m;
-   int32 tmp[4] MDFN_ALIGN(16);
+   sum_lo = vmlal_n_s16(sum_lo, vld1_s16(&matrix_t[(u * 8) + 0]), c[u]);
+   sum_hi = vmlal_n_s16(sum_hi, vld1_s16(&matrix_t[(u * 8) + 4]), c[u]);
+  }
 
-   m = _mm_load_si128((__m128i *)&IDCTMatrix[(x * 8)]);
-   sum = _mm_madd_epi16(m, c);
-   sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, (3 << 0) | (2 << 2) | (1 << 4) | (0 << 6)));
-   sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, (1 << 0) | (0 << 2)));
+  res = vcombine_s16(vshrn_n_s32(sum_lo, 15), vshrn_n_s32(sum_hi, 15));
 
-   //_mm_store_ss((float *)&tmp[0], (__m128)sum);
-   _mm_store_si128((__m128i*)tmp, sum);
+  if(phase)
+   vst1q_s16(&out_coeff[col * 8], res);
+  else
+  {
+   int16 tmp[8];
 
-   if(phase)
-    out_coeff[(col * 8) + x] = (tmp[0] + 0x4000) >> 15;
-   else
-    out_coeff[(x * 8) + col] = (tmp[0] + 0x4000) >> 15;
+   vst1q_s16(tmp, res);
+
+   for(unsigned x = 0; x < 8; x++)
+    out_coeff[(x * 8) + col] = tmp[x];
   }
  }
-}
 #else
  for(unsigned col = 0; col < 8; col++)
  {
@@ -284,7 +363,7 @@ static void IDCT_1D_Multi(int16 *in_coeff, int16 *out_coeff)
 
    for(unsigned u = 0; u < 8; u++)
    {
-    sum += (in_coeff[(col * 8) + u] * IDCTMatrix[(x * 8) + u]);
+    sum += (in_coeff[(col * 8) + u] * matrix_t[((u >> 1) * 16) + (x * 2) + (u & 1)]);
    }
 
    if(phase)
@@ -296,13 +375,81 @@ static void IDCT_1D_Multi(int16 *in_coeff, int16 *out_coeff)
 #endif
 }
 
-static void IDCT(int16 *in_coeff, int16 *out_coeff) NO_INLINE;
-static void IDCT(int16 *in_coeff, int16 *out_coeff)
+static void IDCT(const int16 *matrix_t, int16 *in_coeff, int16 *out_coeff) NO_INLINE;
+static void IDCT(const int16 *matrix_t, int16 *in_coeff, int16 *out_coeff)
 {
  int16 tmpbuf[64] MDFN_ALIGN(16);
 
- IDCT_1D_Multi<0>(in_coeff, tmpbuf);
- IDCT_1D_Multi<1>(tmpbuf, out_coeff);
+ IDCT_1D_Multi<0>(matrix_t, in_coeff, tmpbuf);
+ IDCT_1D_Multi<1>(matrix_t, tmpbuf, out_coeff);
+}
+
+#if MDEC_HAVE_AVX2
+//
+// Same as the SSE2 version, but computes all 8 outputs of a row with one 256-bit multiply-add per coefficient pair, two rows at a time.
+//
+template<bool phase>
+static void __attribute__((target("avx2"))) IDCT_1D_Multi_AVX2(const int16 *matrix_t, int16 *in_coeff, int16 *out_coeff)
+{
+ const __m256i rounding = _mm256_set1_epi32(0x4000);
+ const __m256i m0 = _mm256_loadu_si256((__m256i *)&matrix_t[0 * 16]);
+ const __m256i m1 = _mm256_loadu_si256((__m256i *)&matrix_t[1 * 16]);
+ const __m256i m2 = _mm256_loadu_si256((__m256i *)&matrix_t[2 * 16]);
+ const __m256i m3 = _mm256_loadu_si256((__m256i *)&matrix_t[3 * 16]);
+ __m128i rows[8];
+
+ for(unsigned col = 0; col < 8; col += 2)
+ {
+  __m256i sum[2];
+
+  for(unsigned i = 0; i < 2; i++)
+  {
+   const __m128i c = _mm_loadu_si128((__m128i *)&in_coeff[(col + i) * 8]);
+   __m256i s = rounding;
+
+   s = _mm256_add_epi32(s, _mm256_madd_epi16(_mm256_broadcastd_epi32(c), m0));
+   s = _mm256_add_epi32(s, _mm256_madd_epi16(_mm256_broadcastd_epi32(_mm_srli_si128(c, 4)), m1));
+   s = _mm256_add_epi32(s, _mm256_madd_epi16(_mm256_broadcastd_epi32(_mm_srli_si128(c, 8)), m2));
+   s = _mm256_add_epi32(s, _mm256_madd_epi16(_mm256_broadcastd_epi32(_mm_srli_si128(c, 12)), m3));
+
+   sum[i] = _mm256_srai_epi32(s, 15);
+  }
+
+  {
+   const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(sum[0], sum[1]), (0 << 0) | (2 << 2) | (1 << 4) | (3 << 6));
+
+   rows[col + 0] = _mm256_castsi256_si128(packed);
+   rows[col + 1] = _mm256_extracti128_si256(packed, 1);
+  }
+ }
+
+ if(!phase)
+  Transpose8x8(rows);
+
+ for(unsigned i = 0; i < 8; i++)
+  _mm_storeu_si128((__m128i *)&out_coeff[i * 8], rows[i]);
+}
+
+static void IDCT_AVX2(const int16 *matrix_t, int16 *in_coeff, int16 *out_coeff) NO_INLINE;
+static void IDCT_AVX2(const int16 *matrix_t, int16 *in_coeff, int16 *out_coeff)
+{
+ int16 tmpbuf[64] MDFN_ALIGN(16);
+
+ IDCT_1D_Multi_AVX2<0>(matrix_t, in_coeff, tmpbuf);
+ IDCT_1D_Multi_AVX2<1>(matrix_t, tmpbuf, out_coeff);
+}
+#endif
+
+static void (*IDCT_Func)(const int16 *matrix_t, int16 *in_coeff, int16 *out_coeff) = IDCT;
+
+void MDEC_Init(void)
+{
+ IDCT_Func = IDCT;
+
+#if MDEC_HAVE_AVX2
+ if(cputest_get_flags() & CPUTEST_FLAG_AVX2)
+  IDCT_Func = IDCT_AVX2;
+#endif
 }
 
 static void YCbCr_to_RGB(const int32 y, const int32 cb, const int32 cr, uint8 &r, uint8 &g, uint8 &b)
@@ -316,7 +463,75 @@ static void YCbCr_to_RGB(const int32 y, const int32 cb, const int32 cr, uint8 &r
  b = std::max<int>(std::min<int>(bt, 255), 0);
 }
 
-static void DecodeImage(void)
+#if defined(__SSE2__)
+// (a * b) >> shift, for a 32-bit product whose shifted result fits in 16 bits.
+static INLINE __m128i MulShift16(const __m128i a, const __m128i b, const int shift)
+{
+ const __m128i lo = _mm_mullo_epi16(a, b);
+ const __m128i hi = _mm_mulhi_epi16(a, b);
+
+ return(_mm_or_si128(_mm_slli_epi16(hi, 16 - shift), _mm_srli_epi16(lo, shift)));
+}
+
+//
+// Converts one 8-pixel run of a macroblock row; same results as YCbCr_to_RGB().  y, cb, and cr are IDCT outputs, so they're within
+// [-0x4000, 0x4000], which keeps all of the products below within 32 bits and lets the constants be split into 16-bit multipliers:
+//  91881 = 65536 + 26345
+//  22525
+//  46812 = 4 * 11703
+//  116130 = 65536 + 2 * 25297
+// The few intermediate sums that can exceed 16 bits are saturated in the same direction as the final clamp to [0, 255].
+//
+static INLINE void YCbCr_to_RGB_SSE2(const __m128i y, const __m128i cb, const __m128i cr, __m128i &r, __m128i &g, __m128i &b)
+{
+ const __m128i y_b = _mm_add_epi16(y, _mm_set1_epi16(128));
+ __m128i rt, gt, bt;
+
+ rt = _mm_adds_epi16(_mm_adds_epi16(y_b, cr), _mm_mulhi_epi16(cr, _mm_set1_epi16(26345)));
+ gt = _mm_subs_epi16(_mm_subs_epi16(y_b, _mm_mulhi_epi16(cb, _mm_set1_epi16(22525))), MulShift16(cr, _mm_set1_epi16(11703), 14));
+ bt = _mm_adds_epi16(_mm_adds_epi16(y_b, cb), MulShift16(cb, _mm_set1_epi16(25297), 15));
+
+ r = _mm_max_epi16(_mm_min_epi16(rt, _mm_set1_epi16(255)), _mm_setzero_si128());
+ g = _mm_max_epi16(_mm_min_epi16(gt, _mm_set1_epi16(255)), _mm_setzero_si128());
+ b = _mm_max_epi16(_mm_min_epi16(bt, _mm_set1_epi16(255)), _mm_setzero_si128());
+}
+#endif
+
+// Converts one 16-pixel row of the current(colour) macroblock, into separate R, G, B arrays.
+INLINE void PS_MDEC::ConvertRow(const int y, uint16 *r, uint16 *g, uint16 *b)
+{
+#if defined(__SSE2__)
+ const __m128i cb = _mm_loadu_si128((__m128i *)&block_cb[y >> 1][0]);
+ const __m128i cr = _mm_loadu_si128((__m128i *)&block_cr[y >> 1][0]);
+
+ for(unsigned half = 0; half < 2; half++)
+ {
+  const __m128i yv = _mm_loadu_si128((__m128i *)&block_y[(y >> 3) & 1][half][y & 7][0]);
+  const __m128i cbv = half ? _mm_unpackhi_epi16(cb, cb) : _mm_unpacklo_epi16(cb, cb);
+  const __m128i crv = half ? _mm_unpackhi_epi16(cr, cr) : _mm_unpacklo_epi16(cr, cr);
+  __m128i rv, gv, bv;
+
+  YCbCr_to_RGB_SSE2(yv, cbv, crv, rv, gv, bv);
+
+  _mm_storeu_si128((__m128i *)&r[half * 8], rv);
+  _mm_storeu_si128((__m128i *)&g[half * 8], gv);
+  _mm_storeu_si128((__m128i *)&b[half * 8], bv);
+ }
+#else
+ for(int x = 0; x < 16; x++)
+ {
+  uint8 rt, gt, bt;
+
+  YCbCr_to_RGB(block_y[(y >> 3) & 1][(x >> 3) & 1][y & 7][x & 7], block_cb[y >> 1][x >> 1], block_cr[y >> 1][x >> 1], rt, gt, bt);
+
+  r[x] = rt;
+  g[x] = gt;
+  b[x] = bt;
+ }
+#endif
+}
+
+void PS_MDEC::DecodeImage(void)
 {
  //puts("DECODE");
 
@@ -324,23 +539,23 @@ static void DecodeImage(void)
  {
   run_time -= 2048;
 
-  IDCT(Coeff[0], &block_cr[0][0]);
-  IDCT(Coeff[1], &block_cb[0][0]);
-  IDCT(Coeff[2], &block_y[0][0][0][0]);
-  IDCT(Coeff[3], &block_y[0][1][0][0]);
-  IDCT(Coeff[4], &block_y[1][0][0][0]);
-  IDCT(Coeff[5], &block_y[1][1][0][0]);
+  IDCT_Func(IDCTMatrixT, Coeff[0], &block_cr[0][0]);
+  IDCT_Func(IDCTMatrixT, Coeff[1], &block_cb[0][0]);
+  IDCT_Func(IDCTMatrixT, Coeff[2], &block_y[0][0][0][0]);
+  IDCT_Func(IDCTMatrixT, Coeff[3], &block_y[0][1][0][0]);
+  IDCT_Func(IDCTMatrixT, Coeff[4], &block_y[1][0][0][0]);
+  IDCT_Func(IDCTMatrixT, Coeff[5], &block_y[1][1][0][0]);
  }
  else
  {
   run_time -= 341;
-  IDCT(Coeff[2], &block_y[0][0][0][0]);
+  IDCT_Func(IDCTMatrixT, Coeff[2], &block_y[0][0][0][0]);
  }
 
  block_ready = true;
 }
 
-static void EncodeImage(void)
+void PS_MDEC::EncodeImage(void)
 {
  //printf("ENCODE, %d\n", (Command & 0x08000000) ? 256 : 384);
 
@@ -403,15 +618,15 @@ static void EncodeImage(void)
 
    for(int y = 0; y < 16; y++)
    {
-    for(int x = 0; x < 16; x++)
-    {
-     uint8 r, g, b;
+    uint16 r[16], g[16], b[16];
 
-     YCbCr_to_RGB(block_y[(y >> 3) & 1][(x >> 3) & 1][y & 7][x & 7], block_cb[y >> 1][x >> 1], block_cr[y >> 1][x >> 1], r, g, b);
+    ConvertRow(y, r, g, b);
 
-     output[y][x][0] = r;
-     output[y][x][1] = g;
-     output[y][x][2] = b;
+    for(int x = 0; x < 16; x++)
+    {
+     output[y][x][0] = r[x];
+     output[y][x][1] = g[x];
+     output[y][x][2] = b[x];
     }
    }
 
@@ -429,14 +644,32 @@ static void EncodeImage(void)
 
    for(int y = 0; y < 16; y++)
    {
-    for(int x = 0; x < 16; x++)
+    uint16 r[16], g[16], b[16];
+    uint16 pixels[16] MDFN_ALIGN(16);
+
+    ConvertRow(y, r, g, b);
+
+#if defined(__SSE2__)
+    for(int x = 0; x < 16; x += 8)
     {
-     uint8 r, g, b;
+     __m128i p;
 
-     YCbCr_to_RGB(block_y[(y >> 3) & 1][(x >> 3) & 1][y & 7][x & 7], block_cb[y >> 1][x >> 1], block_cr[y >> 1][x >> 1], r, g, b);
+     p = _mm_set1_epi16(pixel_or);
+     p = _mm_or_si128(p, _mm_srli_epi16(_mm_loadu_si128((__m128i *)&r[x]), 3));
+     p = _mm_or_si128(p, _mm_slli_epi16(_mm_srli_epi16(_mm_loadu_si128((__m128i *)&g[x]), 3), 5));
+     p = _mm_or_si128(p, _mm_slli_epi16(_mm_srli_epi16(_mm_loadu_si128((__m128i *)&b[x]), 3), 10));
 
+     _mm_store_si128((__m128i *)&pixels[x], p);
+    }
+#else
+    for(int x = 0; x < 16; x++)
+     pixels[x] = pixel_or | ((r[x] >> 3) << 0) | ((g[x] >> 3) << 5) | ((b[x] >> 3) << 10);
+#endif
+
+    for(int x = 0; x < 16; x++)
+    {
      if(OutBuffer.CanWrite())
-      OutBuffer.WriteUnit(pixel_or | ((r >> 3) << 0) | ((g >> 3) << 5) | ((b >> 3) << 10));
+      OutBuffer.WriteUnit(pixels[x]);
     }
    }
   }
@@ -445,7 +678,7 @@ static void EncodeImage(void)
  }
 }
 
-void MDEC_DMAWrite(uint32 V)
+void PS_MDEC::DMAWrite(uint32 V)
 {
  if(InCounter > 0)
  {
@@ -480,6 +713,7 @@ void MDEC_DMAWrite(uint32 V)
 
 	 V >>= 16;
 	}
+	RebuildIDCTMatrixT();
 	break;
 
    default:
@@ -489,7 +723,7 @@ void MDEC_DMAWrite(uint32 V)
  }
 }
 
-uint32 MDEC_DMARead(void)
+uint32 PS_MDEC::DMARead(void)
 {
  uint32 V = 0;
 
@@ -507,17 +741,17 @@ uint32 MDEC_DMARead(void)
 
 // Test case related to this: GameShark Version 4.0 intro movie(coupled with (clever) abuse of DMA channel 0).
 //			also: SimCity 2000 startup.
-bool MDEC_DMACanWrite(void)
+bool PS_MDEC::DMACanWrite(void)
 {
  return(InCounter > 0 && ((Command >> 29) & 0x7) >= 1 && ((Command >> 29) & 0x7) <= 3);
 }
 
-bool MDEC_DMACanRead(void)
+bool PS_MDEC::DMACanRead(void)
 {
  return(OutBuffer.CanRead() >= 2);
 }
 
-void MDEC_Write(const pscpu_timestamp_t timestamp, uint32 A, uint32 V)
+void PS_MDEC::Write(const pscpu_timestamp_t timestamp, uint32 A, uint32 V)
 {
  //PSX_WARNING("[MDEC] Write: 0x%08x 0x%08x, %d", A, V, timestamp);
  if(A & 4)
@@ -583,7 +817,7 @@ void MDEC_Write(const pscpu_timestamp_t timestamp, uint32 A, uint32 V)
  }
 }
 
-uint32 MDEC_Read(const pscpu_timestamp_t timestamp, uint32 A)
+uint32 PS_MDEC::Read(const pscpu_timestamp_t timestamp, uint32 A)
 {
  uint32 ret = 0;
 
@@ -606,8 +840,10 @@ uint32 MDEC_Read(const pscpu_timestamp_t timestamp, uint32 A)
  return(ret);
 }
 
-void MDEC_Run(int32 clocks)
+void PS_MDEC::Run(int32 clocks)
 {
+ PSX_PROF_SCOPE(PSX_PROF_MDEC);
+
  run_time += clocks;
 
  while(run_time > 0)
@@ -1,24 +1,79 @@
 #ifndef __MDFN_PSX_MDEC_H
 #define __MDFN_PSX_MDEC_H
 
+#include "../cdrom/SimpleFIFO.h"
+
 namespace MDFN_IEN_PSX
 {
 
-void MDEC_DMAWrite(uint32 V);
+void MDEC_Init(void);	// Picks the IDCT implementation for the host CPU; shared by all PS_MDEC objects.
+
+class PS_MDEC
+{
+ public:
+
+ PS_MDEC();
+ ~PS_MDEC();
+
+ void Power(void);
+ int StateAction(StateMem *sm, int load, int data_only);
+
+ void Write(const pscpu_timestamp_t timestamp, uint32 A, uint32 V);
+ uint32 Read(const pscpu_timestamp_t timestamp, uint32 A);
+
+ bool DMACanWrite(void);
+ bool DMACanRead(void);
+ void DMAWrite(uint32 V);
+ uint32 DMARead(void);
+
+ void Run(int32 clocks);
+
+ private:
+
+ void RebuildIDCTMatrixT(void);
+ void WriteImageData(uint16 V);
+ void DecodeImage(void);
+ void EncodeImage(void);
+ void ConvertRow(const int y, uint16 *r, uint16 *g, uint16 *b);
+
+ // PS_MDEC is allocated with new, which needn't align these for SIMD, so the IDCT and colour conversion use unaligned loads and stores.
+ bool block_ready;
+ int16 block_y[2][2][8][8];
+ int16 block_cb[8][8];	// [y >> 1][x >> 1]
+ int16 block_cr[8][8];	// [y >> 1][x >> 1]
+
+ int32 run_time;
+ uint32 Command;
+
+ uint8 QMatrix[2][64];
+ uint32 QMIndex;
+
+ int16 IDCTMatrix[64];
+ uint32 IDCTMIndex;
 
-uint32 MDEC_DMARead(void);
+ //
+ // IDCTMatrix rearranged so that a whole row of 8 outputs can be computed with one multiply-add per pair of input coefficients:
+ //  NEON: [u][x]
+ //  Others: [u >> 1][x][u & 1]
+ //
+ // Rebuilt whenever IDCTMatrix changes.
+ //
+ int16 IDCTMatrixT[64];
 
-void MDEC_Write(const pscpu_timestamp_t timestamp, uint32 A, uint32 V);
-uint32 MDEC_Read(const pscpu_timestamp_t timestamp, uint32 A);
+ uint8 QScale;
 
+ int16 Coeff[6][64];
+ uint32 CoeffIndex;
+ uint32 DecodeWB;
 
-void MDEC_Power(void);
+ SimpleFIFO<uint16> InputBuffer;
+ SimpleFIFO<uint16> OutBuffer;
 
-bool MDEC_DMACanWrite(void);
-bool MDEC_DMACanRead(void);
-void MDEC_Run(int32 clocks);
+ uint32 InCounter;
+ bool BlockEnd;
+ bool DecodeEnd;
+};
 
-int MDEC_StateAction(StateMem *sm, int load, int data_only);
 }
 
 #endif
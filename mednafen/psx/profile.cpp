@@ -0,0 +1,181 @@
+/* Mednafen - Multi-system Emulator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "psx.h"
+
+#if PSX_PROFILE_ENABLE
+
+namespace MDFN_IEN_PSX
+{
+
+PSX_ProfileState PSX_Prof;
+
+static PSX_ProfileFrame LastFrame;
+static PSX_ProfileFrame IntervalSum;
+static unsigned IntervalFrames;
+
+// For estimating the tick rate.
+static uint64 RateBaseTicks;
+static uint32 RateBaseTime;
+
+static const char *SectionNames[PSX_PROF__COUNT] =
+{
+ "other",
+ "cpu",
+ "gpu_raster",
+ "gpu_scanout",
+ "spu",
+ "mdec",
+ "cdc",
+ "dma",
+ "timer",
+ "fio",
+ "mmio",
+};
+
+const char *PSX_Profile_SectionName(unsigned section)
+{
+ if(section >= PSX_PROF__COUNT)
+  return("?");
+
+ return(SectionNames[section]);
+}
+
+void PSX_Profile_Reset(void)
+{
+ memset(&PSX_Prof.frame, 0, sizeof(PSX_Prof.frame));
+ memset(&LastFrame, 0, sizeof(LastFrame));
+ memset(&IntervalSum, 0, sizeof(IntervalSum));
+ IntervalFrames = 0;
+
+ PSX_Prof.cur = PSX_PROF_OTHER;
+ PSX_Prof.start = PSX_Profile_Ticks();
+
+ RateBaseTicks = PSX_Prof.start;
+ RateBaseTime = MDFND_GetTime();
+}
+
+static void Dump(void)
+{
+ const double tick_rate = IntervalSum.tick_rate;
+ const double frame_ms = (double)IntervalSum.total_ticks / IntervalFrames * 1000 / tick_rate;
+ unsigned top[8];
+ unsigned top_count = 0;
+
+ printf("[PSX] Profile: %u frames, %.3f ms/frame\n", IntervalFrames, frame_ms);
+
+ for(unsigned i = 0; i < PSX_PROF__COUNT; i++)
+ {
+  printf(" %-12s %8.3f ms/frame %5.1f%% %10.1f entries/frame\n", SectionNames[i], (double)IntervalSum.ticks[i] / IntervalFrames * 1000 / tick_rate,
+	IntervalSum.total_ticks ? (double)IntervalSum.ticks[i] * 100 / IntervalSum.total_ticks : 0.0, (double)IntervalSum.entries[i] / IntervalFrames);
+ }
+
+ // Busiest I/O ports, by reads + writes.
+ for(unsigned i = 0; i < PSX_PROF_MMIO_SIZE; i++)
+ {
+  const uint64 count = (uint64)IntervalSum.mmio_reads[i] + IntervalSum.mmio_writes[i];
+  unsigned pos;
+
+  if(!count)
+   continue;
+
+  for(pos = top_count; pos > 0; pos--)
+  {
+   const unsigned t = top[pos - 1];
+
+   if(count <= (uint64)IntervalSum.mmio_reads[t] + IntervalSum.mmio_writes[t])
+    break;
+
+   if(pos < 8)
+    top[pos] = t;
+  }
+
+  if(pos < 8)
+  {
+   top[pos] = i;
+
+   if(top_count < 8)
+    top_count++;
+  }
+ }
+
+ for(unsigned i = 0; i < top_count; i++)
+ {
+  printf(" I/O 0x%08x: %10.1f reads/frame %10.1f writes/frame\n", PSX_PROF_MMIO_BASE + top[i], (double)IntervalSum.mmio_reads[top[i]] / IntervalFrames,
+	(double)IntervalSum.mmio_writes[top[i]] / IntervalFrames);
+ }
+}
+
+void PSX_Profile_EndFrame(unsigned dump_interval)
+{
+ PSX_ProfileFrame *frame = &PSX_Prof.frame;
+ const uint64 now = PSX_Profile_Ticks();
+ const uint32 now_time = MDFND_GetTime();
+
+ frame->ticks[PSX_Prof.cur] += now - PSX_Prof.start;
+ PSX_Prof.start = now;
+
+ frame->total_ticks = 0;
+ for(unsigned i = 0; i < PSX_PROF__COUNT; i++)
+  frame->total_ticks += frame->ticks[i];
+
+ #if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+ if((now_time - RateBaseTime) >= 1000)
+  frame->tick_rate = (double)(now - RateBaseTicks) * 1000 / (now_time - RateBaseTime);
+ else if(LastFrame.tick_rate > 0)
+  frame->tick_rate = LastFrame.tick_rate;
+ else
+  frame->tick_rate = 1000000000.0;	// Guess until we have a measurement.
+ #else
+ frame->tick_rate = 1000000.0;
+ #endif
+
+ memcpy(&LastFrame, frame, sizeof(LastFrame));
+
+ for(unsigned i = 0; i < PSX_PROF__COUNT; i++)
+ {
+  IntervalSum.ticks[i] += frame->ticks[i];
+  IntervalSum.entries[i] += frame->entries[i];
+ }
+ IntervalSum.total_ticks += frame->total_ticks;
+ IntervalSum.tick_rate = frame->tick_rate;
+
+ for(unsigned i = 0; i < PSX_PROF_MMIO_SIZE; i++)
+ {
+  IntervalSum.mmio_reads[i] += frame->mmio_reads[i];
+  IntervalSum.mmio_writes[i] += frame->mmio_writes[i];
+ }
+ IntervalFrames++;
+
+ memset(frame, 0, sizeof(PSX_ProfileFrame));
+
+ if(dump_interval && IntervalFrames >= dump_interval)
+ {
+  Dump();
+  memset(&IntervalSum, 0, sizeof(IntervalSum));
+  IntervalFrames = 0;
+ }
+}
+
+const PSX_ProfileFrame *PSX_Profile_GetLastFrame(void)
+{
+ return(&LastFrame);
+}
+
+}
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef __MDFN_PSX_PROFILE_H
+#define __MDFN_PSX_PROFILE_H
+
+//
+// Per-subsystem profiling counters(enabled by defining PSX_PROFILE_ENABLE in psx.h).
+//
+// Host time is measured with the TSC(or a microsecond clock where there is no TSC) and charged to exactly one section at a time: entering
+// a PSX_PROF_SCOPE() stops the clock on the enclosing section and starts it on the new one, so nested sections(e.g. GPU rasterization
+// triggered by a DMA transfer, or SPU sample generation run from the CDC update) are reported as exclusive times that sum to the frame total.
+// Time spent in the CPU interpreter itself is whatever is left over in PSX_PROF_CPU.
+//
+// Only the emulation thread is measured; with "psx.gpu.threaded" enabled, PSX_PROF_GPU_RASTER covers the emulation-thread side of each
+// drawing command(timing, queueing), and waits on the render thread are charged to whichever section had to wait.
+//
+// Counters are gathered into a PSX_ProfileFrame at the end of every emulated frame; see PSX_Profile_GetLastFrame(), and the
+// "psx.dbg_profile_dump" setting for a periodic summary on stdout.
+//
+
+#if PSX_PROFILE_ENABLE
+ #if !(defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)))
+  #include <sys/time.h>
+ #endif
+#endif
+
+namespace MDFN_IEN_PSX
+{
+ enum
+ {
+  PSX_PROF_OTHER = 0,	// Frame setup/teardown outside of the CPU run loop.
+  PSX_PROF_CPU,		// CPU interpreter, including GTE and main RAM/BIOS accesses.
+  PSX_PROF_GPU_RASTER,	// GPU command FIFO processing and drawing.
+  PSX_PROF_GPU_SCANOUT,	// GPU timing and line output.
+  PSX_PROF_SPU,
+  PSX_PROF_MDEC,
+  PSX_PROF_CDC,
+  PSX_PROF_DMA,
+  PSX_PROF_TIMER,
+  PSX_PROF_FIO,		// Controllers and memory cards.
+  PSX_PROF_MMIO,	// Memory-mapped I/O dispatch not otherwise accounted for(SIO, IRQ controller, system control registers, etc.).
+  PSX_PROF__COUNT
+ };
+
+ // Memory-mapped I/O ports, 0x1F801000 through 0x1F802FFF
+ enum { PSX_PROF_MMIO_BASE = 0x1F801000, PSX_PROF_MMIO_SIZE = 0x2000 };
+
+ struct PSX_ProfileFrame
+ {
+  uint64 ticks[PSX_PROF__COUNT];	// Host TSC ticks(or microseconds; see "tick_rate"), exclusive.
+  uint32 entries[PSX_PROF__COUNT];	// Number of times each section was entered.
+  uint64 total_ticks;
+  double tick_rate;			// Ticks per second, estimated.
+
+  uint32 mmio_reads[PSX_PROF_MMIO_SIZE];
+  uint32 mmio_writes[PSX_PROF_MMIO_SIZE];
+ };
+
+#if PSX_PROFILE_ENABLE
+ struct PSX_ProfileState
+ {
+  unsigned cur;
+  uint64 start;
+  PSX_ProfileFrame frame;
+ };
+
+ extern PSX_ProfileState PSX_Prof;
+
+ static INLINE uint64 PSX_Profile_Ticks(void)
+ {
+  #if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+  uint32 lo, hi;
+
+  asm volatile("rdtsc\n\t" : "=a"(lo), "=d"(hi));
+
+  return(((uint64)hi << 32) | lo);
+  #else
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+
+  return((uint64)tv.tv_sec * 1000000 + tv.tv_usec);
+  #endif
+ }
+
+ class PSX_ProfileScope
+ {
+  public:
+
+  INLINE PSX_ProfileScope(unsigned section)
+  {
+   const uint64 now = PSX_Profile_Ticks();
+
+   PSX_Prof.frame.ticks[PSX_Prof.cur] += now - PSX_Prof.start;
+   PSX_Prof.frame.entries[section]++;
+   prev = PSX_Prof.cur;
+   PSX_Prof.cur = section;
+   PSX_Prof.start = now;
+  }
+
+  INLINE ~PSX_ProfileScope()
+  {
+   const uint64 now = PSX_Profile_Ticks();
+
+   PSX_Prof.frame.ticks[PSX_Prof.cur] += now - PSX_Prof.start;
+   PSX_Prof.cur = prev;
+   PSX_Prof.start = now;
+  }
+
+  private:
+  unsigned prev;
+ };
+
+ static INLINE void PSX_Profile_MMIO(uint32 A, bool write)
+ {
+  const uint32 index = (A - PSX_PROF_MMIO_BASE) & (PSX_PROF_MMIO_SIZE - 1);
+
+  if(write)
+   PSX_Prof.frame.mmio_writes[index]++;
+  else
+   PSX_Prof.frame.mmio_reads[index]++;
+ }
+
+ // Called at the end of each emulated frame; "dump_interval" is in frames, 0 to disable the periodic summary.
+ void PSX_Profile_EndFrame(unsigned dump_interval);
+
+ // Counters for the most recently completed frame.
+ const PSX_ProfileFrame *PSX_Profile_GetLastFrame(void);
+
+ void PSX_Profile_Reset(void);
+
+ const char *PSX_Profile_SectionName(unsigned section);
+
+ #define PSX_PROF_SCOPE(section) PSX_ProfileScope prof_scope_(section)
+ #define PSX_PROF_MMIO(A, write) PSX_Profile_MMIO(A, write)
+#else
+ #define PSX_PROF_SCOPE(section)
+ #define PSX_PROF_MMIO(A, write)
+#endif
+}
+
+#endif
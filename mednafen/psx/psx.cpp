@@ -133,11 +133,6 @@ enum
  REGION_EU = 2,
 };
 
-#if 0
-static uint32 PortReadCounter[0x4000] = { 0 };	// Debugging(performance)
-static uint32 ReadCounter = 0;
-static uint32 WriteCounter = 0;
-#endif
 
 static PSF1Loader *psf_loader = NULL;
 static std::vector<CDIF*> *cdifs = NULL;
@@ -148,10 +143,18 @@ static int CD_SelectedDisc;     // -1 for no disc
 static uint64 Memcard_PrevDC[8];
 static int64 Memcard_SaveDelay[8];
 
+// Settings read every frame.
+static MDFN_SettingHandle SH_MouseSensitivity;
+static MDFN_SettingHandle SH_ResampQuality;
+#if PSX_PROFILE_ENABLE
+static MDFN_SettingHandle SH_ProfileDump;
+#endif
+
 PS_CPU *CPU = NULL;
 PS_SPU *SPU = NULL;
 PS_GPU *GPU = NULL;
 PS_CDC *CDC = NULL;
+PS_MDEC *MDEC = NULL;
 FrontIO *FIO = NULL;
 
 static MultiAccessSizeMem<512 * 1024, uint32, false> *BIOSROM = NULL;
@@ -358,23 +361,38 @@ bool MDFN_FASTCALL PSX_EventHandler(const pscpu_timestamp_t timestamp)
    default: abort();
 
    case PSX_EVENT_GPU:
-	nt = GPU->Update(e->event_time);
+	{
+	 PSX_PROF_SCOPE(PSX_PROF_GPU_SCANOUT);
+	 nt = GPU->Update(e->event_time);
+	}
 	break;
 
    case PSX_EVENT_CDC:
-	nt = CDC->Update(e->event_time);
+	{
+	 PSX_PROF_SCOPE(PSX_PROF_CDC);
+	 nt = CDC->Update(e->event_time);
+	}
 	break;
 
    case PSX_EVENT_TIMER:
-	nt = TIMER_Update(e->event_time);
+	{
+	 PSX_PROF_SCOPE(PSX_PROF_TIMER);
+	 nt = TIMER_Update(e->event_time);
+	}
 	break;
 
    case PSX_EVENT_DMA:
-	nt = DMA_Update(e->event_time);
+	{
+	 PSX_PROF_SCOPE(PSX_PROF_DMA);
+	 nt = DMA_Update(e->event_time);
+	}
 	break;
 
    case PSX_EVENT_FIO:
-	nt = FIO->Update(e->event_time);
+	{
+	 PSX_PROF_SCOPE(PSX_PROF_FIO);
+	 nt = FIO->Update(e->event_time);
+	}
 	break;
   }
 #if PSX_EVENT_SYSTEM_CHECKS
@@ -497,15 +515,8 @@ template<typename T, bool IsWrite, bool Access24> static INLINE void MemRW(pscpu
 
  if(A >= 0x1F801000 && A <= 0x1F802FFF)
  {
-#if 0
-  if(!IsWrite)
-  {
-   ReadCounter++;
-   PortReadCounter[A & 0x3FFF]++;
-  }
-  else
-   WriteCounter++;
-#endif
+  PSX_PROF_MMIO(A, IsWrite);
+  PSX_PROF_SCOPE(PSX_PROF_MMIO);
 
   //if(IsWrite)
   // printf("HW Write%d: %08x %08x\n", (unsigned int)(sizeof(T)*8), (unsigned int)A, (unsigned int)V);
@@ -523,6 +534,7 @@ template<typename T, bool IsWrite, bool Access24> static INLINE void MemRW(pscpu
      //if(timestamp >= events[PSX_EVENT__SYNFIRST].next->event_time)
      // PSX_EventHandler(timestamp);
 
+     PSX_PROF_SCOPE(PSX_PROF_SPU);
      SPU->Write(timestamp, A | 0, V);
      SPU->Write(timestamp, A | 2, V >> 16);
     }
@@ -533,6 +545,7 @@ template<typename T, bool IsWrite, bool Access24> static INLINE void MemRW(pscpu
      if(timestamp >= events[PSX_EVENT__SYNFIRST].next->event_time)
       PSX_EventHandler(timestamp);
 
+     PSX_PROF_SCOPE(PSX_PROF_SPU);
      V = SPU->Read(timestamp, A) | (SPU->Read(timestamp, A | 2) << 16);
     }
    }
@@ -545,6 +558,7 @@ template<typename T, bool IsWrite, bool Access24> static INLINE void MemRW(pscpu
      //if(timestamp >= events[PSX_EVENT__SYNFIRST].next->event_time)
      // PSX_EventHandler(timestamp);
 
+     PSX_PROF_SCOPE(PSX_PROF_SPU);
      SPU->Write(timestamp, A & ~1, V);
     }
     else
@@ -554,6 +568,7 @@ template<typename T, bool IsWrite, bool Access24> static INLINE void MemRW(pscpu
      if(timestamp >= events[PSX_EVENT__SYNFIRST].next->event_time)
       PSX_EventHandler(timestamp);
 
+     PSX_PROF_SCOPE(PSX_PROF_SPU);
      V = SPU->Read(timestamp, A & ~1);
     }
    }
@@ -569,6 +584,8 @@ template<typename T, bool IsWrite, bool Access24> static INLINE void MemRW(pscpu
     timestamp += 6 * sizeof(T); //24;
    }
 
+   PSX_PROF_SCOPE(PSX_PROF_CDC);
+
    if(IsWrite)
     CDC->Write(timestamp, A & 0x3, V);
    else
@@ -595,10 +612,12 @@ template<typename T, bool IsWrite, bool Access24> static INLINE void MemRW(pscpu
    if(!IsWrite)
     timestamp++;
 
+   PSX_PROF_SCOPE(PSX_PROF_MDEC);
+
    if(IsWrite)
-    MDEC_Write(timestamp, A, V);
+    MDEC->Write(timestamp, A, V);
    else
-    V = MDEC_Read(timestamp, A);
+    V = MDEC->Read(timestamp, A);
 
    return;
   }
@@ -631,6 +650,8 @@ template<typename T, bool IsWrite, bool Access24> static INLINE void MemRW(pscpu
    if(!IsWrite)
     timestamp++;
 
+   PSX_PROF_SCOPE(PSX_PROF_FIO);
+
    if(IsWrite)
     FIO->Write(timestamp, A, V);
    else
@@ -694,6 +715,8 @@ template<typename T, bool IsWrite, bool Access24> static INLINE void MemRW(pscpu
    if(!IsWrite)
     timestamp++;
 
+   PSX_PROF_SCOPE(PSX_PROF_DMA);
+
    if(IsWrite)
     DMA_Write(timestamp, A, V);
    else
@@ -707,6 +730,8 @@ template<typename T, bool IsWrite, bool Access24> static INLINE void MemRW(pscpu
    if(!IsWrite)
     timestamp++;
 
+   PSX_PROF_SCOPE(PSX_PROF_TIMER);
+
    if(IsWrite)
     TIMER_Write(timestamp, A, V);
    else
@@ -1003,7 +1028,7 @@ static void PSX_Power(void)
  FIO->Power();
  SIO_Power();
 
- MDEC_Power();
+ MDEC->Power();
  CDC->Power();
  GPU->Power();
  //SPU->Power();	// Called from CDC->Power()
@@ -1033,7 +1058,7 @@ static void Emulate(EmulateSpecStruct *espec)
   espec->skip = false;	//TODO: Save here, and restore at end of Emulate() ?
  }
 
- MDFNGameInfo->mouse_sensitivity = MDFN_GetSettingF("psx.input.mouse_sensitivity");
+ MDFNGameInfo->mouse_sensitivity = SH_MouseSensitivity.F();
 
  MDFNMP_ApplyPeriodicCheats();
 
@@ -1043,10 +1068,13 @@ static void Emulate(EmulateSpecStruct *espec)
 
  FIO->UpdateInput();
  GPU->StartFrame(psf_loader ? NULL : espec);
- SPU->StartFrame(espec->SoundRate, MDFN_GetSettingUI("psx.spu.resamp_quality"));
+ SPU->StartFrame(espec->SoundRate, SH_ResampQuality.UI());
 
  Running = -1;
- timestamp = CPU->Run(timestamp, psf_loader != NULL);
+ {
+  PSX_PROF_SCOPE(PSX_PROF_CPU);
+  timestamp = CPU->Run(timestamp, psf_loader != NULL);
+ }
 
  assert(timestamp);
 
@@ -1056,7 +1084,10 @@ static void Emulate(EmulateSpecStruct *espec)
 
  //printf("scanline=%u, st=%u\n", GPU->GetScanlineNum(), timestamp);
 
- espec->SoundBufSize = SPU->EndFrame(espec->SoundBuf);
+ {
+  PSX_PROF_SCOPE(PSX_PROF_SPU);
+  espec->SoundBufSize = SPU->EndFrame(espec->SoundBuf);
+ }
 
  CDC->ResetTS();
  TIMER_ResetTS();
@@ -1112,18 +1143,8 @@ static void Emulate(EmulateSpecStruct *espec)
   }
  }
 
- #if 0
- printf("read=%6d, write=%6d\n", ReadCounter, WriteCounter);
- ReadCounter = 0;
- WriteCounter = 0;
- printf("HW Port reads for this frame:\n");
- for(unsigned i = 0; i < 0x4000; i++)
- {
-  if(PortReadCounter[i] > 100)
-   printf("0x%08x: %d\n", 0x1f800000 + i, PortReadCounter[i]);
- }
- memset(PortReadCounter, 0, sizeof(PortReadCounter));
- printf("\n");
+ #if PSX_PROFILE_ENABLE
+ PSX_Profile_EndFrame(SH_ProfileDump.UI());
  #endif
 }
 
@@ -1417,6 +1438,12 @@ static void InitCommon(std::vector<CDIF *> *CDInterfaces, const bool EmulateMemc
  psx_dbg_level = MDFN_GetSettingUI("psx.dbg_level");
 #endif
 
+ SH_MouseSensitivity.Bind("psx.input.mouse_sensitivity");
+ SH_ResampQuality.Bind("psx.spu.resamp_quality");
+#if PSX_PROFILE_ENABLE
+ SH_ProfileDump.Bind("psx.dbg_profile_dump");
+#endif
+
  for(unsigned i = 0; i < 8; i++)
  {
   char buf[64];
@@ -1450,8 +1477,9 @@ static void InitCommon(std::vector<CDIF *> *CDInterfaces, const bool EmulateMemc
 
  CPU = new PS_CPU();
  SPU = new PS_SPU();
- GPU = new PS_GPU(region == REGION_EU, sls, sle);
+ GPU = new PS_GPU(region == REGION_EU, sls, sle, MDFN_GetSettingB("psx.gpu.threaded"));
  CDC = new PS_CDC();
+ MDEC = new PS_MDEC();
  FIO = new FrontIO(emulate_memcard, emulate_multitap);
  FIO->SetAMCT(MDFN_GetSettingB("psx.input.analog_mode_ct"));
  for(unsigned i = 0; i < 8; i++)
@@ -1462,6 +1490,7 @@ static void InitCommon(std::vector<CDIF *> *CDInterfaces, const bool EmulateMemc
  }
 
  DMA_Init();
+ MDEC_Init();
 
  if(region == REGION_EU)
  {
@@ -1575,6 +1604,10 @@ static void InitCommon(std::vector<CDIF *> *CDInterfaces, const bool EmulateMemc
  DBG_Init();
  #endif
 
+ #if PSX_PROFILE_ENABLE
+ PSX_Profile_Reset();
+ #endif
+
  PSX_Power();
 }
 
@@ -1838,6 +1871,12 @@ static void Cleanup(void)
 {
  TextMem.resize(0);
 
+ SH_MouseSensitivity.Unbind();
+ SH_ResampQuality.Unbind();
+#if PSX_PROFILE_ENABLE
+ SH_ProfileDump.Unbind();
+#endif
+
  if(psf_loader)
  {
   delete psf_loader;
@@ -1850,6 +1889,12 @@ static void Cleanup(void)
   CDC = NULL;
  }
 
+ if(MDEC)
+ {
+  delete MDEC;
+  MDEC = NULL;
+ }
+
  if(SPU)
  {
   delete SPU;
@@ -1954,7 +1999,7 @@ static int StateAction(StateMem *sm, int load, int data_only)
  ret &= DMA_StateAction(sm, load, data_only);
  ret &= TIMER_StateAction(sm, load, data_only);
  ret &= CDC->StateAction(sm, load, data_only);
- ret &= MDEC_StateAction(sm, load, data_only);
+ ret &= MDEC->StateAction(sm, load, data_only);
  ret &= SPU->StateAction(sm, load, data_only);
  //ret &= FIO->StateAction(sm, load, data_only);
  //ret &= GPU->StateAction(sm, load, data_only);
@@ -2293,6 +2338,8 @@ static MDFNSetting PSXSettings[] =
 	gettext_noop("0 is lowest quality and CPU usage, 10 is highest quality and CPU usage.  The resampler that this setting refers to is used for converting from 44.1KHz to the sampling rate of the host audio device Mednafen is using.  Changing Mednafen's output rate, via the \"sound.rate\" setting, to \"44100\" will bypass the resampler, which will decrease CPU usage by Mednafen, and can increase or decrease audio quality, depending on various operating system and hardware factors."), MDFNST_UINT, "5", "0", "10" },
 
 
+ { "psx.gpu.threaded", MDFNSF_NOFLAGS, gettext_noop("Rasterize GPU drawing commands on a separate thread."), gettext_noop("Polygons, sprites, lines, and fills are drawn into GPU RAM by a dedicated render thread, while the emulation thread continues on.  Output is identical to non-threaded rendering; GPU RAM reads, framebuffer copies, and scanout wait for the render thread to catch up.  Takes effect when a game is loaded."), MDFNST_BOOL, "0" },
+
  { "psx.slstart", MDFNSF_NOFLAGS, gettext_noop("First displayed scanline in NTSC mode."), NULL, MDFNST_INT, "0", "0", "239" },
  { "psx.slend", MDFNSF_NOFLAGS, gettext_noop("Last displayed scanline in NTSC mode."), NULL, MDFNST_INT, "239", "0", "239" },
 
@@ -2303,6 +2350,10 @@ static MDFNSetting PSXSettings[] =
  { "psx.dbg_level", MDFNSF_NOFLAGS, gettext_noop("Debug printf verbosity level."), NULL, MDFNST_UINT, "0", "0", "4" },
 #endif
 
+#if PSX_PROFILE_ENABLE
+ { "psx.dbg_profile_dump", MDFNSF_NOFLAGS, gettext_noop("Print a per-subsystem profile summary every N frames."), gettext_noop("0 disables the summary.  Counters for the last frame are always available through PSX_Profile_GetLastFrame()."), MDFNST_UINT, "0", "0", "100000" },
+#endif
+
  { NULL },
 };
 
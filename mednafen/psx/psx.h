@@ -15,6 +15,11 @@
 #define PSX_DBGPRINT_ENABLE    1
 #define PSX_EVENT_SYSTEM_CHECKS 1
 
+//
+// Uncomment to build in the per-subsystem profiling counters(see profile.h); costs two TSC reads per instrumented call.
+//
+//#define PSX_PROFILE_ENABLE	1
+
 //
 // It's highly unlikely the user will want these if they're intentionally compiling without the debugger.
 #ifndef WANT_DEBUGGER
@@ -101,16 +106,19 @@ namespace MDFN_IEN_PSX
 #include "dma.h"
 //#include "sio.h"
 #include "debug.h"
+#include "profile.h"
 
 namespace MDFN_IEN_PSX
 {
  class PS_CDC;
  class PS_SPU;
+ class PS_MDEC;
 
  extern PS_CPU *CPU;
  extern PS_GPU *GPU;
  extern PS_CDC *CDC;
  extern PS_SPU *SPU;
+ extern PS_MDEC *MDEC;
  extern MultiAccessSizeMem<2048 * 1024, uint32, false> MainRAM;
 };
 
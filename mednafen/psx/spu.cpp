@@ -76,6 +76,10 @@
 
 #include "../clamp.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace MDFN_IEN_PSX
 {
 
@@ -528,9 +532,157 @@ INLINE uint16 PS_SPU::ReadSPURAM(uint32 addr)
 
 #include "spu_reverb.inc"
 
+//
+// Voice mixing is done in three passes per output sample:
+//
+//  1. Per-voice, in voice order: sample decoding(which can trigger IRQs), and gathering of the interpolation, envelope, and volume inputs
+//     into a structure-of-arrays SPU_MixBuffer.  Voices 1 and 3 also write their output to SPU RAM here, so that the other voices' decoding
+//     sees SPU RAM in the same state as when each voice was processed start-to-finish.
+//
+//  2. MixVoices(): FIR interpolation, enveloping, and L/R volume for all 24 voices at once.
+//
+//  3. Per-voice, in voice order: sweep, envelope, and pitch(including phase modulation, which needs the previous voice's output) updates,
+//     and key on/off.
+//
+// All of the math in MixVoices() is done as int16 * int16 -> int32, which is exact since no row of FIR_Table has an absolute sum above 32643,
+// so the interpolated sample always fits in an int16.  The one exception is a noise-mode sample of -32768 enveloped with an(out-of-range,
+// game-written) envelope level of -32768, which the SIMD version detects and punts to the plain C version for.
+//
+struct SPU_MixBuffer
+{
+ int16 s[4][24];	// Interpolation input samples
+ int16 c[4][24];	// FIR_Table coefficients
+ int16 noise_mask[24];	// -1 if the voice is in noise mode, 0 otherwise.
+ int16 env[24];
+ int16 vol[2][24];
+ int16 reverb_mask[24];	// -1 if the voice feeds reverb, 0 otherwise.
+
+ int32 pvs[24];		// Output; after enveloping, but before L/R volume.
+};
+
+static INLINE int32 MixVoiceSample(const SPU_MixBuffer *mb, const unsigned v, const int16 noise)
+{
+ int32 pvs;
+
+ if(mb->noise_mask[v])
+  pvs = noise;
+ else
+  pvs = ((mb->s[0][v] * mb->c[0][v]) + (mb->s[1][v] * mb->c[1][v]) + (mb->s[2][v] * mb->c[2][v]) + (mb->s[3][v] * mb->c[3][v])) >> 15;
+
+ return((pvs * mb->env[v]) >> 15);
+}
+
+static void MixVoices_C(SPU_MixBuffer *mb, const int16 noise, int32 *accum, int32 *accum_fv)
+{
+ for(unsigned v = 0; v < 24; v++)
+  mb->pvs[v] = MixVoiceSample(mb, v, noise);
+
+ for(unsigned v = 0; v < 24; v++)
+ {
+  for(unsigned lr = 0; lr < 2; lr++)
+  {
+   const int32 s = (mb->pvs[v] * mb->vol[lr][v]) >> 15;
+
+   accum[lr] += s;
+   accum_fv[lr] += s & (int32)mb->reverb_mask[v];
+  }
+ }
+}
+
+#if defined(__SSE2__)
+static INLINE int32 HSum32(__m128i v)
+{
+ v = _mm_add_epi32(v, _mm_shuffle_epi32(v, (2 << 0) | (3 << 2) | (0 << 4) | (1 << 6)));
+ v = _mm_add_epi32(v, _mm_shuffle_epi32(v, (1 << 0) | (0 << 2) | (3 << 4) | (2 << 6)));
+
+ return(_mm_cvtsi128_si32(v));
+}
+
+// Returns false, without touching accum or accum_fv, in the rare case where it can't produce exact results.
+static bool MixVoices_SSE2(SPU_MixBuffer *mb, const int16 noise, int32 *accum, int32 *accum_fv)
+{
+ const __m128i noise_v = _mm_set1_epi16(noise);
+ const __m128i overflow_v = _mm_set1_epi32(32768);
+ __m128i overflow = _mm_setzero_si128();
+ __m128i sum[2] = { _mm_setzero_si128(), _mm_setzero_si128() };
+ __m128i sum_fv[2] = { _mm_setzero_si128(), _mm_setzero_si128() };
+
+ for(unsigned v = 0; v < 24; v += 8)
+ {
+  const __m128i s0 = _mm_load_si128((const __m128i *)&mb->s[0][v]);
+  const __m128i s1 = _mm_load_si128((const __m128i *)&mb->s[1][v]);
+  const __m128i s2 = _mm_load_si128((const __m128i *)&mb->s[2][v]);
+  const __m128i s3 = _mm_load_si128((const __m128i *)&mb->s[3][v]);
+  const __m128i c0 = _mm_load_si128((const __m128i *)&mb->c[0][v]);
+  const __m128i c1 = _mm_load_si128((const __m128i *)&mb->c[1][v]);
+  const __m128i c2 = _mm_load_si128((const __m128i *)&mb->c[2][v]);
+  const __m128i c3 = _mm_load_si128((const __m128i *)&mb->c[3][v]);
+  const __m128i nm = _mm_load_si128((const __m128i *)&mb->noise_mask[v]);
+  const __m128i env = _mm_load_si128((const __m128i *)&mb->env[v]);
+  const __m128i rm = _mm_load_si128((const __m128i *)&mb->reverb_mask[v]);
+  const __m128i rm_lo = _mm_unpacklo_epi16(rm, rm);
+  const __m128i rm_hi = _mm_unpackhi_epi16(rm, rm);
+  __m128i fir_lo, fir_hi, pvs, prod_lo, prod_hi, pvs_lo, pvs_hi;
+
+  // Interpolation
+  fir_lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(s0, s1), _mm_unpacklo_epi16(c0, c1)), _mm_madd_epi16(_mm_unpacklo_epi16(s2, s3), _mm_unpacklo_epi16(c2, c3)));
+  fir_hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(s0, s1), _mm_unpackhi_epi16(c0, c1)), _mm_madd_epi16(_mm_unpackhi_epi16(s2, s3), _mm_unpackhi_epi16(c2, c3)));
+  pvs = _mm_packs_epi32(_mm_srai_epi32(fir_lo, 15), _mm_srai_epi32(fir_hi, 15));
+  pvs = _mm_or_si128(_mm_and_si128(nm, noise_v), _mm_andnot_si128(nm, pvs));
+
+  // Enveloping
+  prod_lo = _mm_mullo_epi16(pvs, env);
+  prod_hi = _mm_mulhi_epi16(pvs, env);
+  pvs_lo = _mm_srai_epi32(_mm_unpacklo_epi16(prod_lo, prod_hi), 15);
+  pvs_hi = _mm_srai_epi32(_mm_unpackhi_epi16(prod_lo, prod_hi), 15);
+  overflow = _mm_or_si128(overflow, _mm_or_si128(_mm_cmpeq_epi32(pvs_lo, overflow_v), _mm_cmpeq_epi32(pvs_hi, overflow_v)));
+
+  _mm_store_si128((__m128i *)&mb->pvs[v + 0], pvs_lo);
+  _mm_store_si128((__m128i *)&mb->pvs[v + 4], pvs_hi);
+  pvs = _mm_packs_epi32(pvs_lo, pvs_hi);
+
+  // L/R volume
+  for(unsigned lr = 0; lr < 2; lr++)
+  {
+   const __m128i vol = _mm_load_si128((const __m128i *)&mb->vol[lr][v]);
+   __m128i s_lo, s_hi;
+
+   prod_lo = _mm_mullo_epi16(pvs, vol);
+   prod_hi = _mm_mulhi_epi16(pvs, vol);
+   s_lo = _mm_srai_epi32(_mm_unpacklo_epi16(prod_lo, prod_hi), 15);
+   s_hi = _mm_srai_epi32(_mm_unpackhi_epi16(prod_lo, prod_hi), 15);
+
+   sum[lr] = _mm_add_epi32(sum[lr], _mm_add_epi32(s_lo, s_hi));
+   sum_fv[lr] = _mm_add_epi32(sum_fv[lr], _mm_add_epi32(_mm_and_si128(s_lo, rm_lo), _mm_and_si128(s_hi, rm_hi)));
+  }
+ }
+
+ if(MDFN_UNLIKELY(_mm_movemask_epi8(overflow)))
+  return(false);
+
+ for(unsigned lr = 0; lr < 2; lr++)
+ {
+  accum[lr] += HSum32(sum[lr]);
+  accum_fv[lr] += HSum32(sum_fv[lr]);
+ }
+
+ return(true);
+}
+#endif
+
+static INLINE void MixVoices(SPU_MixBuffer *mb, const int16 noise, int32 *accum, int32 *accum_fv)
+{
+#if defined(__SSE2__)
+ if(MDFN_LIKELY(MixVoices_SSE2(mb, noise, accum, accum_fv)))
+  return;
+#endif
+ MixVoices_C(mb, noise, accum, accum_fv);
+}
+
 int32 PS_SPU::UpdateFromCDC(int32 clocks)
 //pscpu_timestamp_t PS_SPU::Update(const pscpu_timestamp_t timestamp)
 {
+ PSX_PROF_SCOPE(PSX_PROF_SPU);
  //int32 clocks = timestamp - lastts;
  int32 sample_clocks = 0;
  //lastts = timestamp;
@@ -594,12 +746,11 @@ int32 PS_SPU::UpdateFromCDC(int32 clocks)
   if(Regs[0xD6] == 0x4)	// TODO: Investigate more(case 0x2C in global regs r/w handler)
    SPUStatus |= (CWA & 0x100) ? 0x800 : 0x000;
 
+  MDFN_ALIGN(16) SPU_MixBuffer mb;
+
   for(int voice_num = 0; voice_num < 24; voice_num++)
   {
    SPU_Voice *voice = &Voices[voice_num];
-   int32 voice_pvs;
-
-   voice->PreLRSample = 0;
 
    //PSX_WARNING("[SPU] Voice %d CurPhase=%08x, pitch=%04x, CurAddr=%08x", voice_num, voice->CurPhase, voice->Pitch, voice->CurAddr);
 
@@ -619,43 +770,48 @@ int32 PS_SPU::UpdateFromCDC(int32 clocks)
    //
    //
    //
-   int l, r;
-
-   if(Noise_Mode & (1 << voice_num))
-    voice_pvs = (int16)LFSR;
-   else
    {
     const int si = voice->CurPhase >> 12;
     const int pi = ((voice->CurPhase & 0xFFF) >> 4);
 
-    voice_pvs = ((voice->DecodeBuffer[si + 0] * FIR_Table[pi][0]) +
-	       (voice->DecodeBuffer[si + 1] * FIR_Table[pi][1]) +
-	       (voice->DecodeBuffer[si + 2] * FIR_Table[pi][2]) +   
-	       (voice->DecodeBuffer[si + 3] * FIR_Table[pi][3])) >> 15;
+    for(unsigned i = 0; i < 4; i++)
+    {
+     mb.s[i][voice_num] = voice->DecodeBuffer[si + i];
+     mb.c[i][voice_num] = FIR_Table[pi][i];
+    }
    }
 
-   voice_pvs = (voice_pvs * (int16)voice->ADSR.EnvLevel) >> 15;
-   voice->PreLRSample = voice_pvs;
+   mb.noise_mask[voice_num] = (Noise_Mode & (1 << voice_num)) ? -1 : 0;
+   mb.env[voice_num] = (int16)voice->ADSR.EnvLevel;
+   mb.vol[0][voice_num] = voice->Sweep[0].ReadVolume();
+   mb.vol[1][voice_num] = voice->Sweep[1].ReadVolume();
+   mb.reverb_mask[voice_num] = (Reverb_Mode & (1 << voice_num)) ? -1 : 0;
 
    if(voice_num == 1 || voice_num == 3)
    {
     int index = voice_num >> 1;
 
-    WriteSPURAM(0x400 | (index * 0x200) | CWA, voice_pvs);
+    WriteSPURAM(0x400 | (index * 0x200) | CWA, MixVoiceSample(&mb, voice_num, (int16)LFSR));
    }
+  }
 
+  {
+   int32 accum[2] = { 0, 0 };
+   int32 accum_fv[2] = { 0, 0 };
 
-   l = (voice_pvs * voice->Sweep[0].ReadVolume()) >> 15;
-   r = (voice_pvs * voice->Sweep[1].ReadVolume()) >> 15;
+   MixVoices(&mb, (int16)LFSR, accum, accum_fv);
 
-   accum_l += l;
-   accum_r += r;
+   accum_l = accum[0];
+   accum_r = accum[1];
+   accum_fv_l = accum_fv[0];
+   accum_fv_r = accum_fv[1];
+  }
 
-   if(Reverb_Mode & (1 << voice_num))
-   {
-    accum_fv_l += l;
-    accum_fv_r += r;
-   }
+  for(int voice_num = 0; voice_num < 24; voice_num++)
+  {
+   SPU_Voice *voice = &Voices[voice_num];
+
+   voice->PreLRSample = mb.pvs[voice_num];
 
    // Run sweep
    for(int lr = 0; lr < 2; lr++)
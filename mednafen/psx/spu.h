@@ -223,9 +223,10 @@ class PS_SPU
 
  int32 ReverbCur;
 
- int32 Get_Reverb_Offset(int32 offset);
- int32 RD_RVB(int16 raw_offs);
- void WR_RVB(int16 raw_offs, int32 sample, int32 extra_offs = 0);
+ int32 Get_Reverb_RelOffset(int32 in_offset);
+ void CalcReverbTaps(uint32 *taps);
+ int32 RD_RVB(const uint32 *taps, unsigned which);
+ void WR_RVB(const uint32 *taps, unsigned which, int32 sample);
 
  bool IRQAsserted;
 
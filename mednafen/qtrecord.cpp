@@ -21,6 +21,7 @@
 #include "compress/minilzo.h"
 #include "video/png.h"
 
+#include <algorithm>
 #include <time.h>
 #include <zlib.h>
 
@@ -200,7 +201,13 @@ void QTRecord::atom_end(void)
  qtfile.seek(cur_offset, SEEK_SET);
 }
 
-QTRecord::QTRecord(const char *path, const VideoSpec &spec) : qtfile(path, FileWrapper::MODE_WRITE_SAFE), resampler(NULL)
+static int EncoderThreadStart_C(void *v_arg)
+{
+ return ((QTRecord *)v_arg)->EncoderThreadStart();
+}
+
+QTRecord::QTRecord(const char *path, const VideoSpec &spec) : qtfile(path, FileWrapper::MODE_WRITE_SAFE), QueueMutex(NULL), CommitMutex(NULL),
+											  WorkCond(NULL), FreeCond(NULL), CarryCond(NULL), resampler(NULL)
 {
  Finished = false;
 
@@ -255,15 +262,49 @@ QTRecord::QTRecord(const char *path, const VideoSpec &spec) : qtfile(path, FileW
 
  VideoCodec = spec.VideoCodec;
 
- if(VideoCodec == VCODEC_PNG)
-  RawVideoBuffer.resize((1 + QTVideoWidth * 3) * QTVideoHeight);
- else
-  RawVideoBuffer.resize(QTVideoWidth * QTVideoHeight * 3);
+ NumThreads = spec.Threads;
+ EncoderExit = false;
+ SubmitSeq = EncodeSeq = CommitSeq = CarrySeq = 0;
+ memset(&Stats, 0, sizeof(Stats));
 
- if(VideoCodec == VCODEC_CSCD)
-  CompressedVideoBuffer.resize((RawVideoBuffer.size() * 110 + 99 ) / 100);	// 1.10
- else if(VideoCodec == VCODEC_PNG)
-  CompressedVideoBuffer.resize(compressBound(RawVideoBuffer.size()));
+ if(NumThreads)
+ {
+  QueueMutex = MDFND_CreateMutex();
+  CommitMutex = MDFND_CreateMutex();
+  WorkCond = MDFND_CreateCond();
+  FreeCond = MDFND_CreateCond();
+  CarryCond = MDFND_CreateCond();
+
+  if(!QueueMutex || !CommitMutex || !WorkCond || !FreeCond || !CarryCond)
+  {
+   MDFN_printf(_("QuickTime recording: Condition variables not supported by driver; encoding on the emulation thread.\n"));
+   NumThreads = 0;
+  }
+ }
+
+ // Two queue slots per encoder thread, so each thread can have the next frame waiting for it while it compresses one.
+ Jobs.resize(NumThreads ? (NumThreads * 2) : 1);
+ Stats.queue_size = Jobs.size();
+
+ for(unsigned i = 0; i < Jobs.size(); i++)
+ {
+  FrameJob *job = &Jobs[i];
+
+  job->encoded = false;
+
+  if(VideoCodec == VCODEC_PNG)
+   job->RawVideoBuffer.resize((1 + QTVideoWidth * 3) * QTVideoHeight);
+  else
+   job->RawVideoBuffer.resize(QTVideoWidth * QTVideoHeight * 3);
+
+  if(VideoCodec == VCODEC_CSCD)
+  {
+   job->VideoData.resize(2 + (job->RawVideoBuffer.size() * 110 + 99 ) / 100);	// 1.10
+   job->lzo_workmem.resize((LZO1X_1_MEM_COMPRESS + sizeof(uint64) - 1) / sizeof(uint64));
+  }
+  else if(VideoCodec == VCODEC_PNG)
+   job->VideoData.resize(8 + (12 + 13) + 12 + compressBound(job->RawVideoBuffer.size()) + 12);
+ }
 
  {
   int64 unixy_time = time(NULL);
@@ -282,160 +323,239 @@ QTRecord::QTRecord(const char *path, const VideoSpec &spec) : qtfile(path, FileW
  Write_ftyp();
 
  atom_begin("mdat", false);
+
+ for(unsigned i = 0; i < NumThreads; i++)
+ {
+  MDFN_Thread *thread = MDFND_CreateThread(EncoderThreadStart_C, this);
+
+  if(!thread)
+  {
+   MDFN_printf(_("QuickTime recording: Error creating encoder thread.\n"));
+   break;
+  }
+
+  EncoderThreads.push_back(thread);
+ }
+
+ if(NumThreads && !EncoderThreads.size())
+ {
+  NumThreads = 0;
+  Jobs.resize(1);
+  Stats.queue_size = 1;
+ }
+
+ if(NumThreads)
+  CarryBuffer.resize(Jobs[0].RawVideoBuffer.size());
 }
 
 
-void QTRecord::WriteFrame(const MDFN_Surface *surface, const MDFN_Rect &DisplayRect, const MDFN_Rect *LineWidths,
-			  const int16 *SoundBuf, const int32 SoundBufSize, const int64 MasterCycles)
+//
+// Copies the visible part of the surface, one line per DisplayRect line, into "pixels", with the width of each line in "line_widths".
+//
+static void CopySourcePixels(std::vector<int32> *line_widths, std::vector<uint32> *pixels, const MDFN_Surface *surface, const MDFN_Rect &DisplayRect,
+			     const MDFN_Rect *LineWidths)
 {
- QTChunk qts;
+ size_t total = 0;
 
- memset(&qts, 0, sizeof(qts));
+ line_widths->resize(DisplayRect.h);
 
- if(DisplayRect.h <= 0)
+ for(int y = DisplayRect.y; y < DisplayRect.y + DisplayRect.h; y++)
  {
-  fprintf(stderr, "[BUG] qtrecord.cpp: DisplayRect.h <= 0\n");
-  return;
- }
+  const int32 width = (LineWidths[0].w == ~0) ? DisplayRect.w : LineWidths[y].w;
 
+  (*line_widths)[y - DisplayRect.y] = width;
 
- qts.video_foffset = qtfile.tell();
+  if(width > 0)
+   total += width;
+ }
+
+ if(pixels->size() < total)
+  pixels->resize(total);
 
- // Write video here
+ total = 0;
+ for(int y = DisplayRect.y; y < DisplayRect.y + DisplayRect.h; y++)
  {
-  uint32 dest_y = 0;
-  int yscale_factor = QTVideoHeight / DisplayRect.h;
+  const int32 x_start = (LineWidths[0].w == ~0) ? DisplayRect.x : LineWidths[y].x;
+  const int32 width = (*line_widths)[y - DisplayRect.y];
 
-  for(int y = DisplayRect.y; y < DisplayRect.y + DisplayRect.h; y++)
+  if(width > 0)
   {
-   int x_start;
-   int width;
-   int xscale_factor;
-   int32 dest_x;
-   uint32 *src_ptr;
-   uint8 *dest_line;
-
-   if(dest_y >= QTVideoHeight)
-    break;
+   memcpy(&(*pixels)[total], surface->pixels + y * surface->pitchinpix + x_start, width * sizeof(uint32));
+   total += width;
+  }
+ }
+}
 
-   if(VideoCodec == VCODEC_CSCD)
-    dest_line = &RawVideoBuffer[(QTVideoHeight - 1 - dest_y) * QTVideoWidth * 3];
-   else if(VideoCodec == VCODEC_PNG)
-    dest_line = &RawVideoBuffer[dest_y * (QTVideoWidth * 3 + 1)];
-   else
-    dest_line = &RawVideoBuffer[dest_y * QTVideoWidth * 3];
+// Returns the number of lines, from the top, written to the job's RawVideoBuffer.
+uint32 QTRecord::ConvertVideo(FrameJob *job)
+{
+ std::vector<uint8> &RawVideoBuffer = job->RawVideoBuffer;
+ const uint32 *src_ptr = job->pixels.size() ? &job->pixels[0] : NULL;
+ uint32 dest_y = 0;
+ uint32 lines_written = 0;
+ int yscale_factor = QTVideoHeight / job->rect_h;
 
-   if(LineWidths[0].w == ~0)
-   {
-    x_start = DisplayRect.x;
-    width = DisplayRect.w;
-   }
-   else
-   {
-    x_start = LineWidths[y].x;
-    width = LineWidths[y].w;
-   }
+ for(int y = 0; y < job->rect_h; y++)
+ {
+  int width;
+  int xscale_factor;
+  int32 dest_x;
+  uint8 *dest_line;
 
-   xscale_factor = QTVideoWidth / width;
+  if(dest_y >= QTVideoHeight)
+   break;
 
-   dest_x = 0;
+  if(VideoCodec == VCODEC_CSCD)
+   dest_line = &RawVideoBuffer[(QTVideoHeight - 1 - dest_y) * QTVideoWidth * 3];
+  else if(VideoCodec == VCODEC_PNG)
+   dest_line = &RawVideoBuffer[dest_y * (QTVideoWidth * 3 + 1)];
+  else
+   dest_line = &RawVideoBuffer[dest_y * QTVideoWidth * 3];
 
-   src_ptr = surface->pixels + y * surface->pitchinpix + x_start;
+  width = job->line_widths[y];
 
-   if(VideoCodec == VCODEC_PNG)
-   {
-    *dest_line = 0;
-    dest_line++;
-   }
+  xscale_factor = QTVideoWidth / width;
 
-#if 0
-   while(dest_x < ((QTVideoWidth - (xscale_factor * width)) / 2))
-   {
-    dest_line[dest_x * 3 + 0] = 0;
-    dest_line[dest_x * 3 + 1] = 0;
-    dest_line[dest_x * 3 + 2] = 0;
+  dest_x = 0;
 
-    dest_x++;
-   }
-#endif
+  if(VideoCodec == VCODEC_PNG)
+  {
+   *dest_line = 0;
+   dest_line++;
+  }
 
-   for(int x = x_start; x < x_start + width; x++)
+  for(int x = 0; x < width; x++)
+  {
+   for(int sub_x = 0; sub_x < xscale_factor; sub_x++)
    {
-    for(int sub_x = 0; sub_x < xscale_factor; sub_x++)
+    if(dest_x < QTVideoWidth)
     {
-     if(dest_x < QTVideoWidth)
+     int r, g, b, a;
+
+     job->format.DecodeColor(*src_ptr, r, g, b, a);
+
+     if(VideoCodec == VCODEC_CSCD)
      {
-      int r, g, b, a;
-
-      surface->DecodeColor(*src_ptr, r, g, b, a);
-
-      if(VideoCodec == VCODEC_CSCD)
-      {
-       dest_line[dest_x * 3 + 0] = b;
-       dest_line[dest_x * 3 + 1] = g;
-       dest_line[dest_x * 3 + 2] = r;
-      }
-      else
-      {
-       dest_line[dest_x * 3 + 0] = r;
-       dest_line[dest_x * 3 + 1] = g;
-       dest_line[dest_x * 3 + 2] = b;
-      }
-
-      dest_x++;
+      dest_line[dest_x * 3 + 0] = b;
+      dest_line[dest_x * 3 + 1] = g;
+      dest_line[dest_x * 3 + 2] = r;
      }
+     else
+     {
+      dest_line[dest_x * 3 + 0] = r;
+      dest_line[dest_x * 3 + 1] = g;
+      dest_line[dest_x * 3 + 2] = b;
+     }
+
+     dest_x++;
     }
-    src_ptr++;
    }
+   src_ptr++;
+  }
 
-   while(dest_x < QTVideoWidth)
-   {
-    dest_line[dest_x * 3 + 0] = 0;
-    dest_line[dest_x * 3 + 1] = 0;
-    dest_line[dest_x * 3 + 2] = 0;
+  while(dest_x < QTVideoWidth)
+  {
+   dest_line[dest_x * 3 + 0] = 0;
+   dest_line[dest_x * 3 + 1] = 0;
+   dest_line[dest_x * 3 + 2] = 0;
 
-    dest_x++;
-   }
+   dest_x++;
+  }
 
-   for(int sub_y = 1; sub_y < yscale_factor; sub_y++)
-   {
-    if((dest_y + sub_y) >= QTVideoHeight)
-     break;
-
-    if(VideoCodec == VCODEC_CSCD)
-     memcpy(&RawVideoBuffer[(QTVideoHeight - 1 - (dest_y + sub_y)) * QTVideoWidth * 3], dest_line, QTVideoWidth * 3);
-    else if(VideoCodec == VCODEC_PNG)
-     memcpy(&RawVideoBuffer[(dest_y + sub_y) * (QTVideoWidth * 3 + 1)], dest_line - 1, QTVideoWidth * 3 + 1);
-    else
-     memcpy(&RawVideoBuffer[(dest_y + sub_y) * QTVideoWidth * 3], dest_line, QTVideoWidth * 3);
-   }
+  for(int sub_y = 1; sub_y < yscale_factor; sub_y++)
+  {
+   if((dest_y + sub_y) >= QTVideoHeight)
+    break;
 
-   dest_y += yscale_factor;
-  } // end for(int y = DisplayRect.y; y < DisplayRect.y + DisplayRect.h; y++)
- }
+   if(VideoCodec == VCODEC_CSCD)
+    memcpy(&RawVideoBuffer[(QTVideoHeight - 1 - (dest_y + sub_y)) * QTVideoWidth * 3], dest_line, QTVideoWidth * 3);
+   else if(VideoCodec == VCODEC_PNG)
+    memcpy(&RawVideoBuffer[(dest_y + sub_y) * (QTVideoWidth * 3 + 1)], dest_line - 1, QTVideoWidth * 3 + 1);
+   else
+    memcpy(&RawVideoBuffer[(dest_y + sub_y) * QTVideoWidth * 3], dest_line, QTVideoWidth * 3);
+  }
 
+  lines_written = std::min<uint32>(QTVideoHeight, dest_y + std::max<int>(1, yscale_factor));
+  dest_y += yscale_factor;
+ } // end for(int y = 0; y < job->rect_h; y++)
+
+ return(lines_written);
+}
+
+// Lines a frame doesn't reach(when its height doesn't divide evenly into the video height) keep whatever the last frame to reach them
+// put there, as when there's only the one RawVideoBuffer.  With frames converted in parallel, those lines are kept in "CarryBuffer",
+// which is updated by each frame in turn.
+void QTRecord::CarryLines(FrameJob *job, const uint32 lines_written)
+{
+ const size_t line_size = CarryBuffer.size() / QTVideoHeight;
+ const size_t written_size = lines_written * line_size;
+ const size_t unwritten_size = CarryBuffer.size() - written_size;
+ // CSCD frames are stored bottom line first.
+ const size_t written_offs = (VideoCodec == VCODEC_CSCD) ? unwritten_size : 0;
+ const size_t unwritten_offs = (VideoCodec == VCODEC_CSCD) ? 0 : written_size;
+
+ MDFND_LockMutex(QueueMutex);
+ while(CarrySeq != job->seq)
+  MDFND_WaitCond(CarryCond, QueueMutex);
+ MDFND_UnlockMutex(QueueMutex);
+
+ memcpy(&CarryBuffer[written_offs], &job->RawVideoBuffer[written_offs], written_size);
+ memcpy(&job->RawVideoBuffer[unwritten_offs], &CarryBuffer[unwritten_offs], unwritten_size);
+
+ MDFND_LockMutex(QueueMutex);
+ CarrySeq++;
+ for(unsigned i = 0; i < EncoderThreads.size(); i++)
+  MDFND_SignalCond(CarryCond);
+ MDFND_UnlockMutex(QueueMutex);
+}
+
+// Same format as PNGWrite::WriteChunk(), with the chunk data already in place at "dest + 8".  Returns the size of the whole chunk.
+static uint32 PNGChunkInPlace(uint8 *dest, uint32 size, const char *type)
+{
+ uint32 crc;
+
+ MDFN_en32msb(dest, size);
+ memcpy(dest + 4, type, 4);
+
+ crc = crc32(0, (uint8 *)type, 4);
+ if(size)
+  crc = crc32(crc, dest + 8, size);
+
+ MDFN_en32msb(dest + 8 + size, crc);
+
+ return(12 + size);
+}
+
+void QTRecord::EncodeVideo(FrameJob *job)
+{
  if(VideoCodec == VCODEC_CSCD)
  {
-  static uint8 workmem[LZO1X_1_MEM_COMPRESS];
-  lzo_uint dst_len = CompressedVideoBuffer.size();
+  uint8 *const buf = &job->VideoData[0];
+  lzo_uint dst_len = job->VideoData.size() - 2;
 
-  qtfile.put_char((0 << 1) | 0x1);
-  qtfile.put_char(0);
+  buf[0] = (0 << 1) | 0x1;
+  buf[1] = 0;
 
-  lzo1x_1_compress(&RawVideoBuffer[0], RawVideoBuffer.size(), &CompressedVideoBuffer[0], &dst_len, workmem);
+  lzo1x_1_compress(&job->RawVideoBuffer[0], job->RawVideoBuffer.size(), buf + 2, &dst_len, &job->lzo_workmem[0]);
 
-  qtfile.write(&CompressedVideoBuffer[0], dst_len);
+  job->video_ptr = buf;
+  job->video_size = 2 + dst_len;
  }
  else if(VideoCodec == VCODEC_RAW)
-  qtfile.write(&RawVideoBuffer[0], RawVideoBuffer.size());
+ {
+  job->video_ptr = &job->RawVideoBuffer[0];
+  job->video_size = job->RawVideoBuffer.size();
+ }
  else if(VideoCodec == VCODEC_PNG)
  {
-  //PNGWrite(qtfile, surface, DisplayRect, LineWidths);
   static const uint8 png_sig[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
-  uint8 IHDR[13];
+  uint8 *const buf = &job->VideoData[0];
+  uint8 *IHDR = buf + 8 + 8;
+  uint32 offs = 0;
   uLongf compress_buffer_size;
 
-  qtfile.write(png_sig, sizeof(png_sig));
+  memcpy(buf, png_sig, sizeof(png_sig));
+  offs += sizeof(png_sig);
 
   MDFN_en32msb(&IHDR[0], QTVideoWidth);
   MDFN_en32msb(&IHDR[4], QTVideoHeight);
@@ -446,27 +566,185 @@ void QTRecord::WriteFrame(const MDFN_Surface *surface, const MDFN_Rect &DisplayR
   IHDR[11] = 0;	// Basic adaptive filter set
   IHDR[12] = 0;	// No interlace
 
+  offs += PNGChunkInPlace(buf + offs, 13, "IHDR");
 
-  PNGWrite::WriteChunk(qtfile, 13, "IHDR", IHDR);
+  compress_buffer_size = job->VideoData.size() - offs - 8 - 4 - 12;
 
-  compress_buffer_size = CompressedVideoBuffer.size();
+  compress(buf + offs + 8, &compress_buffer_size, &job->RawVideoBuffer[0], job->RawVideoBuffer.size());
 
-  compress(&CompressedVideoBuffer[0], &compress_buffer_size, &RawVideoBuffer[0], RawVideoBuffer.size());
+  offs += PNGChunkInPlace(buf + offs, compress_buffer_size, "IDAT");
 
-  PNGWrite::WriteChunk(qtfile, compress_buffer_size, "IDAT", &CompressedVideoBuffer[0]);
+  offs += PNGChunkInPlace(buf + offs, 0, "IEND");
 
-  PNGWrite::WriteChunk(qtfile, 0, "IEND", 0);
+  job->video_ptr = buf;
+  job->video_size = offs;
  }
+}
 
+void QTRecord::CommitJob(FrameJob *job)
+{
+ QTChunk qts;
 
+ memset(&qts, 0, sizeof(qts));
 
+ qts.video_foffset = qtfile.tell();
+ qtfile.write(job->video_ptr, job->video_size);
  qts.video_byte_size = qtfile.tell() - qts.video_foffset;
 
+ qts.audio_foffset = qtfile.tell();
+ qtfile.write(job->AudioData.size() ? &job->AudioData[0] : NULL, sizeof(int16) * job->audio_frames * SoundChan);
+ qts.audio_byte_size = qtfile.tell() - qts.audio_foffset;
 
+ qts.time_length = job->time_length;
 
- qts.audio_foffset = qtfile.tell();
+ QTChunks.push_back(qts);
+}
+
+// Writes out, in order, every encoded frame that is next in line.  Called by each encoder thread after it finishes a frame; if the
+// frame it finished isn't next in line, whichever thread finishes the earlier frame will write it.
+void QTRecord::CommitReady(void)
+{
+ MDFND_LockMutex(CommitMutex);
+
+ for(;;)
+ {
+  FrameJob *job = NULL;
+
+  MDFND_LockMutex(QueueMutex);
+  if(CommitSeq != EncodeSeq && Jobs[CommitSeq % Jobs.size()].encoded)
+   job = &Jobs[CommitSeq % Jobs.size()];
+  MDFND_UnlockMutex(QueueMutex);
+
+  if(!job)
+   break;
+
+  // After a write error, frames are still retired(so WriteFrame() and Finish() can't deadlock), but not written.
+  if(AsyncError.size() == 0)
+  {
+   try
+   {
+    CommitJob(job);
+   }
+   catch(std::exception &e)
+   {
+    MDFND_LockMutex(QueueMutex);
+    AsyncError = e.what();
+    MDFND_UnlockMutex(QueueMutex);
+   }
+  }
+
+  MDFND_LockMutex(QueueMutex);
+  job->encoded = false;
+  CommitSeq++;
+  MDFND_SignalCond(FreeCond);
+  MDFND_UnlockMutex(QueueMutex);
+ }
+
+ MDFND_UnlockMutex(CommitMutex);
+}
+
+int QTRecord::EncoderThreadStart(void)
+{
+ MDFND_LockMutex(QueueMutex);
+
+ for(;;)
+ {
+  FrameJob *job;
 
- // Write audio here
+  while(!EncoderExit && EncodeSeq == SubmitSeq)
+   MDFND_WaitCond(WorkCond, QueueMutex);
+
+  if(EncodeSeq == SubmitSeq)	// EncoderExit, and nothing left to do.
+   break;
+
+  job = &Jobs[EncodeSeq % Jobs.size()];
+  EncodeSeq++;
+  MDFND_UnlockMutex(QueueMutex);
+
+  CarryLines(job, ConvertVideo(job));
+  EncodeVideo(job);
+
+  MDFND_LockMutex(QueueMutex);
+  job->encoded = true;
+  MDFND_UnlockMutex(QueueMutex);
+
+  CommitReady();
+
+  MDFND_LockMutex(QueueMutex);
+ }
+
+ MDFND_UnlockMutex(QueueMutex);
+
+ return(1);
+}
+
+void QTRecord::StopEncoderThreads(void)
+{
+ if(!EncoderThreads.size())
+  return;
+
+ MDFND_LockMutex(QueueMutex);
+ EncoderExit = true;
+ for(unsigned i = 0; i < EncoderThreads.size(); i++)
+  MDFND_SignalCond(WorkCond);
+ MDFND_UnlockMutex(QueueMutex);
+
+ for(unsigned i = 0; i < EncoderThreads.size(); i++)
+  MDFND_WaitThread(EncoderThreads[i], NULL);
+
+ EncoderThreads.clear();
+}
+
+QTRecord::PipelineStats QTRecord::GetPipelineStats(void)
+{
+ return(Stats);
+}
+
+void QTRecord::WriteFrame(const MDFN_Surface *surface, const MDFN_Rect &DisplayRect, const MDFN_Rect *LineWidths,
+			  const int16 *SoundBuf, const int32 SoundBufSize, const int64 MasterCycles)
+{
+ FrameJob *job;
+
+ if(DisplayRect.h <= 0)
+ {
+  fprintf(stderr, "[BUG] qtrecord.cpp: DisplayRect.h <= 0\n");
+  return;
+ }
+
+ if(NumThreads)
+ {
+  std::string error;
+
+  MDFND_LockMutex(QueueMutex);
+
+  if((SubmitSeq - CommitSeq) >= Jobs.size())
+  {
+   const uint32 wait_start = MDFND_GetTime();
+
+   while((SubmitSeq - CommitSeq) >= Jobs.size())
+    MDFND_WaitCond(FreeCond, QueueMutex);
+
+   Stats.stalls++;
+   Stats.stall_ms += MDFND_GetTime() - wait_start;
+  }
+
+  error = AsyncError;
+  MDFND_UnlockMutex(QueueMutex);
+
+  if(error.size())
+   throw MDFN_Error(0, "%s", error.c_str());
+
+  job = &Jobs[SubmitSeq % Jobs.size()];
+ }
+ else
+  job = &Jobs[0];
+
+ // Video source
+ job->format = surface->format;
+ job->rect_h = DisplayRect.h;
+ CopySourcePixels(&job->line_widths, &job->pixels, surface, DisplayRect, LineWidths);
+
+ // Audio
  //
  //
  int32 SoundBufROSize;
@@ -512,31 +790,29 @@ void QTRecord::WriteFrame(const MDFN_Surface *surface, const MDFN_Rect &DisplayR
   ResampInBufferFramesInCount -= in_len;
   SoundBufROSize = out_len;
 
+  if(job->AudioData.size() < SoundBufROSize * SoundChan)
+   job->AudioData.resize(SoundBufROSize * SoundChan);
+
   for(int i = 0; i < SoundBufROSize * SoundChan; i++)
-   MDFN_en16msb((uint8 *)&ResampOutBuffer[i], ResampOutBuffer[i]);
+   MDFN_en16msb((uint8 *)&job->AudioData[i], ResampOutBuffer[i]);
  }
  else
  {
   SoundBufROSize = SoundBufSize;
 
-  if(ResampOutBuffer.size() < SoundBufSize * SoundChan)
-   ResampOutBuffer.resize(SoundBufSize * SoundChan);
+  if(job->AudioData.size() < SoundBufSize * SoundChan)
+   job->AudioData.resize(SoundBufSize * SoundChan);
 
   for(int i = 0; i < SoundBufROSize * SoundChan; i++)
-   MDFN_en16msb((uint8 *)&ResampOutBuffer[i], SoundBuf[i]);
+   MDFN_en16msb((uint8 *)&job->AudioData[i], SoundBuf[i]);
  }
-
- qtfile.write(&ResampOutBuffer[0], sizeof(int16) * SoundBufROSize * SoundChan);
- //
- //
- //
- qts.audio_byte_size = qtfile.tell() - qts.audio_foffset;
+ job->audio_frames = SoundBufROSize;
 
  SoundFramesWritten += SoundBufROSize;
 
  if(SoundRate && SoundChan)
  {
-  qts.time_length = qts.audio_byte_size / SoundChan / sizeof(int16);
+  job->time_length = SoundBufROSize;
   TimeIndex += SoundBufROSize;
  }
  else
@@ -549,11 +825,27 @@ void QTRecord::WriteFrame(const MDFN_Surface *surface, const MDFN_Rect &DisplayR
 
   //printf("%u\n", tnt);
 
-  qts.time_length = tnt;
+  job->time_length = tnt;
   TimeIndex += tnt;
  }
 
- QTChunks.push_back(qts);
+ Stats.frames++;
+
+ if(NumThreads)
+ {
+  MDFND_LockMutex(QueueMutex);
+  job->encoded = false;
+  job->seq = SubmitSeq;
+  SubmitSeq++;
+  MDFND_SignalCond(WorkCond);
+  MDFND_UnlockMutex(QueueMutex);
+ }
+ else
+ {
+  ConvertVideo(job);
+  EncodeVideo(job);
+  CommitJob(job);
+ }
 }
 
 void QTRecord::Write_ftyp(void) // Leaf
@@ -1087,6 +1379,23 @@ void QTRecord::Finish(void)
 
  Finished = true;
 
+ if(NumThreads)
+ {
+  MDFND_LockMutex(QueueMutex);
+  while(CommitSeq != SubmitSeq)
+   MDFND_WaitCond(FreeCond, QueueMutex);
+  MDFND_UnlockMutex(QueueMutex);
+
+  StopEncoderThreads();
+
+  MDFN_printf(_("QuickTime recording: %llu frames, %llu waits on the encoder threads(%llu ms total).\n"), (unsigned long long)Stats.frames,
+	(unsigned long long)Stats.stalls, (unsigned long long)Stats.stall_ms);
+
+  // WriteFrame() won't be around to report an error writing out the last few frames.
+  if(AsyncError.size())
+   throw MDFN_Error(0, "%s", AsyncError.c_str());
+ }
+
  atom_end();
 
  Write_moov();
@@ -1105,6 +1414,38 @@ QTRecord::~QTRecord(void)
   MDFND_PrintError(e.what());
  }
 
+ StopEncoderThreads();
+
+ if(CarryCond)
+ {
+  MDFND_DestroyCond(CarryCond);
+  CarryCond = NULL;
+ }
+
+ if(FreeCond)
+ {
+  MDFND_DestroyCond(FreeCond);
+  FreeCond = NULL;
+ }
+
+ if(WorkCond)
+ {
+  MDFND_DestroyCond(WorkCond);
+  WorkCond = NULL;
+ }
+
+ if(CommitMutex)
+ {
+  MDFND_DestroyMutex(CommitMutex);
+  CommitMutex = NULL;
+ }
+
+ if(QueueMutex)
+ {
+  MDFND_DestroyMutex(QueueMutex);
+  QueueMutex = NULL;
+ }
+
  if(resampler)
  {
   speex_resampler_destroy(resampler);
@@ -33,6 +33,8 @@ class QTRecord
   int64 MasterClock;	// Fixed-point, 32.32, should be used when SoundRate == 0
 
   int VideoCodec;
+
+  unsigned Threads;	// Number of video encoder threads; 0 to convert and compress on the thread calling WriteFrame().
  };
 
  QTRecord(const char *path, const VideoSpec &spec_arg);
@@ -41,6 +43,20 @@ class QTRecord
 
  void WriteFrame(const MDFN_Surface *surface, const MDFN_Rect &DisplayRect, const MDFN_Rect *LineWidths,
                           const int16 *SoundBuf, const int32 SoundBufSize, const int64 MasterCycles);
+
+ // Encoder pipeline statistics; with encoder threads, "stalls" counts the frames for which WriteFrame() had to wait
+ // for a free queue slot, and "stall_ms" the total time spent waiting.
+ struct PipelineStats
+ {
+  uint64 frames;
+  uint64 stalls;
+  uint64 stall_ms;
+  uint32 queue_size;
+ };
+
+ PipelineStats GetPipelineStats(void);
+
+ int EncoderThreadStart(void);
  private:
 
  void w8(uint8 val);
@@ -82,8 +98,59 @@ class QTRecord
 
  FileWrapper qtfile;
 
- std::vector<uint8> RawVideoBuffer;
- std::vector<uint8> CompressedVideoBuffer;
+ //
+ // One queued frame.  The source pixels are copied out of the emulated surface by WriteFrame(), and audio is resampled and
+ // converted there too(the resampler is stateful); colour conversion and compression happen on an encoder thread, and
+ // finished frames are written to the file strictly in submission order, so the output is identical to that of synchronous
+ // encoding.
+ //
+ struct FrameJob
+ {
+  MDFN_PixelFormat format;
+  int32 rect_h;
+  std::vector<int32> line_widths;	// rect_h entries
+  std::vector<uint32> pixels;		// Lines packed back to back.
+
+  std::vector<uint8> RawVideoBuffer;
+  std::vector<uint8> VideoData;		// Complete video chunk for CSCD and PNG.
+  std::vector<uint64> lzo_workmem;
+  const uint8 *video_ptr;
+  uint32 video_size;
+
+  std::vector<int16> AudioData;		// Big-endian
+  uint32 audio_frames;
+  uint32 time_length;
+
+  bool encoded;
+  uint64 seq;
+ };
+
+ uint32 ConvertVideo(FrameJob *job);
+ void CarryLines(FrameJob *job, const uint32 lines_written);
+ void EncodeVideo(FrameJob *job);
+ void CommitJob(FrameJob *job);
+ void CommitReady(void);
+ void StopEncoderThreads(void);
+
+ std::vector<FrameJob> Jobs;
+ unsigned NumThreads;
+ std::vector<MDFN_Thread *> EncoderThreads;
+ MDFN_Mutex *QueueMutex;	// Protects the sequence numbers, "encoded", and "AsyncError".
+ MDFN_Mutex *CommitMutex;	// Held while writing frames to "qtfile".
+ MDFN_Cond *WorkCond;
+ MDFN_Cond *FreeCond;
+ MDFN_Cond *CarryCond;
+ bool EncoderExit;
+
+ // Frame sequence numbers; frame "n" lives in Jobs[n % Jobs.size()].
+ uint64 SubmitSeq;
+ uint64 EncodeSeq;
+ uint64 CommitSeq;
+ uint64 CarrySeq;			// Frame whose turn it is to update "CarryBuffer".
+ std::vector<uint8> CarryBuffer;
+
+ std::string AsyncError;
+ PipelineStats Stats;
 
  std::list<bool> atom_smalls;
  std::list<int64> atom_foffsets;
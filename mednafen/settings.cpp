@@ -39,6 +39,9 @@ typedef struct
 
 std::multimap <uint32, MDFNCS> CurrentSettings;
 std::vector<UnknownSetting_t> UnknownSettings;
+static std::vector<MDFN_SettingHandle *> BoundHandles;
+
+void MDFN_SettingHandles_Changed(const MDFNCS *setting);
 
 static MDFNCS *FindSetting(const char *name, bool deref_alias = true, bool dont_freak_out_on_fail = false);
 
@@ -316,6 +319,7 @@ static void ParseSettingLine(std::string &linebuf, bool IsOverrideSetting = fals
   }
 
   ValidateSetting(nv, zesetting->desc);	// TODO: Validate later(so command line options can override invalid setting file data correctly)
+  MDFN_SettingHandles_Changed(zesetting);
  }
  else if(!IsOverrideSetting)
  {
@@ -494,6 +498,9 @@ void MDFN_KillSettings(void)
 {
  std::multimap <uint32, MDFNCS>::iterator sit;
 
+ while(BoundHandles.size())
+  BoundHandles.back()->Unbind();
+
  for(sit = CurrentSettings.begin(); sit != CurrentSettings.end(); sit++)
  {
   if(sit->second.desc->type == MDFNST_ALIAS)
@@ -645,6 +652,107 @@ std::string MDFN_GetSettingS(const char *name)
  return(std::string(value));
 }
 
+MDFN_SettingHandle::MDFN_SettingHandle() : cs(NULL), notify(NULL), value_ui(0), value_i(0), value_f(0)
+{
+
+}
+
+void MDFN_SettingHandle::Update(void)
+{
+ const MDFNCS *setting = cs;
+ const char *value = GetSetting(setting);
+ unsigned long long ui = 0;
+ long long i = 0;
+ double f = 0;
+
+ switch(setting->desc->type)
+ {
+  default:
+	break;
+
+  case MDFNST_UINT:
+  case MDFNST_BOOL:
+	TranslateSettingValueUI(value, ui);
+	i = ui;
+	f = ui;
+	break;
+
+  case MDFNST_INT:
+	TranslateSettingValueI(value, i);
+	ui = i;
+	f = i;
+	break;
+
+  case MDFNST_FLOAT:
+	MR_StringToDouble(value, &f);
+	ui = (unsigned long long)f;
+	i = (long long)f;
+	break;
+
+  case MDFNST_ENUM:
+	i = GetEnum(setting, value);
+	ui = i;
+	f = i;
+	break;
+ }
+
+ {
+  uint64 f_bits;
+
+  memcpy(&f_bits, &f, sizeof(double));
+
+  Store<uint64>(&value_ui, ui);
+  Store<int64>(&value_i, i);
+  Store<uint64>(&value_f, f_bits);
+ }
+}
+
+void MDFN_SettingHandles_Changed(const MDFNCS *setting)
+{
+ // Copy the list, in case a notification function binds or unbinds a handle.
+ const std::vector<MDFN_SettingHandle *> handles = BoundHandles;
+
+ for(unsigned int i = 0; i < handles.size(); i++)
+ {
+  if(handles[i]->cs == setting)
+   handles[i]->Update();
+ }
+
+ for(unsigned int i = 0; i < handles.size(); i++)
+ {
+  if(handles[i]->cs == setting && handles[i]->notify)
+   handles[i]->notify(setting->name);
+ }
+}
+
+void MDFN_SettingHandle::Bind(const char *name, void (*notify_func)(const char *name))
+{
+ Unbind();
+
+ cs = FindSetting(name);
+ notify = notify_func;
+
+ assert(cs->desc->type != MDFNST_STRING);
+
+ Update();
+ BoundHandles.push_back(this);
+}
+
+void MDFN_SettingHandle::Unbind(void)
+{
+ for(unsigned int i = 0; i < BoundHandles.size(); i++)
+ {
+  if(BoundHandles[i] == this)
+  {
+   BoundHandles.erase(BoundHandles.begin() + i);
+   break;
+  }
+ }
+
+ cs = NULL;
+ notify = NULL;
+}
+
 const std::multimap <uint32, MDFNCS> *MDFNI_GetSettings(void)
 {
  return(&CurrentSettings);
@@ -688,6 +796,8 @@ bool MDFNI_SetSetting(const char *name, const char *value, bool NetplayOverride)
    zesetting->value = strdup(value);
   }
 
+  MDFN_SettingHandles_Changed(zesetting);
+
   // TODO, always call driver notification function, regardless of whether a game is loaded.
   if(zesetting->ChangeNotification)
   {
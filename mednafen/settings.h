@@ -2,6 +2,7 @@
 #define MDFN_SETTINGS_H
 
 #include <string>
+#include <string.h>
 
 #include "settings-common.h"
 
@@ -19,4 +20,83 @@ int64 MDFN_GetSettingI(const char *name);
 double MDFN_GetSettingF(const char *name);
 bool MDFN_GetSettingB(const char *name);
 std::string MDFN_GetSettingS(const char *name);
+
+//
+// Pre-resolved handle to a setting, for settings that are read often(e.g. every frame), which avoids the name lookup and value parsing
+// done by MDFN_GetSetting*().
+//
+// Bind() a handle to a setting by name once(e.g. when a game is loaded), and read the parsed value, with any per-game or netplay
+// override applied, with the accessor matching the setting's type; the cached value is updated whenever the setting changes, after which
+// the change notification function passed to Bind(), if any, is called.  Reading a handle is safe from any thread.
+//
+// Handles are usually static; Unbind() them when they're no longer needed(e.g. when the game is closed).  String settings aren't
+// supported.
+//
+class MDFN_SettingHandle
+{
+ public:
+
+ MDFN_SettingHandle();
+
+ void Bind(const char *name, void (*notify)(const char *name) = NULL);
+ void Unbind(void);
+
+ INLINE uint64 UI(void) const
+ {
+  return(Load(&value_ui));
+ }
+
+ INLINE int64 I(void) const
+ {
+  return(Load(&value_i));
+ }
+
+ INLINE double F(void) const
+ {
+  uint64 tmp = Load(&value_f);
+  double ret;
+
+  memcpy(&ret, &tmp, sizeof(double));
+
+  return(ret);
+ }
+
+ INLINE bool B(void) const
+ {
+  return((bool)UI());
+ }
+
+ private:
+
+ friend void MDFN_SettingHandles_Changed(const struct __MDFNCS *setting);
+
+ void Update(void);
+
+ template<typename T>
+ static INLINE T Load(const T *v)
+ {
+  #if defined(__GNUC__)
+  return(__atomic_load_n(v, __ATOMIC_RELAXED));
+  #else
+  return(*(volatile const T *)v);
+  #endif
+ }
+
+ template<typename T>
+ static INLINE void Store(T *v, T value)
+ {
+  #if defined(__GNUC__)
+  __atomic_store_n(v, value, __ATOMIC_RELAXED);
+  #else
+  *(volatile T *)v = value;
+  #endif
+ }
+
+ struct __MDFNCS *cs;
+ void (*notify)(const char *name);
+
+ uint64 value_ui;
+ int64 value_i;
+ uint64 value_f;	// Bit pattern of a double.
+};
 #endif
@@ -22,6 +22,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <time.h>
+#include <algorithm>
 
 #include <trio/trio.h>
 #include "driver.h"
@@ -1004,6 +1005,11 @@ void MDFNI_LoadState(const char *fname, const char *suffix)
 #include "compress/minilzo.h"
 #include "compress/quicklz.h"
 #include "compress/blz.h"
+#include "SPSCQueue.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 static union
 {
@@ -1018,24 +1024,307 @@ enum
  SRW_COMPRESSOR_BLZ
 };
 
+//
+// State rewinding.
+//
+// Only the newest state is kept whole(in SRW_Cur).  Every older frame is kept as an XOR delta against the state of the frame after it,
+// split into SRW_CHUNK_SIZE chunks with the unchanged(all-zero) chunks left out, compressed, and stored in a fixed-size arena that's used
+// as a ring; when it fills up, the oldest deltas are dropped.  Compression runs on a separate thread if the driver can create one.
+//
+// Packed delta layout(before compression):  1 bit per chunk, set if the chunk is present; followed by the present chunks.
+//
+enum { SRW_CHUNK_SIZE = 4096 };
+enum { SRW_NUM_PACKBUFS = 4 };
+
 struct StateMemPacket
 {
-	uint8 *data;
+	uint32 arena_pos;
 	uint32 compressed_len;
-	uint32 uncompressed_len;
+	uint32 packed_len;
+	uint32 uncompressed_len;	// Length of the state this delta reconstructs; 0 if there's no delta in this slot.
 
 	StateMem MovieLove;
 };
 
+struct SRWJob
+{
+	int32 slot;		// -1 tells the compression thread to exit.
+	uint32 packed_len;
+	uint32 uncompressed_len;
+	uint8 *packed;
+};
+
 static int SRW_NUM = 600;
 static int SRWCompressor;
 static int EvilEnabled = 0;
 static StateMemPacket *bcs;
 static int32 bcspos;
 
+// Only touched by the compression thread while it's running; the main thread has to SRW_Fence() before looking at these(or at the
+// non-MovieLove members of bcs[]).
+static uint8 *SRW_Arena = NULL;
+static uint32 SRW_ArenaSize;
+static uint32 SRW_ArenaHead;
+static int32 SRW_Oldest, SRW_Newest;	// Slots of the oldest and newest deltas, or -1 if there are none.
+static std::vector<uint8> SRW_CompBuf;
+
+// Main thread only.
+static StateMem SRW_Cur, SRW_Prev;
+static std::vector<uint8> SRW_PackBuf[SRW_NUM_PACKBUFS];
+static uint32 SRW_PackBufIndex;
+static std::vector<uint8> SRW_UnpackBuf;
+
+static SPSCQueue<SRWJob> *SRW_Queue = NULL;
+static MDFN_Thread *SRW_Thread = NULL;
+
+// Returns true if any of the "len" bytes written to "out" are non-zero.
+static INLINE bool SRW_XORBlock(uint8 *out, const uint8 *a, const uint8 *b, uint32 len)
+{
+ uint32 x = 0;
+ bool nonzero = false;
+
+#if defined(__SSE2__)
+ __m128i accum = _mm_setzero_si128();
+
+ for(; (x + 16) <= len; x += 16)
+ {
+  __m128i d = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(a + x)), _mm_loadu_si128((const __m128i *)(b + x)));
+
+  _mm_storeu_si128((__m128i *)(out + x), d);
+  accum = _mm_or_si128(accum, d);
+ }
+
+ nonzero = (_mm_movemask_epi8(_mm_cmpeq_epi8(accum, _mm_setzero_si128())) != 0xFFFF);
+#else
+ uint64 accum = 0;
+
+ for(; (x + 8) <= len; x += 8)
+ {
+  uint64 ta, tb;
+
+  memcpy(&ta, a + x, 8);
+  memcpy(&tb, b + x, 8);
+  ta ^= tb;
+  memcpy(out + x, &ta, 8);
+  accum |= ta;
+ }
+
+ nonzero = (accum != 0);
+#endif
+
+ for(; x < len; x++)
+ {
+  out[x] = a[x] ^ b[x];
+  nonzero |= (out[x] != 0);
+ }
+
+ return(nonzero);
+}
+
+// Makes sure st->data has room for "len" bytes, zero-filling anything past st->len.
+static void SRW_PadState(StateMem *st, uint32 len)
+{
+ if(len <= st->len)
+  return;
+
+ if(st->malloced < len)
+ {
+  st->data = (uint8 *)realloc(st->data, len);
+  st->malloced = len;
+ }
+
+ memset(st->data + st->len, 0, len - st->len);
+}
+
+// Packs "prev ^ cur" over prev's length into "out", returning the packed length.  "out" needs room for SRW_MaxPackedLen(prev->len) bytes.
+static INLINE uint32 SRW_MaxPackedLen(uint32 len)
+{
+ return(((len + SRW_CHUNK_SIZE - 1) / SRW_CHUNK_SIZE + 7) / 8 + len);
+}
+
+static uint32 SRW_PackDelta(uint8 *out, const StateMem *prev, const StateMem *cur)
+{
+ const uint32 num_chunks = (prev->len + SRW_CHUNK_SIZE - 1) / SRW_CHUNK_SIZE;
+ const uint32 bitmap_len = (num_chunks + 7) / 8;
+ uint8 *out_chunk = out + bitmap_len;
+
+ memset(out, 0, bitmap_len);
+
+ for(uint32 i = 0; i < num_chunks; i++)
+ {
+  const uint32 offs = i * SRW_CHUNK_SIZE;
+  const uint32 clen = std::min<uint32>(SRW_CHUNK_SIZE, prev->len - offs);
+
+  if(SRW_XORBlock(out_chunk, prev->data + offs, cur->data + offs, clen))
+  {
+   out[i >> 3] |= 1 << (i & 7);
+   out_chunk += clen;
+  }
+ }
+
+ return(out_chunk - out);
+}
+
+// XORs a packed delta into "st", turning it into the state that was one frame earlier.
+static void SRW_ApplyDelta(StateMem *st, const uint8 *packed, uint32 uncompressed_len)
+{
+ const uint32 num_chunks = (uncompressed_len + SRW_CHUNK_SIZE - 1) / SRW_CHUNK_SIZE;
+ const uint8 *in_chunk = packed + (num_chunks + 7) / 8;
+
+ SRW_PadState(st, uncompressed_len);
+
+ for(uint32 i = 0; i < num_chunks; i++)
+ {
+  if(packed[i >> 3] & (1 << (i & 7)))
+  {
+   const uint32 offs = i * SRW_CHUNK_SIZE;
+   const uint32 clen = std::min<uint32>(SRW_CHUNK_SIZE, uncompressed_len - offs);
+
+   SRW_XORBlock(st->data + offs, st->data + offs, in_chunk, clen);
+   in_chunk += clen;
+  }
+ }
+
+ st->len = uncompressed_len;
+ st->loc = 0;
+}
+
+static void SRW_DropOldest(void)
+{
+ const int32 slot = SRW_Oldest;
+
+ bcs[slot].compressed_len = 0;
+ bcs[slot].packed_len = 0;
+ bcs[slot].uncompressed_len = 0;
+
+ if(slot == SRW_Newest)
+  SRW_Oldest = SRW_Newest = -1;
+ else
+  SRW_Oldest = (slot + 1) % SRW_NUM;
+}
+
+// Deltas can only be dropped oldest-first(each one is relative to the one after it), so find the newest delta overlapping the space
+// we want and drop everything up to and including it.
+static uint32 SRW_ArenaAlloc(uint32 len)
+{
+ uint32 pos = SRW_ArenaHead;
+
+ if((pos + len) > SRW_ArenaSize)
+  pos = 0;
+
+ if(SRW_Oldest >= 0)
+ {
+  int32 last_overlap = -1;
+
+  for(int32 s = SRW_Oldest; ; s = (s + 1) % SRW_NUM)
+  {
+   if(bcs[s].arena_pos < (pos + len) && pos < (bcs[s].arena_pos + bcs[s].compressed_len))
+    last_overlap = s;
+
+   if(s == SRW_Newest)
+    break;
+  }
+
+  if(last_overlap >= 0)
+  {
+   bool done;
+
+   do
+   {
+    done = (SRW_Oldest == last_overlap);
+    SRW_DropOldest();
+   } while(!done);
+  }
+ }
+
+ SRW_ArenaHead = pos + len;
+
+ return(pos);
+}
+
+static void SRW_Compress(const SRWJob &job)
+{
+ const uint32 src_len = job.packed_len;
+ uint32 dst_len = 0;
+
+ // The slot after this one holds the new current state; if there's still a delta there, it's the oldest one and is no longer needed.
+ if(bcs[(job.slot + 1) % SRW_NUM].uncompressed_len)
+  SRW_DropOldest();
+
+ if(SRW_CompBuf.size() < (src_len + src_len / 8 + 1024))
+  SRW_CompBuf.resize(src_len + src_len / 8 + 1024);
+
+ if(SRWCompressor == SRW_COMPRESSOR_QUICKLZ)
+ {
+  dst_len = qlz_compress(job.packed, (char*)&SRW_CompBuf[0], src_len, qlz_scratch_compress);
+ }
+ else if(SRWCompressor == SRW_COMPRESSOR_MINILZO)
+ {
+  static uint8 workmem[LZO1X_1_MEM_COMPRESS];
+  lzo_uint lzo_dst_len = SRW_CompBuf.size();
+
+  lzo1x_1_compress(job.packed, src_len, &SRW_CompBuf[0], &lzo_dst_len, workmem);
+  dst_len = lzo_dst_len;
+ }
+ else if(SRWCompressor == SRW_COMPRESSOR_BLZ)
+ {
+  static blz_pack_t workmem;
+
+  dst_len = blz_pack(job.packed, src_len, &SRW_CompBuf[0], &workmem);
+ }
+
+ if(dst_len > SRW_ArenaSize)
+ {
+  while(SRW_Oldest >= 0)
+   SRW_DropOldest();
+
+  return;
+ }
+
+ const uint32 pos = SRW_ArenaAlloc(dst_len);
+
+ memcpy(SRW_Arena + pos, &SRW_CompBuf[0], dst_len);
+
+ bcs[job.slot].arena_pos = pos;
+ bcs[job.slot].compressed_len = dst_len;
+ bcs[job.slot].packed_len = src_len;
+ bcs[job.slot].uncompressed_len = job.uncompressed_len;
+
+ SRW_Newest = job.slot;
+ if(SRW_Oldest < 0)
+  SRW_Oldest = job.slot;
+}
+
+static int SRW_ThreadEntry(void *data)
+{
+ for(;;)
+ {
+  if(!SRW_Queue->CanRead())
+   SRW_Queue->WaitCanRead();
+
+  const SRWJob job = *SRW_Queue->ReadPtr();
+
+  if(job.slot < 0)
+  {
+   SRW_Queue->ReadCommit();
+   break;
+  }
+
+  SRW_Compress(job);
+  SRW_Queue->ReadCommit();
+ }
+
+ return(0);
+}
+
+static void SRW_Fence(void)
+{
+ if(SRW_Queue)
+  SRW_Queue->WaitEmpty();
+}
+
 void MDFN_StateEvilBegin(void)
 {
- int x;
  std::string srwcompstring;
 
 
@@ -1054,15 +1343,28 @@ void MDFN_StateEvilBegin(void)
  else if(srwcompstring == "blz")
   SRWCompressor = SRW_COMPRESSOR_BLZ;
 
+ SRW_ArenaSize = MDFN_GetSettingUI("srwmemory") << 20;
+ if(!(SRW_Arena = (uint8 *)malloc(SRW_ArenaSize)))
+ {
+  MDFN_PrintError(_("Unable to allocate %u bytes for state rewinding."), SRW_ArenaSize);
+  EvilEnabled = 0;
+  return;
+ }
+ SRW_ArenaHead = 0;
+ SRW_Oldest = SRW_Newest = -1;
+
  bcs = (StateMemPacket *)calloc(SRW_NUM, sizeof(StateMemPacket));
  bcspos = 0;
 
- for(x=0;x<SRW_NUM;x++)
+ memset(&SRW_Cur, 0, sizeof(StateMem));
+ memset(&SRW_Prev, 0, sizeof(StateMem));
+ SRW_PackBufIndex = 0;
+
+ SRW_Queue = new SPSCQueue<SRWJob>(SRW_NUM_PACKBUFS);
+ if(!(SRW_Thread = MDFND_CreateThread(SRW_ThreadEntry, NULL)))
  {
-  bcs[x].data = NULL;
-  bcs[x].compressed_len = 0;
-  bcs[x].uncompressed_len = 0;
-  memset(&bcs[x].MovieLove, 0, sizeof(StateMem));
+  delete SRW_Queue;
+  SRW_Queue = NULL;
  }
 }
 
@@ -1073,26 +1375,63 @@ bool MDFN_StateEvilIsRunning(void)
 
 void MDFN_StateEvilEnd(void)
 {
- int x;
-
  if(!EvilEnabled)
   return;
 
+ if(SRW_Thread)
+ {
+  SRWJob *job;
+
+  if(!SRW_Queue->CanWrite())
+   SRW_Queue->WaitCanWrite();
+
+  job = SRW_Queue->WritePtr();
+  job->slot = -1;
+  SRW_Queue->WriteCommit();
+
+  MDFND_WaitThread(SRW_Thread, NULL);
+  SRW_Thread = NULL;
+ }
+
+ if(SRW_Queue)
+ {
+  delete SRW_Queue;
+  SRW_Queue = NULL;
+ }
+
  if(bcs)
  {
   if(MDFNMOV_IsRecording())
    MDFN_StateEvilFlushMovieLove();
 
-  for(x = 0;x < SRW_NUM; x++)
+  for(int x = 0; x < SRW_NUM; x++)
   {
-
-   if(bcs[x].data)
-    free(bcs[x].data);
-   bcs[x].data = NULL;
-   bcs[x].compressed_len = 0;
+   if(bcs[x].MovieLove.data)
+    free(bcs[x].MovieLove.data);
   }
   free(bcs);
+  bcs = NULL;
  }
+
+ if(SRW_Arena)
+ {
+  free(SRW_Arena);
+  SRW_Arena = NULL;
+ }
+
+ if(SRW_Cur.data)
+  free(SRW_Cur.data);
+ memset(&SRW_Cur, 0, sizeof(StateMem));
+
+ if(SRW_Prev.data)
+  free(SRW_Prev.data);
+ memset(&SRW_Prev, 0, sizeof(StateMem));
+
+ for(unsigned i = 0; i < SRW_NUM_PACKBUFS; i++)
+  std::vector<uint8>().swap(SRW_PackBuf[i]);
+
+ std::vector<uint8>().swap(SRW_UnpackBuf);
+ std::vector<uint8>().swap(SRW_CompBuf);
 }
 
 void MDFN_StateEvilFlushMovieLove(void)
@@ -1102,8 +1441,7 @@ void MDFN_StateEvilFlushMovieLove(void)
  {
   if(bcs[bahpos].MovieLove.data)
   {
-   if(bcs[x].data)
-    MDFNMOV_ForceRecord(&bcs[bahpos].MovieLove);
+   MDFNMOV_ForceRecord(&bcs[bahpos].MovieLove);
    free(bcs[bahpos].MovieLove.data);
    bcs[bahpos].MovieLove.data = NULL;
   }
@@ -1118,146 +1456,116 @@ int MDFN_StateEvil(int rewind)
 
  if(rewind)
  {
-  int32 next_bcspos = bcspos;
-  bool NeedDataFlush = FALSE;
+  const int32 prev_bcspos = (bcspos + SRW_NUM - 1) % SRW_NUM;
 
-  bcspos--;
-  if(bcspos < 0) bcspos += SRW_NUM;
+  SRW_Fence();
 
-  if(!bcs[bcspos].data)
-   bcspos = (bcspos + 1) % SRW_NUM;
-  else
-   NeedDataFlush = TRUE;
+  // Out of history(or haven't saved anything yet); hold at the oldest state we have.
+  if(SRW_Newest != prev_bcspos)
+  {
+   if(!SRW_Cur.len)
+    return(0);
+
+   SRW_Cur.loc = 0;
+   MDFNSS_LoadSM(&SRW_Cur, 0, 1);
+
+   free(MDFNMOV_GrabRewindJoy().data);
+   return(1);
+  }
 
-  if(bcs[bcspos].compressed_len)
   {
-   uint8 *tmp_buf;
-   lzo_uint dst_len = bcs[bcspos].uncompressed_len;
+   StateMemPacket *p = &bcs[prev_bcspos];
+   const uint8 *src = SRW_Arena + p->arena_pos;
+   lzo_uint dst_len = p->packed_len;
 
-   tmp_buf = (uint8 *)malloc(bcs[bcspos].uncompressed_len);
+   if(SRW_UnpackBuf.size() < (p->packed_len + 1024))
+    SRW_UnpackBuf.resize(p->packed_len + 1024);
 
    if(SRWCompressor == SRW_COMPRESSOR_QUICKLZ)
-    dst_len = qlz_decompress((char*)bcs[bcspos].data, tmp_buf, qlz_scratch_decompress);
+    dst_len = qlz_decompress((const char*)src, &SRW_UnpackBuf[0], qlz_scratch_decompress);
    else if(SRWCompressor == SRW_COMPRESSOR_MINILZO)
-    lzo1x_decompress(bcs[bcspos].data, bcs[bcspos].compressed_len, tmp_buf, &dst_len, NULL);
+    lzo1x_decompress(src, p->compressed_len, &SRW_UnpackBuf[0], &dst_len, NULL);
    else if(SRWCompressor == SRW_COMPRESSOR_BLZ)
    {
-    dst_len = blz_unpack(bcs[bcspos].data, tmp_buf);
+    dst_len = blz_unpack(src, &SRW_UnpackBuf[0]);
    }
-   for(uint32 x = 0; x < bcs[bcspos].uncompressed_len && x < bcs[next_bcspos].uncompressed_len; x++)
-    tmp_buf[x] ^= bcs[next_bcspos].data[x];
 
-   free(bcs[bcspos].data);
-   bcs[bcspos].data = tmp_buf;
-   bcs[bcspos].compressed_len = 0;
-  }
+   SRW_ApplyDelta(&SRW_Cur, &SRW_UnpackBuf[0], p->uncompressed_len);
 
-  if(NeedDataFlush)
-  {
-   if(bcs[next_bcspos].MovieLove.data)
-   {
-    free(bcs[next_bcspos].MovieLove.data);
-    bcs[next_bcspos].MovieLove.data = NULL;
-   }
-   free(bcs[next_bcspos].data);
-   bcs[next_bcspos].data = NULL;
-   bcs[next_bcspos].compressed_len = 0;
-   bcs[next_bcspos].uncompressed_len = 0;
+   // The delta has been consumed, so its arena space can be reused right away.
+   SRW_ArenaHead = p->arena_pos;
+   p->compressed_len = 0;
+   p->packed_len = 0;
+   p->uncompressed_len = 0;
+
+   if(SRW_Oldest == prev_bcspos)
+    SRW_Oldest = SRW_Newest = -1;
+   else
+    SRW_Newest = (prev_bcspos + SRW_NUM - 1) % SRW_NUM;
   }
 
-  if(bcs[bcspos].uncompressed_len)
+  if(bcs[bcspos].MovieLove.data)
   {
-   StateMem sm;
+   free(bcs[bcspos].MovieLove.data);
+   bcs[bcspos].MovieLove.data = NULL;
+  }
 
-   sm.data = bcs[bcspos].data;
-   sm.loc = 0;
-   sm.initial_malloc = 0;
-   sm.malloced = sm.len = bcs[bcspos].uncompressed_len;
+  bcspos = prev_bcspos;
 
-   MDFNSS_LoadSM(&sm, 0, 1);
+  MDFNSS_LoadSM(&SRW_Cur, 0, 1);
 
-   free(MDFNMOV_GrabRewindJoy().data);
-   return(1);
-  }
+  free(MDFNMOV_GrabRewindJoy().data);
+  return(1);
  }
  else
  {
-  StateMem sm;
-  int32 prev_bcspos = bcspos;
-
   bcspos = (bcspos + 1) % SRW_NUM;
 
-  if(MDFNMOV_IsRecording())
-  {
-   if(bcs[bcspos].data && bcs[bcspos].MovieLove.data)
-   {
-    //printf("Force: %d\n", bcspos);
-    MDFNMOV_ForceRecord(&bcs[bcspos].MovieLove);
-    free(bcs[bcspos].MovieLove.data);
-    bcs[bcspos].MovieLove.data = NULL;
-   }
-  }
-  if(bcs[bcspos].data)
-  {
-   free(bcs[bcspos].data);
-   bcs[bcspos].data = NULL;
-  }
   if(bcs[bcspos].MovieLove.data)
   {
+   if(MDFNMOV_IsRecording())
+    MDFNMOV_ForceRecord(&bcs[bcspos].MovieLove);
+
    free(bcs[bcspos].MovieLove.data);
    bcs[bcspos].MovieLove.data = NULL;
   }
 
-  memset(&sm, 0, sizeof(sm));
-
-  MDFNSS_SaveSM(&sm, 0, 1);
+  std::swap(SRW_Prev, SRW_Cur);
+  SRW_Cur.loc = 0;
+  SRW_Cur.len = 0;
 
-  bcs[bcspos].data = sm.data;
-  bcs[bcspos].compressed_len = 0;
-  bcs[bcspos].uncompressed_len = sm.len;
+  MDFNSS_SaveSM(&SRW_Cur, 0, 1);
 
-  // Compress the previous save state.
-  if(bcs[prev_bcspos].data)
+  // Delta the previous state against this one, and hand it off for compression.
+  if(SRW_Prev.len)
   {
-   for(uint32 x = 0; x < bcs[prev_bcspos].uncompressed_len && x < sm.len; x++)
-    bcs[prev_bcspos].data[x] ^= sm.data[x];
+   SRWJob job;
+   std::vector<uint8> *pb;
 
-   if(SRWCompressor == SRW_COMPRESSOR_QUICKLZ)
-   {
-    uint32 dst_len;
-    uint8 *tmp_buf = (uint8 *)malloc(bcs[prev_bcspos].uncompressed_len + 400);
+   if(SRW_Queue && !SRW_Queue->CanWrite())
+    SRW_Queue->WaitCanWrite();
 
-    dst_len = qlz_compress(bcs[prev_bcspos].data, (char*)tmp_buf, bcs[prev_bcspos].uncompressed_len, qlz_scratch_compress);
+   // With SRW_NUM_PACKBUFS queue entries, once there's room in the queue the oldest pack buffer is free again.
+   pb = &SRW_PackBuf[SRW_PackBufIndex];
+   SRW_PackBufIndex = (SRW_PackBufIndex + 1) % SRW_NUM_PACKBUFS;
 
-    free(bcs[prev_bcspos].data);
-    bcs[prev_bcspos].data = (uint8 *)realloc(tmp_buf, dst_len);
-    bcs[prev_bcspos].compressed_len = dst_len;
-   }
-   else if(SRWCompressor == SRW_COMPRESSOR_MINILZO)
-   {
-    uint8 workmem[LZO1X_1_MEM_COMPRESS];
-    uint8 * tmp_buf = (uint8 *)malloc((size_t)(1.10 * bcs[prev_bcspos].uncompressed_len));
-    lzo_uint dst_len = (lzo_uint)(1.10 * bcs[prev_bcspos].uncompressed_len);
+   if(pb->size() < SRW_MaxPackedLen(SRW_Prev.len))
+    pb->resize(SRW_MaxPackedLen(SRW_Prev.len));
 
-    lzo1x_1_compress(bcs[prev_bcspos].data, bcs[prev_bcspos].uncompressed_len, tmp_buf, &dst_len, workmem);
+   SRW_PadState(&SRW_Cur, SRW_Prev.len);
 
-    free(bcs[prev_bcspos].data);
-    bcs[prev_bcspos].data = (uint8 *)realloc(tmp_buf, dst_len);
-    bcs[prev_bcspos].compressed_len = dst_len;
-   }
-   else if(SRWCompressor == SRW_COMPRESSOR_BLZ)
-   {
-    blz_pack_t workmem;
-
-    uint8 * tmp_buf = (uint8 *)malloc((size_t)(bcs[prev_bcspos].uncompressed_len + blz_pack_extra));
-    uint32 dst_len = bcs[prev_bcspos].uncompressed_len + blz_pack_extra;
-
-    dst_len = blz_pack(bcs[prev_bcspos].data, bcs[prev_bcspos].uncompressed_len, tmp_buf, &workmem);
+   job.slot = (bcspos + SRW_NUM - 1) % SRW_NUM;
+   job.packed = &(*pb)[0];
+   job.packed_len = SRW_PackDelta(job.packed, &SRW_Prev, &SRW_Cur);
+   job.uncompressed_len = SRW_Prev.len;
 
-    free(bcs[prev_bcspos].data);
-    bcs[prev_bcspos].data = (uint8 *)realloc(tmp_buf, dst_len);
-    bcs[prev_bcspos].compressed_len = dst_len;
+   if(SRW_Queue)
+   {
+    *SRW_Queue->WritePtr() = job;
+    SRW_Queue->WriteCommit();
    }
+   else
+    SRW_Compress(job);
   }
 
   if(MDFNMOV_IsRecording())
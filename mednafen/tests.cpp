@@ -416,6 +416,319 @@ static void RunFPTests(void)
  fptest1();
 }
 
+#include "MemoryStream.h"
+#include "cdrom/CDAccess_HCD.h"
+
+//
+// A small synthetic disc for the HCD round-trip test: a run of easily-compressed sectors, a run of noise(which HCD stores
+// uncompressed), and a sector count that leaves the last hunk partly filled.
+//
+class HCDTestDisc : public CDAccess
+{
+ public:
+
+ enum { NumSectors = 8 * 3 + 5 };
+
+ HCDTestDisc()
+ {
+  toc.first_track = 1;
+  toc.last_track = 2;
+  toc.disc_type = CDUtility::DISC_TYPE_CD_XA;
+  toc.tracks[1].adr = 1;
+  toc.tracks[1].control = CDUtility::SUBQ_CTRLF_DATA;
+  toc.tracks[1].lba = 0;
+  toc.tracks[2].adr = 1;
+  toc.tracks[2].control = 0;
+  toc.tracks[2].lba = 19;
+  toc.tracks[100].adr = 1;
+  toc.tracks[100].lba = NumSectors;
+ }
+
+ virtual void Read_Raw_Sector(uint8 *buf, int32 lba)
+ {
+  uint32 lfsr = 0x1234567 + lba;
+
+  for(unsigned i = 0; i < 2352 + 96; i++)
+  {
+   if(lba >= 8 && lba < 16)
+   {
+    lfsr = (lfsr >> 1) ^ (-(lfsr & 1) & 0xD0000001U);
+    buf[i] = lfsr;
+   }
+   else
+    buf[i] = (i < 2352) ? (i / 7) ^ lba : (i & 0x3F) ^ (lba & 0x40);
+  }
+ }
+
+ virtual void Read_TOC(CDUtility::TOC *toc_out)
+ {
+  *toc_out = toc;
+ }
+
+ virtual bool Is_Physical(void) throw()
+ {
+  return(false);
+ }
+
+ virtual void Eject(bool eject_status)
+ {
+
+ }
+
+ private:
+ CDUtility::TOC toc;
+};
+
+static bool DoHCDRoundTripTest(void)
+{
+ try
+ {
+  HCDTestDisc src;
+  MemoryStream *ms = new MemoryStream();
+  CDUtility::TOC src_toc, hcd_toc;
+
+  HCD_Write(&src, ms);
+
+  CDAccess_HCD hcd(ms);
+
+  src.Read_TOC(&src_toc);
+  hcd.Read_TOC(&hcd_toc);
+
+  if(src_toc.first_track != hcd_toc.first_track || src_toc.last_track != hcd_toc.last_track || src_toc.disc_type != hcd_toc.disc_type)
+  {
+   printf("Test failed: HCD TOC mismatch.\n");
+   return(FALSE);
+  }
+
+  for(unsigned i = 0; i < 101; i++)
+  {
+   if(src_toc.tracks[i].adr != hcd_toc.tracks[i].adr || src_toc.tracks[i].control != hcd_toc.tracks[i].control || src_toc.tracks[i].lba != hcd_toc.tracks[i].lba)
+   {
+    printf("Test failed: HCD TOC track %u mismatch.\n", i);
+    return(FALSE);
+   }
+  }
+
+  // Backwards, so hunks are also read out of order.
+  for(int32 lba = HCDTestDisc::NumSectors - 1; lba >= 0; lba--)
+  {
+   uint8 src_buf[2352 + 96];
+   uint8 hcd_buf[2352 + 96];
+
+   src.Read_Raw_Sector(src_buf, lba);
+   hcd.Read_Raw_Sector(hcd_buf, lba);
+
+   if(memcmp(src_buf, hcd_buf, sizeof(src_buf)))
+   {
+    printf("Test failed: HCD sector %d mismatch.\n", lba);
+    return(FALSE);
+   }
+  }
+ }
+ catch(std::exception &e)
+ {
+  printf("Test failed: HCD round trip: %s\n", e.what());
+  return(FALSE);
+ }
+
+ return(TRUE);
+}
+
+#ifdef WANT_PSX_EMU
+#include "psx/gte.h"
+
+//
+// GTE: the three-vertex instructions(RTPT, NCT, NCCT, NCDT) must leave every register exactly as three of the corresponding
+// single-vertex instructions(RTPS, NCS, NCCS, NCDS) on V0, V1, V2 in turn would, with FLAG the OR of theirs(RTPT only does the
+// depth cue calculation for the last vertex, so DQA/DQB are zeroed for the first two RTPS).  And MVMVA's MAC1-3 and overflow flags
+// must match a plain 44-bit accumulator.  Registers are loaded with random values, biased toward the overflow and saturation limits.
+//
+namespace GTETest
+{
+using namespace MDFN_IEN_PSX;
+
+static uint32 lfsr;
+
+static uint32 Rand(void)
+{
+ lfsr ^= lfsr << 13;
+ lfsr ^= lfsr >> 17;
+ lfsr ^= lfsr << 5;
+
+ return(lfsr);
+}
+
+static uint32 RandReg(void)
+{
+ switch(Rand() % 6)
+ {
+  default:
+  case 0: return(Rand());
+  case 1: return(Rand() & 0x0FFF0FFF);
+  case 2: return((Rand() & 1) ? 0x7FFF7FFF : 0x80008000);
+  case 3: return(0x7FF00000 + (Rand() & 0x1FF) - 0x100);	// Translation vector components around the overflow check limits.
+  case 4: return(0x80100000 + (Rand() & 0x1FF) - 0x100);
+  case 5: return(Rand() & 0x80FF80FF);
+ }
+}
+
+struct Regs
+{
+ uint32 cr[32];
+ uint32 dr[32];
+};
+
+static void LoadRegs(const Regs &r)
+{
+ for(unsigned i = 0; i < 32; i++)
+  GTE_WriteCR(i, r.cr[i]);
+
+ // SXYP(15) pushes the XY FIFO, ORGB(29) and LZCR(31) are read-only.
+ for(unsigned i = 0; i < 32; i++)
+ {
+  if(i != 15 && i != 29 && i != 31)
+   GTE_WriteDR(i, r.dr[i]);
+ }
+}
+
+static void SaveRegs(Regs *r)
+{
+ for(unsigned i = 0; i < 32; i++)
+ {
+  r->cr[i] = GTE_ReadCR(i);
+  r->dr[i] = GTE_ReadDR(i);
+ }
+}
+
+static bool CheckTriple(const Regs &start, uint32 single_op, uint32 triple_op, bool zero_dq)
+{
+ Regs triple, single;
+ uint32 flags = 0;
+
+ LoadRegs(start);
+ GTE_Instruction(triple_op);
+ SaveRegs(&triple);
+
+ LoadRegs(start);
+ for(unsigned v = 0; v < 3; v++)
+ {
+  GTE_WriteDR(0, start.dr[v * 2 + 0]);
+  GTE_WriteDR(1, start.dr[v * 2 + 1]);
+  GTE_WriteCR(27, (zero_dq && v < 2) ? 0 : start.cr[27]);
+  GTE_WriteCR(28, (zero_dq && v < 2) ? 0 : start.cr[28]);
+
+  GTE_Instruction(single_op);
+  flags |= GTE_ReadCR(31);
+ }
+ GTE_WriteDR(0, start.dr[0]);
+ GTE_WriteDR(1, start.dr[1]);
+ GTE_WriteCR(31, flags);
+ SaveRegs(&single);
+
+ for(unsigned i = 0; i < 32; i++)
+ {
+  if(triple.cr[i] != single.cr[i] || triple.dr[i] != single.dr[i])
+  {
+   printf("Test failed: GTE instruction 0x%08x, register %u: CR 0x%08x != 0x%08x, DR 0x%08x != 0x%08x\n", triple_op, i, triple.cr[i], single.cr[i], triple.dr[i], single.dr[i]);
+   return(FALSE);
+  }
+ }
+
+ return(TRUE);
+}
+
+static bool CheckMVMVA(const Regs &start, const uint32 sf)
+{
+ static const unsigned flag_shift[2] = { 30, 27 };
+ uint32 flags = 0;
+
+ LoadRegs(start);
+ GTE_Instruction(0x4A000012 | (sf << 19));	// MVMVA, rotation matrix * V0 + translation vector
+
+ for(unsigned i = 0; i < 3; i++)
+ {
+  int64 sum = (int64)(int32)start.cr[5 + i] << 12;
+
+  for(unsigned j = 0; j < 3; j++)
+  {
+   const unsigned m = i * 3 + j;
+   const int16 mx = (m & 1) ? (start.cr[m >> 1] >> 16) : start.cr[m >> 1];
+   const int16 vj = (j & 1) ? (start.dr[j >> 1] >> 16) : start.dr[j >> 1];
+
+   sum += mx * vj;
+
+   if(sum >= ((int64)1 << 43))
+    flags |= 1 << (flag_shift[0] - i);
+
+   if(sum < -((int64)1 << 43))
+    flags |= 1 << (flag_shift[1] - i);
+
+   sum = ((int64)((uint64)sum << 20)) >> 20;
+  }
+
+  if((int32)GTE_ReadDR(25 + i) != (int32)(sum >> (sf * 12)))
+  {
+   printf("Test failed: GTE MVMVA(sf=%u) MAC%u 0x%08x != 0x%08x\n", sf, i + 1, GTE_ReadDR(25 + i), (uint32)(sum >> (sf * 12)));
+   return(FALSE);
+  }
+ }
+
+ if((GTE_ReadCR(31) & 0x7E000000) != flags)
+ {
+  printf("Test failed: GTE MVMVA(sf=%u) overflow flags 0x%08x != 0x%08x\n", sf, GTE_ReadCR(31) & 0x7E000000, flags);
+  return(FALSE);
+ }
+
+ return(TRUE);
+}
+
+static bool Run(void)
+{
+ // Single, triple, whether the triple only does the depth cue calculation once.
+ static const uint32 pairs[4][3] =
+ {
+  { 0x01, 0x30, TRUE },	// RTPS, RTPT
+  { 0x1E, 0x20, FALSE },	// NCS, NCT
+  { 0x1B, 0x3F, FALSE },	// NCCS, NCCT
+  { 0x13, 0x16, FALSE },	// NCDS, NCDT
+ };
+
+ lfsr = 0x1234567;
+
+ GTE_Power();
+
+ for(unsigned iter = 0; iter < 1024; iter++)
+ {
+  Regs start;
+  const uint32 sf = iter & 1;
+  const uint32 lm = (iter >> 1) & 1;
+
+  for(unsigned i = 0; i < 32; i++)
+  {
+   start.cr[i] = RandReg();
+   start.dr[i] = RandReg();
+  }
+
+  for(unsigned p = 0; p < 4; p++)
+  {
+   const uint32 fields = 0x4A000000 | (sf << 19) | (lm << 10);
+
+   if(!CheckTriple(start, fields | pairs[p][0], fields | pairs[p][1], pairs[p][2]))
+    return(FALSE);
+  }
+
+  if(!CheckMVMVA(start, sf))
+   return(FALSE);
+ }
+
+ GTE_Power();
+
+ return(TRUE);
+}
+
+}
+#endif
+
 const char* MDFN_tests_stringA = "AB\0C";
 const char* MDFN_tests_stringB = "AB\0CD";
 const char* MDFN_tests_stringC = "AB\0X";
@@ -657,6 +970,14 @@ bool MDFN_RunMathTests(void)
  if(!DoLEPackerTest())
   return(0);
 
+ if(!DoHCDRoundTripTest())
+  return(0);
+
+ #ifdef WANT_PSX_EMU
+ if(!GTETest::Run())
+  return(0);
+ #endif
+
  assert(uilog2(0) == 0);
  assert(uilog2(1) == 0);
  assert(uilog2(3) == 1);
@@ -572,6 +572,10 @@ static int Load(const char *name, MDFNFILE *fp)
   VB_V810->SetMemWriteBus32(i, false);
  }
 
+ //
+ // WRAM, cart RAM, and cart ROM have no side effects in MemRead*()/MemWrite*() other than ROM ignoring writes, so let LD/ST instructions
+ // access them directly.
+ //
  std::vector<uint32> Map_Addresses;
 
  for(uint64 A = 0; A < 1ULL << 32; A += (1 << 27))
@@ -582,7 +586,7 @@ static int Load(const char *name, MDFNFILE *fp)
   }
  }
 
- WRAM = VB_V810->SetFastMap(&Map_Addresses[0], 65536, Map_Addresses.size(), "WRAM");
+ WRAM = VB_V810->SetFastMap(&Map_Addresses[0], 65536, Map_Addresses.size(), "WRAM", V810_FAST_MAP_DIRECT_READ | V810_FAST_MAP_DIRECT_WRITE);
  Map_Addresses.clear();
 
 
@@ -599,7 +603,7 @@ static int Load(const char *name, MDFNFILE *fp)
  }
 
 
- GPROM = VB_V810->SetFastMap(&Map_Addresses[0], GPROM_Mask + 1, Map_Addresses.size(), "Cart ROM");
+ GPROM = VB_V810->SetFastMap(&Map_Addresses[0], GPROM_Mask + 1, Map_Addresses.size(), "Cart ROM", V810_FAST_MAP_DIRECT_READ);
  Map_Addresses.clear();
 
  // Mirror ROM images < 64KiB to 64KiB
@@ -620,7 +624,7 @@ static int Load(const char *name, MDFNFILE *fp)
  }
 
 
- GPRAM = VB_V810->SetFastMap(&Map_Addresses[0], GPRAM_Mask + 1, Map_Addresses.size(), "Cart RAM");
+ GPRAM = VB_V810->SetFastMap(&Map_Addresses[0], GPRAM_Mask + 1, Map_Addresses.size(), "Cart RAM", V810_FAST_MAP_DIRECT_READ | V810_FAST_MAP_DIRECT_WRITE);
  Map_Addresses.clear();
 
  memset(GPRAM, 0, GPRAM_Mask + 1);
@@ -645,6 +649,7 @@ static int Load(const char *name, MDFNFILE *fp)
  uint32 sbs_separation = MDFN_GetSettingUI("vb.sidebyside.separation");
 
  VIP_Set3DMode(VB3DMode, MDFN_GetSettingUI("vb.3dreverse"), prescale, sbs_separation);
+ VIP_SetThreadedRender(MDFN_GetSettingB("vb.threaded_render"));
 
 
  //SettingChanged("vb.3dmode");
@@ -733,6 +738,7 @@ static void CloseGame(void)
   }
  }
  //VIP_Kill();
+ VIP_SetThreadedRender(false);
  
  if(VB_VSU)
  {
@@ -949,6 +955,8 @@ static MDFNSetting VBSettings[] =
  { "vb.3dmode", MDFNSF_NOFLAGS, gettext_noop("3D mode."), NULL, MDFNST_ENUM, "anaglyph", NULL, NULL, NULL, /*SettingChanged*/NULL, VB3DMode_List },
  { "vb.liprescale", MDFNSF_NOFLAGS, gettext_noop("Line Interlaced prescale."), NULL, MDFNST_UINT, "2", "1", "10", NULL, NULL },
 
+ { "vb.threaded_render", MDFNSF_NOFLAGS, gettext_noop("Draw the left and right eyes on separate threads."), gettext_noop("The right eye of each 8-line block is drawn by a separate render thread while the emulation thread draws the left eye.  Output is identical to non-threaded rendering.  Takes effect when a game is loaded."), MDFNST_BOOL, "0" },
+
  { "vb.disable_parallax", MDFNSF_EMU_STATE | MDFNSF_UNTRUSTED_SAFE, gettext_noop("Disable parallax for BG and OBJ rendering."), NULL, MDFNST_BOOL, "0", NULL, NULL, NULL, SettingChanged },
  { "vb.default_color", MDFNSF_NOFLAGS, gettext_noop("Default maximum-brightness color to use in non-anaglyph 3D modes."), NULL, MDFNST_UINT, "0xF0F0F0", "0x000000", "0xFFFFFF", NULL, SettingChanged },
 
@@ -17,8 +17,13 @@
 
 #include "vb.h"
 #include "vip.h"
+#include "../SPSCQueue.h"
 #include <math.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #define VIP_DBGMSG(format, ...) { }
 //#define VIP_DBGMSG(format, ...) printf(format "\n", ## __VA_ARGS__)
 
@@ -76,13 +81,20 @@ static uint16 InterruptEnable;
 static uint8 BRTA, BRTB, BRTC, REST;
 static uint8 Repeat;
 
-static void CopyFBColumnToTarget_Anaglyph(void) NO_INLINE;
+static void CopyFBColumnsToTarget_Anaglyph(int32 first, int32 count) NO_INLINE;
 static void CopyFBColumnToTarget_AnaglyphSlow(void) NO_INLINE;
 static void CopyFBColumnToTarget_CScope(void) NO_INLINE;
-static void CopyFBColumnToTarget_SideBySide(void) NO_INLINE;
+static void CopyFBColumnsToTarget_SideBySide(int32 first, int32 count) NO_INLINE;
 static void CopyFBColumnToTarget_VLI(void) NO_INLINE;
 static void CopyFBColumnToTarget_HLI(void) NO_INLINE;
 static void (*CopyFBColumnToTarget)(void) = NULL;
+
+// Modes that write each output row contiguously copy 4 columns at a time, when the last column of each group of 4 is scanned out(the
+// brightness only changes every 4 columns).  Anything that would change how an already-scanned column looks(a framebuffer write, a
+// brightness register write) must call FlushPendingColumns() first.
+static void (*CopyFBColumnsToTarget)(int32 first, int32 count) = NULL;
+static int32 PendingColumns;
+static void FlushPendingColumns(void);
 static uint32 VB3DMode;
 static uint32 VB3DReverse;
 static uint32 VBPrescale;
@@ -171,6 +183,8 @@ static void MakeColorLUT(const MDFN_PixelFormat &format)
 
 static void RecalcBrightnessCache(void)
 {
+ FlushPendingColumns();
+
  //printf("BRTA: %d, BRTB: %d, BRTC: %d, Rest: %d\n", BRTA, BRTB, BRTC, REST);
  int32 CumulativeTime = (BRTA + 1 + BRTB + 1 + BRTC + 1 + REST + 1) + 1;
  int32 MaxTime = 128;
@@ -244,25 +258,33 @@ static void Recalc3DModeStuff(bool non_rgb_output = false)
 		non_rgb_output)
 	   {
             CopyFBColumnToTarget = CopyFBColumnToTarget_AnaglyphSlow;
+            CopyFBColumnsToTarget = NULL;
 	   }
            else
-            CopyFBColumnToTarget = CopyFBColumnToTarget_Anaglyph;
+	   {
+            CopyFBColumnToTarget = NULL;
+            CopyFBColumnsToTarget = CopyFBColumnsToTarget_Anaglyph;
+	   }
            break;
 
   case VB3DMODE_CSCOPE:
            CopyFBColumnToTarget = CopyFBColumnToTarget_CScope;
+           CopyFBColumnsToTarget = NULL;
            break;
 
   case VB3DMODE_SIDEBYSIDE:
-           CopyFBColumnToTarget = CopyFBColumnToTarget_SideBySide;
+           CopyFBColumnToTarget = NULL;
+           CopyFBColumnsToTarget = CopyFBColumnsToTarget_SideBySide;
            break;
 
   case VB3DMODE_VLI:
            CopyFBColumnToTarget = CopyFBColumnToTarget_VLI;
+           CopyFBColumnsToTarget = NULL;
            break;
 
   case VB3DMODE_HLI:
            CopyFBColumnToTarget = CopyFBColumnToTarget_HLI;
+           CopyFBColumnsToTarget = NULL;
            break;
  }
  RecalcBrightnessCache();
@@ -378,6 +400,15 @@ static int32 ColumnCounter;
 static int32 DisplayRegion;
 static bool DisplayFB;
 
+static void FlushPendingColumns(void)
+{
+ if(PendingColumns)
+ {
+  CopyFBColumnsToTarget(Column - PendingColumns, PendingColumns);
+  PendingColumns = 0;
+ }
+}
+
 static int32 GameFrameCounter;
 
 static int32 DrawingCounter;
@@ -430,6 +461,7 @@ void VIP_Power(void)
 
  Column = 0;
  ColumnCounter = 259;
+ PendingColumns = 0;
 
  DisplayRegion = 0;
  DisplayFB = 0;
@@ -787,7 +819,12 @@ void VIP_Write8(int32 &timestamp, uint32 A, uint8 V)
 	   if((A & 0x7FFF) >= 0x6000)
 	    VIP_MA16W8(CHR_RAM, (A & 0x1FFF) | ((A >> 2) & 0x6000), V);
 	   else
+	   {
+	    if(PendingColumns && ((A >> 15) & 1) == DisplayFB)
+	     FlushPendingColumns();
+
 	    FB[(A >> 15) & 1][(A >> 16) & 1][A & 0x7FFF] = V;
+	   }
 	   break;
 
   case 0x2:
@@ -831,7 +868,12 @@ void VIP_Write16(int32 &timestamp, uint32 A, uint16 V)
            if((A & 0x7FFF) >= 0x6000)
             VIP_MA16W16(CHR_RAM, (A & 0x1FFF) | ((A >> 2) & 0x6000), V);
            else
+	   {
+	    if(PendingColumns && ((A >> 15) & 1) == DisplayFB)
+	     FlushPendingColumns();
+
             StoreU16_LE((uint16 *)&FB[(A >> 15) & 1][(A >> 16) & 1][A & 0x7FFF], V);
+	   }
            break;
 
   case 0x2:
@@ -926,12 +968,201 @@ static int32 CalcNextEvent(void)
 
 #include "vip_draw.inc"
 
-static INLINE void CopyFBColumnToTarget_Anaglyph_BASE(const bool DisplayActive_arg, const int lr)
+// Packs an 8-line block of 2-bit pixels, one byte per pixel(as drawn by VIP_DrawBlock()), into the column-major framebuffer format.
+static void PackBlockToFB(uint8 *FB_Target, const uint8 *source)
 {
-     const int fb = DisplayFB;
-     uint32 *target = surface->pixels + Column;
-     const int32 pitch32 = surface->pitch32;
-     const uint8 *fb_source = &FB[fb][lr][64 * Column];
+ int x = 0;
+
+#if defined(__SSE2__)
+ // Pixel values are all < 4, so 16-bit lane shifts can't carry into the neighboring byte.
+ for(; x < 384; x += 16)
+ {
+  MDFN_ALIGN(16) uint16 pairs[16];
+  __m128i lo, hi;
+
+  lo = _mm_or_si128(_mm_or_si128(_mm_loadu_si128((const __m128i *)&source[x + 512 * 0]), _mm_slli_epi16(_mm_loadu_si128((const __m128i *)&source[x + 512 * 1]), 2)),
+		    _mm_or_si128(_mm_slli_epi16(_mm_loadu_si128((const __m128i *)&source[x + 512 * 2]), 4), _mm_slli_epi16(_mm_loadu_si128((const __m128i *)&source[x + 512 * 3]), 6)));
+
+  hi = _mm_or_si128(_mm_or_si128(_mm_loadu_si128((const __m128i *)&source[x + 512 * 4]), _mm_slli_epi16(_mm_loadu_si128((const __m128i *)&source[x + 512 * 5]), 2)),
+		    _mm_or_si128(_mm_slli_epi16(_mm_loadu_si128((const __m128i *)&source[x + 512 * 6]), 4), _mm_slli_epi16(_mm_loadu_si128((const __m128i *)&source[x + 512 * 7]), 6)));
+
+  _mm_store_si128((__m128i *)&pairs[0], _mm_unpacklo_epi8(lo, hi));
+  _mm_store_si128((__m128i *)&pairs[8], _mm_unpackhi_epi8(lo, hi));
+
+  for(int i = 0; i < 16; i++)
+   StoreU16_LE((uint16 *)&FB_Target[64 * (x + i)], pairs[i]);
+ }
+#endif
+
+ for(; x < 384; x++)
+ {
+  FB_Target[64 * x + 0] = (source[x + 512 * 0] << 0)
+			  | (source[x + 512 * 1] << 2)
+			  | (source[x + 512 * 2] << 4)
+			  | (source[x + 512 * 3] << 6);
+
+  FB_Target[64 * x + 1] = (source[x + 512 * 4] << 0) 
+                          | (source[x + 512 * 5] << 2)
+                          | (source[x + 512 * 6] << 4) 
+                          | (source[x + 512 * 7] << 6);
+ }
+}
+
+static void DrawEyeBlock(uint32 block, uint32 fb, int lr)
+{
+ MDFN_ALIGN(8) uint8 DrawingBuffer[512 * 8];	// Don't decrease this from 512 unless you adjust vip_draw.inc(including areas that draw off-visible >= 384 and >= -7 for speed reasons)
+
+ VIP_DrawBlock(block, DrawingBuffer + 8, lr);
+ PackBlockToFB(FB[fb][lr] + block * 2, DrawingBuffer + 8);
+}
+
+//
+// With "vb.threaded_render" enabled, the right eye of each 8-line block is drawn on a separate thread while the emulation thread draws
+// the left eye.  The eyes only read VIP memory and registers, and each writes to its own framebuffer; VIP_Update() waits for the right
+// eye to finish before doing anything else, so nothing can change underneath the render thread, and nothing sees a half-drawn block.
+//
+struct EyeRenderCmd
+{
+ uint32 block;
+ uint32 fb;	// ~0U to end the thread.
+};
+
+static SPSCQueue<EyeRenderCmd> *EyeQueue = NULL;
+static MDFN_Thread *EyeThread = NULL;
+
+static int EyeThreadStart(void *arg)
+{
+ for(;;)
+ {
+  EyeRenderCmd *cmd;
+
+  if(!EyeQueue->CanRead())
+   EyeQueue->WaitCanRead();
+
+  cmd = EyeQueue->ReadPtr();
+
+  if(cmd->fb == ~0U)
+  {
+   EyeQueue->ReadCommit();
+   break;
+  }
+
+  DrawEyeBlock(cmd->block, cmd->fb, 1);
+  EyeQueue->ReadCommit();
+ }
+
+ return(0);
+}
+
+void VIP_SetThreadedRender(bool threaded)
+{
+ if(EyeThread)
+ {
+  EyeRenderCmd *cmd;
+
+  if(!EyeQueue->CanWrite())
+   EyeQueue->WaitCanWrite();
+
+  cmd = EyeQueue->WritePtr();
+  cmd->block = 0;
+  cmd->fb = ~0U;
+  EyeQueue->WriteCommit();
+
+  MDFND_WaitThread(EyeThread, NULL);
+  EyeThread = NULL;
+ }
+
+ if(EyeQueue)
+ {
+  delete EyeQueue;
+  EyeQueue = NULL;
+ }
+
+ if(threaded)
+ {
+  EyeQueue = new SPSCQueue<EyeRenderCmd>(4);
+
+  if(!(EyeThread = MDFND_CreateThread(EyeThreadStart, NULL)))
+  {
+   MDFN_printf(_("Error creating VIP render thread; falling back to non-threaded rendering.\n"));
+
+   delete EyeQueue;
+   EyeQueue = NULL;
+  }
+ }
+}
+
+#if defined(__SSE2__)
+// Copies 4 adjacent columns.  The bytes(4 lines each) of the columns are transposed in registers so that each output line is a
+// single 4-pixel store.
+static INLINE void Copy4FBColumnsToTarget_SSE2(const bool DisplayActive_arg, const bool blend, uint32 *target, const int32 pitch32, const uint8 *fb_source, const uint32 *clut)
+{
+ const __m128i zero = _mm_setzero_si128();
+ const __m128i one = _mm_set1_epi32(1);
+ const __m128i two = _mm_set1_epi32(2);
+ const __m128i c0 = _mm_set1_epi32(clut[0]);
+ const __m128i c2 = _mm_set1_epi32(clut[2]);
+ const __m128i c01 = _mm_set1_epi32(clut[0] ^ clut[1]);
+ const __m128i c23 = _mm_set1_epi32(clut[2] ^ clut[3]);
+
+ if(!DisplayActive_arg && blend)
+  return;
+
+ for(int y = 0; y < 56; y += 8)
+ {
+  const __m128i ab = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)&fb_source[64 * 0 + y]), _mm_loadl_epi64((const __m128i *)&fb_source[64 * 1 + y]));
+  const __m128i cd = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)&fb_source[64 * 2 + y]), _mm_loadl_epi64((const __m128i *)&fb_source[64 * 3 + y]));
+  const __m128i abcd[2] = { _mm_unpacklo_epi16(ab, cd), _mm_unpackhi_epi16(ab, cd) };	// 4 columns' bytes per 32-bit lane
+
+  for(int y_byte = 0; y_byte < 8; y_byte++)
+  {
+   const __m128i bytes = (y_byte & 2) ? _mm_unpackhi_epi8(abcd[y_byte >> 2], zero) : _mm_unpacklo_epi8(abcd[y_byte >> 2], zero);
+   __m128i source_bits = (y_byte & 1) ? _mm_unpackhi_epi16(bytes, zero) : _mm_unpacklo_epi16(bytes, zero);
+
+   for(int y_sub = 4; y_sub; y_sub--)
+   {
+    __m128i pixels = zero;
+
+    if(DisplayActive_arg)
+    {
+     const __m128i bit0 = _mm_cmpeq_epi32(_mm_and_si128(source_bits, one), one);
+     const __m128i bit1 = _mm_cmpeq_epi32(_mm_and_si128(source_bits, two), two);
+     const __m128i lo = _mm_xor_si128(c0, _mm_and_si128(c01, bit0));
+     const __m128i hi = _mm_xor_si128(c2, _mm_and_si128(c23, bit0));
+
+     pixels = _mm_xor_si128(lo, _mm_and_si128(_mm_xor_si128(lo, hi), bit1));
+    }
+
+    if(blend)
+     pixels = _mm_or_si128(pixels, _mm_loadu_si128((__m128i *)target));
+
+    _mm_storeu_si128((__m128i *)target, pixels);
+
+    source_bits = _mm_srli_epi32(source_bits, 2);
+    target += pitch32;
+   }
+  }
+ }
+}
+#endif
+
+static INLINE void CopyFBColumnsToTarget_Anaglyph_BASE(const bool DisplayActive_arg, const int lr, const int32 first, const int32 count)
+{
+ const int fb = DisplayFB;
+ const int32 pitch32 = surface->pitch32;
+
+ #if defined(__SSE2__)
+ if(count == 4)
+ {
+  Copy4FBColumnsToTarget_SSE2(DisplayActive_arg, lr, surface->pixels + first, pitch32, &FB[fb][lr][64 * first], BrightCLUT[lr]);
+  return;
+ }
+ #endif
+
+ for(int32 column = first; column < first + count; column++)
+ {
+     uint32 *target = surface->pixels + column;
+     const uint8 *fb_source = &FB[fb][lr][64 * column];
 
      for(int y = 56; y; y--)
      {
@@ -954,25 +1185,26 @@ static INLINE void CopyFBColumnToTarget_Anaglyph_BASE(const bool DisplayActive_a
       }
       fb_source++;
      }
+ }
 }
 
-static void CopyFBColumnToTarget_Anaglyph(void)
+static void CopyFBColumnsToTarget_Anaglyph(int32 first, int32 count)
 {
  const int lr = (DisplayRegion & 2) >> 1;
 
  if(!DisplayActive)
  {
   if(!lr)
-   CopyFBColumnToTarget_Anaglyph_BASE(0, 0);
+   CopyFBColumnsToTarget_Anaglyph_BASE(0, 0, first, count);
   else
-   CopyFBColumnToTarget_Anaglyph_BASE(0, 1);
+   CopyFBColumnsToTarget_Anaglyph_BASE(0, 1, first, count);
  }
  else
  {
   if(!lr)
-   CopyFBColumnToTarget_Anaglyph_BASE(1, 0);
+   CopyFBColumnsToTarget_Anaglyph_BASE(1, 0, first, count);
   else
-   CopyFBColumnToTarget_Anaglyph_BASE(1, 1);
+   CopyFBColumnsToTarget_Anaglyph_BASE(1, 1, first, count);
  }
 }
 
@@ -1099,12 +1331,23 @@ static void CopyFBColumnToTarget_CScope(void)
  }
 }
 
-static void CopyFBColumnToTarget_SideBySide_BASE(const bool DisplayActive_arg, const int lr, const int dest_lr)
+static INLINE void CopyFBColumnsToTarget_SideBySide_BASE(const bool DisplayActive_arg, const int lr, const int dest_lr, const int32 first, const int32 count)
 {
-     const int fb = DisplayFB;
-     uint32 *target = surface->pixels + Column + (dest_lr ? (384 + VBSBS_Separation) : 0);
-     const int32 pitch32 = surface->pitch32;
-     const uint8 *fb_source = &FB[fb][lr][64 * Column];
+ const int fb = DisplayFB;
+ const int32 pitch32 = surface->pitch32;
+
+ #if defined(__SSE2__)
+ if(count == 4)
+ {
+  Copy4FBColumnsToTarget_SSE2(DisplayActive_arg, false, surface->pixels + first + (dest_lr ? (384 + VBSBS_Separation) : 0), pitch32, &FB[fb][lr][64 * first], BrightCLUT[lr]);
+  return;
+ }
+ #endif
+
+ for(int32 column = first; column < first + count; column++)
+ {
+     uint32 *target = surface->pixels + column + (dest_lr ? (384 + VBSBS_Separation) : 0);
+     const uint8 *fb_source = &FB[fb][lr][64 * column];
 
      for(int y = 56; y; y--)
      {
@@ -1121,25 +1364,26 @@ static void CopyFBColumnToTarget_SideBySide_BASE(const bool DisplayActive_arg, c
       }
       fb_source++;
      }
+ }
 }
 
-static void CopyFBColumnToTarget_SideBySide(void)
+static void CopyFBColumnsToTarget_SideBySide(int32 first, int32 count)
 {
  const int lr = (DisplayRegion & 2) >> 1;
 
  if(!DisplayActive)
  {
   if(!lr)
-   CopyFBColumnToTarget_SideBySide_BASE(0, 0, 0 ^ VB3DReverse);
+   CopyFBColumnsToTarget_SideBySide_BASE(0, 0, 0 ^ VB3DReverse, first, count);
   else
-   CopyFBColumnToTarget_SideBySide_BASE(0, 1, 1 ^ VB3DReverse);
+   CopyFBColumnsToTarget_SideBySide_BASE(0, 1, 1 ^ VB3DReverse, first, count);
  }
  else
  {
   if(!lr)
-   CopyFBColumnToTarget_SideBySide_BASE(1, 0, 0 ^ VB3DReverse);
+   CopyFBColumnsToTarget_SideBySide_BASE(1, 0, 0 ^ VB3DReverse, first, count);
   else
-   CopyFBColumnToTarget_SideBySide_BASE(1, 1, 1 ^ VB3DReverse);
+   CopyFBColumnsToTarget_SideBySide_BASE(1, 1, 1 ^ VB3DReverse, first, count);
  }
 }
 
@@ -1282,8 +1526,6 @@ v810_timestamp_t MDFN_FASTCALL VIP_Update(const v810_timestamp_t timestamp)
    DrawingCounter -= chunk_clocks;
    if(DrawingCounter <= 0)
    {
-    MDFN_ALIGN(8) uint8 DrawingBuffers[2][512 * 8];	// Don't decrease this from 512 unless you adjust vip_draw.inc(including areas that draw off-visible >= 384 and >= -7 for speed reasons)
-
     if(skip && InstantDisplayHack && AllowDrawSkip)
     {
 #if 0
@@ -1300,25 +1542,22 @@ v810_timestamp_t MDFN_FASTCALL VIP_Update(const v810_timestamp_t timestamp)
     }
     else
     {
-     VIP_DrawBlock(DrawingBlock, DrawingBuffers[0] + 8, DrawingBuffers[1] + 8);
-
-     for(int lr = 0; lr < 2; lr++)
+     if(EyeThread)
      {
-      uint8 *FB_Target = FB[DrawingFB][lr] + DrawingBlock * 2;
+      EyeRenderCmd *cmd = EyeQueue->WritePtr();	// Always room, since we wait for the queue to empty below.
 
-      for(int x = 0; x < 384; x++)
-      {
-       FB_Target[64 * x + 0] = (DrawingBuffers[lr][8 + x + 512 * 0] << 0)
-				  | (DrawingBuffers[lr][8 + x + 512 * 1] << 2)
-				  | (DrawingBuffers[lr][8 + x + 512 * 2] << 4)
-				  | (DrawingBuffers[lr][8 + x + 512 * 3] << 6);
+      cmd->block = DrawingBlock;
+      cmd->fb = DrawingFB;
+      EyeQueue->WriteCommit();
 
-       FB_Target[64 * x + 1] = (DrawingBuffers[lr][8 + x + 512 * 4] << 0) 
-                                  | (DrawingBuffers[lr][8 + x + 512 * 5] << 2)
-                                  | (DrawingBuffers[lr][8 + x + 512 * 6] << 4) 
-                                  | (DrawingBuffers[lr][8 + x + 512 * 7] << 6);
+      DrawEyeBlock(DrawingBlock, DrawingFB, 0);
 
-      }
+      EyeQueue->WaitEmpty();
+     }
+     else
+     {
+      DrawEyeBlock(DrawingBlock, DrawingFB, 0);
+      DrawEyeBlock(DrawingBlock, DrawingFB, 1);
      }
     }
 
@@ -1355,7 +1594,19 @@ v810_timestamp_t MDFN_FASTCALL VIP_Update(const v810_timestamp_t timestamp)
      }
     }
     if(!skip && !InstantDisplayHack)
-     CopyFBColumnToTarget();
+    {
+     if(CopyFBColumnsToTarget)
+     {
+      PendingColumns++;
+      if((Column & 3) == 3)
+      {
+       CopyFBColumnsToTarget(Column + 1 - PendingColumns, PendingColumns);
+       PendingColumns = 0;
+      }
+     }
+     else
+      CopyFBColumnToTarget();
+    }
    }
 
    ColumnCounter = 259;
@@ -1428,9 +1679,13 @@ v810_timestamp_t MDFN_FASTCALL VIP_Update(const v810_timestamp_t timestamp)
 	    Repeat = ctdata >> 8;
 	    RecalcBrightnessCache();
 	   }
+
+	   if(CopyFBColumnsToTarget)
+	    CopyFBColumnsToTarget(Column, 4);
 	  }
 
-          CopyFBColumnToTarget();
+	  if(!CopyFBColumnsToTarget)
+           CopyFBColumnToTarget();
 	 }
 	}
 	DisplayRegion = save_DisplayRegion;
@@ -1507,6 +1762,8 @@ int VIP_StateAction(StateMem *sm, int load, int data_only)
 
  if(load)
  {
+  PendingColumns = 0;
+  BKCOL &= 0x3;
   RecalcBrightnessCache();
   for(int i = 0; i < 4; i++)
   {